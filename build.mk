@@ -34,6 +34,68 @@ endif
 ifneq ($(NO_FIRMWARE),)
 CPPFLAGS+=-DNO_FIRMWARE=y
 endif
+ifneq ($(NR_CPUS),)
+CPPFLAGS+=-DNR_CPUS=$(NR_CPUS)
+endif
+ifneq ($(FAST_BOOT),)
+CPPFLAGS+=-DFAST_BOOT
+endif
+ifneq ($(BOOT_STATS),)
+CPPFLAGS+=-DBOOT_STATS
+endif
+ifneq ($(SHMEM_CONSOLE_BASE),)
+CPPFLAGS+=-DSHMEM_CONSOLE_BASE=$(SHMEM_CONSOLE_BASE)
+endif
+ifneq ($(SHMEM_CONSOLE_SIZE),)
+CPPFLAGS+=-DSHMEM_CONSOLE_SIZE=$(SHMEM_CONSOLE_SIZE)
+endif
+ifneq ($(SHMEM_CONSOLE_IPC),)
+CPPFLAGS+=-DSHMEM_CONSOLE_IPC=$(SHMEM_CONSOLE_IPC)
+endif
+# The arch optimized string routines replace the libc ones unless disabled
+# with ARCH_STRING=n, e.g. to benchmark them against newlib
+ARCH_STRING?=y
+ifeq ($(ARCH_STRING),y)
+CPPFLAGS+=-DARCH_STRING
+endif
+# Built-in allocation-free printf family, replaces the newlib one unless
+# disabled with CORE_PRINTF=n. PRINTF_FLOAT=y adds %f support.
+CORE_PRINTF?=y
+ifeq ($(CORE_PRINTF),y)
+CPPFLAGS+=-DCORE_PRINTF
+endif
+ifneq ($(PRINTF_FLOAT),)
+CPPFLAGS+=-DPRINTF_FLOAT
+endif
+ifneq ($(BENCH),)
+CPPFLAGS+=-DBENCH
+endif
+# Preemptive fixed-priority thread scheduler, see src/core/inc/sched.h
+ifneq ($(SCHED),)
+CPPFLAGS+=-DSCHED
+endif
+# Time-triggered cyclic executive, see src/core/inc/cyclic.h
+ifneq ($(CYCLIC),)
+ifneq ($(SCHED),)
+$(error CYCLIC and SCHED both need the timer, pick one)
+endif
+CPPFLAGS+=-DCYCLIC
+endif
+# Work-stealing job system, see src/core/inc/jobs.h
+ifneq ($(JOBS),)
+CPPFLAGS+=-DJOBS
+endif
+# Idle states and governor, see src/core/inc/idle.h
+ifneq ($(IDLE),)
+CPPFLAGS+=-DIDLE
+endif
+# Cpu hotplug, see src/core/inc/hotplug.h
+ifneq ($(HOTPLUG),)
+ifneq ($(SCHED)$(CYCLIC),)
+$(error HOTPLUG does not support SCHED or CYCLIC, both bind work to a cpu)
+endif
+CPPFLAGS+=-DHOTPLUG
+endif
 ASFLAGS += $(GENERIC_FLAGS) $(CPPFLAGS) $(ARCH_ASFLAGS) 
 CFLAGS += $(GENERIC_FLAGS) $(CPPFLAGS) $(ARCH_CFLAGS) 
 LDFLAGS += $(GENERIC_FLAGS) $(ARCH_LDFLAGS) -nostartfiles
@@ -36,11 +36,24 @@ endif
 -include $(core_dir)/sources.mk
 C_SRC+=$(addprefix $(core_dir)/, $(core_c_srcs))
 
+ifneq ($(BENCH),)
+bench_dir:=$(src_dir)/bench
+SRC_DIRS+=$(bench_dir)
+INC_DIRS+=$(bench_dir)/inc
+-include $(bench_dir)/sources.mk
+C_SRC+=$(addprefix $(bench_dir)/, $(bench_c_srcs))
+endif
+
 -include $(platform_dir)/plat.mk
 -include $(platform_dir)/sources.mk
 C_SRC+=$(addprefix $(platform_dir)/, $(plat_c_srcs))
 ASM_SRC+=$(addprefix $(platform_dir)/, $(plat_s_srcs))
 
+# The virtio-mmio transport, for the guest's own device drivers
+ifneq ($(VIRTIO),)
+drivers+=virtio
+endif
+
 SRC_DIRS+= $(foreach driver, $(drivers), $(drivers_dir)/$(driver))
 INC_DIRS+= $(foreach driver, $(drivers), $(drivers_dir)/$(driver)/inc)
 -include $(foreach driver, $(drivers), $(drivers_dir)/$(driver)/sources.mk)
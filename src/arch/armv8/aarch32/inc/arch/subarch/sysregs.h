@@ -85,7 +85,7 @@ SYSREG_GEN_ACCESSORS_64(par_el1, 0, c7);
 SYSREG_GEN_ACCESSORS(tcr_el1, 4, c2, c0, 2);
 SYSREG_GEN_ACCESSORS_64(ttbr0_el1, 4, c2);
 SYSREG_GEN_ACCESSORS(cptr_el1, 4, c1, c1, 2);
-SYSREG_GEN_ACCESSORS(tpidr_el1, 4, c13, c0, 2);
+SYSREG_GEN_ACCESSORS(tpidr_el1, 0, c13, c0, 4);
 SYSREG_GEN_ACCESSORS(ccsidr_el1, 1, c0, c0, 0);
 SYSREG_GEN_ACCESSORS(ccsidr2, 1, c0, c0, 2);
 SYSREG_GEN_ACCESSORS(mair0, 4, c10, c2, 0);
@@ -111,10 +111,21 @@ SYSREG_GEN_ACCESSORS(icc_igrpen1_el1, 0, c12, c12, 7);
 SYSREG_GEN_ACCESSORS_64(icc_sgi1r_el1, 0, c12);
 
 SYSREG_GEN_ACCESSORS(dccivac, 0, c7, c14, 1);
+SYSREG_GEN_ACCESSORS(dccmvac, 0, c7, c10, 1);
+SYSREG_GEN_ACCESSORS(dcimvac, 0, c7, c6, 1);
+
 static inline void arm_dc_civac(uintptr_t cache_addr) {
     sysreg_dccivac_write(cache_addr);
 }
 
+static inline void arm_dc_cvac(uintptr_t cache_addr) {
+    sysreg_dccmvac_write(cache_addr);
+}
+
+static inline void arm_dc_ivac(uintptr_t cache_addr) {
+    sysreg_dcimvac_write(cache_addr);
+}
+
 static inline void arm_unmask_irq() {
     asm volatile("cpsie i");
 }
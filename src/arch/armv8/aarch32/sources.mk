@@ -1,2 +1,6 @@
 arch_c_srcs:=
-arch_s_srcs+=$(addprefix $(ARCH_SUB)/, exceptions.S page_tables.S start.S)
+arch_s_srcs+=$(addprefix $(ARCH_SUB)/, exceptions.S page_tables.S start.S string.S)
+
+ifneq ($(SCHED),)
+arch_s_srcs+=$(ARCH_SUB)/sched.S
+endif
@@ -61,6 +61,7 @@ SYSREG_GEN_ACCESSORS(csselr_el1);
 SYSREG_GEN_ACCESSORS(ccsidr_el1);
 SYSREG_GEN_ACCESSORS(ccsidr2_el1);
 SYSREG_GEN_ACCESSORS(ctr_el0);
+SYSREG_GEN_ACCESSORS(dczid_el0);
 SYSREG_GEN_ACCESSORS(mpidr_el1);
 SYSREG_GEN_ACCESSORS(sctlr_el1);
 SYSREG_GEN_ACCESSORS(cntkctl_el1);
@@ -98,6 +99,18 @@ static inline void arm_dc_civac(uintptr_t cache_addr) {
     asm volatile ("dc civac, %0\n\t" :: "r"(cache_addr));
 }
 
+static inline void arm_dc_cvac(uintptr_t cache_addr) {
+    asm volatile ("dc cvac, %0\n\t" :: "r"(cache_addr));
+}
+
+static inline void arm_dc_ivac(uintptr_t cache_addr) {
+    asm volatile ("dc ivac, %0\n\t" :: "r"(cache_addr));
+}
+
+static inline void arm_dc_zva(uintptr_t cache_addr) {
+    asm volatile ("dc zva, %0\n\t" :: "r"(cache_addr) : "memory");
+}
+
 static inline void arm_at_s1e2w(uintptr_t vaddr) {
      asm volatile("at s1e2w, %0" ::"r"(vaddr));
 }
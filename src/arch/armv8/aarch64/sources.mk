@@ -1,2 +1,9 @@
-arch_s_srcs+=$(addprefix $(ARCH_SUB)/, exceptions.S page_tables.S start.S)
+arch_s_srcs+=$(addprefix $(ARCH_SUB)/, exceptions.S page_tables.S start.S string.S)
 
+ifneq ($(SIMD),)
+arch_s_srcs+=$(ARCH_SUB)/fpu.S
+endif
+
+ifneq ($(SCHED),)
+arch_s_srcs+=$(ARCH_SUB)/sched.S
+endif
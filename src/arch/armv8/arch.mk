@@ -10,6 +10,22 @@ ARM_PROFILE?=armv8-a
 ARCH_GENERIC_FLAGS +=-DGIC_VERSION=$(GIC_VERSION) -march=$(ARM_PROFILE) \
 	$(ARCH_SUB_GENERIC_FLAGS)
 ARCH_ASFLAGS = 
+ifeq ($(SIMD),)
 ARCH_CFLAGS = -mgeneral-regs-only
+else
+ARCH_CFLAGS =
+ARCH_GENERIC_FLAGS += -DSIMD
+endif
+ifneq ($(PRINTF_FLOAT),)
+ifeq ($(SIMD),)
+$(error PRINTF_FLOAT requires SIMD=y on armv8)
+endif
+endif
+ifneq ($(GIC_ITS),)
+ifneq ($(GIC_VERSION),GICV3)
+$(error GIC_ITS requires GIC_VERSION=GICV3)
+endif
+ARCH_GENERIC_FLAGS += -DGIC_ITS
+endif
 ARCH_CPPFLAGS =	
 ARCH_LDFLAGS = 
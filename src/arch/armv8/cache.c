@@ -0,0 +1,89 @@
+#include <cache.h>
+#include <sysregs.h>
+#include <fences.h>
+#include <bit.h>
+#include <string.h>
+
+size_t cache_line_size()
+{
+    /* CTR_EL0.DminLine is the log2 of the number of words in the line */
+    return 4UL << bit_extract(sysreg_ctr_el0_read(), CTR_DMINLINE_OFF,
+        CTR_DMINLINE_LEN);
+}
+
+void cache_clean_range(void* addr, size_t size)
+{
+    size_t line = cache_line_size();
+    uintptr_t end = (uintptr_t)addr + size;
+
+    for (uintptr_t l = (uintptr_t)addr & ~(line - 1); l < end; l += line) {
+        arm_dc_cvac(l);
+    }
+
+    fence_sync();
+}
+
+void cache_flush_range(void* addr, size_t size)
+{
+    size_t line = cache_line_size();
+    uintptr_t end = (uintptr_t)addr + size;
+
+    for (uintptr_t l = (uintptr_t)addr & ~(line - 1); l < end; l += line) {
+        arm_dc_civac(l);
+    }
+
+    fence_sync();
+}
+
+void cache_inval_range(void* addr, size_t size)
+{
+    size_t line = cache_line_size();
+    uintptr_t start = (uintptr_t)addr;
+    uintptr_t end = start + size;
+
+    if (size == 0) {
+        return;
+    }
+
+    if (start & (line - 1)) {
+        start &= ~(line - 1);
+        arm_dc_civac(start);
+        start += line;
+    }
+
+    if ((end & (line - 1)) && (end & ~(line - 1)) >= start) {
+        end &= ~(line - 1);
+        arm_dc_civac(end);
+    }
+
+    for (uintptr_t l = start; l < end; l += line) {
+        arm_dc_ivac(l);
+    }
+
+    fence_sync();
+}
+
+void mem_zero_lines(void* addr, size_t size)
+{
+#ifdef AARCH64
+    unsigned long dczid = sysreg_dczid_el0_read();
+
+    if (!(dczid & DCZID_DZP_BIT)) {
+        size_t block = 4UL << bit_extract(dczid, DCZID_BS_OFF, DCZID_BS_LEN);
+        uintptr_t start = (uintptr_t)addr;
+        uintptr_t end = start + size;
+        uintptr_t zstart = (start + block - 1) & ~(block - 1);
+        uintptr_t zend = end & ~(block - 1);
+
+        if (zstart < zend) {
+            memset(addr, 0, zstart - start);
+            for (uintptr_t b = zstart; b < zend; b += block) {
+                arm_dc_zva(b);
+            }
+            memset((void*)zend, 0, end - zend);
+            return;
+        }
+    }
+#endif
+    memset(addr, 0, size);
+}
@@ -0,0 +1,80 @@
+#include <cpu_pm.h>
+#include <cpu.h>
+#include <gic.h>
+#include <psci.h>
+#include <sysregs.h>
+
+struct cpu_pm_state {
+    unsigned long ctx[ARCH_CPU_CTX_SIZE / sizeof(unsigned long)];
+    struct gic_cpu_state gic;
+    unsigned long cntkctl;
+    unsigned long cntv_ctl;
+    uint64_t cntv_cval;
+};
+
+static struct cpu_pm_state cpu_pm_states[NR_CPUS];
+
+static struct cpu_pm_state* cpu_pm_save()
+{
+    struct cpu_pm_state* state = &cpu_pm_states[get_cpuid()];
+
+    state->cntkctl = sysreg_cntkctl_el1_read();
+    state->cntv_ctl = sysreg_cntv_ctl_el0_read();
+    state->cntv_cval = sysreg_cntv_cval_el0_read();
+    gic_cpu_save(&state->gic);
+
+    return state;
+}
+
+/* After a cpu off the GIC cpu interface also needs its first time init */
+static void cpu_pm_restore(struct cpu_pm_state* state, bool off)
+{
+    sysreg_cntkctl_el1_write(state->cntkctl);
+    sysreg_cntv_cval_el0_write(state->cntv_cval);
+    sysreg_cntv_ctl_el0_write(state->cntv_ctl);
+    if (off) {
+        gic_cpu_init();
+    }
+    gic_cpu_restore(&state->gic);
+}
+
+int cpu_powerdown(unsigned long power_state)
+{
+    struct cpu_pm_state* state = cpu_pm_save();
+
+    if (cpu_ctx_save(state->ctx) == 0) {
+        return psci_cpu_suspend(power_state, (uintptr_t)_cpu_resume,
+            (unsigned long)state->ctx) == PSCI_E_SUCCESS ? 0 : -1;
+    }
+
+    cpu_pm_restore(state, false);
+    return 1;
+}
+
+int cpu_off()
+{
+    struct cpu_pm_state* state = cpu_pm_save();
+
+    if (cpu_ctx_save(state->ctx) == 0) {
+        psci_cpu_off();
+        return -1;
+    }
+
+    cpu_pm_restore(state, true);
+    return 1;
+}
+
+int cpu_on(unsigned long cpu)
+{
+    if (cpu >= NR_CPUS) {
+        return -1;
+    }
+
+    return psci_cpu_on(cpu_mpidr[cpu], (uintptr_t)_cpu_resume,
+        (unsigned long)cpu_pm_states[cpu].ctx) == PSCI_E_SUCCESS ? 0 : -1;
+}
+
+bool cpu_is_off(unsigned long cpu)
+{
+    return psci_affinity_info(cpu_mpidr[cpu], 0) == PSCI_CPU_IS_OFF;
+}
@@ -18,12 +18,16 @@
 #include <irq.h>
 #include <cpu.h>
 #include <spinlock.h>
+#include <fdt.h>
 
 volatile gicd_t* gicd = (void*)PLAT_GICD_BASE_ADDR;
 volatile gicc_t* gicc = (void*)PLAT_GICC_BASE_ADDR;
 
 spinlock_t gicd_lock = SPINLOCK_INITVAL;
 
+/* Cpu interface of each logical cpu, as read from its banked ITARGETSR0 */
+static uint8_t gic_cpu_if[NR_CPUS];
+
 static size_t gic_num_int(){
     return ((gicd->TYPER & BIT_MASK(GICD_TYPER_ITLINENUM_OFF, GICD_TYPER_ITLINENUM_LEN) >>
         GICD_TYPER_ITLINENUM_OFF) +1)*32;
@@ -31,6 +35,9 @@ static size_t gic_num_int(){
 
 void gicc_init(){
 
+    gic_cpu_if[get_cpuid()] =
+        gicd->ITARGETSR[0] & BIT_MASK(0, GIC_TARGET_BITS);
+
      for(int i =0; i < GIC_NUM_INT_REGS(GIC_CPU_PRIV); i++){
         /**
          * Make sure all private interrupts are not enabled, non pending,
@@ -59,8 +66,48 @@ void gicc_init(){
     
 }
 
+#ifdef FAST_BOOT
+
+/**
+ * With FAST_BOOT the distributor is not swept at init. Each SPI is instead
+ * brought to the default state the first time it is configured. Must be called
+ * with gicd_lock held.
+ */
+static uint32_t gicd_spi_ready[GIC_NUM_INT_REGS(GIC_MAX_INTERUPTS)];
+
+static void gicd_spi_lazy_init(unsigned long int_id){
+
+    if(int_id < GIC_CPU_PRIV) return;
+
+    unsigned long reg_ind = int_id/(sizeof(uint32_t)*8);
+    uint32_t mask = 1U << int_id%(sizeof(uint32_t)*8);
+
+    if(gicd_spi_ready[reg_ind] & mask) return;
+    gicd_spi_ready[reg_ind] |= mask;
+
+    gicd->ICENABLER[reg_ind] = mask;
+    gicd->ICPENDR[reg_ind] = mask;
+    gicd->ICACTIVER[reg_ind] = mask;
+
+    unsigned long prio_ind = (int_id*GIC_PRIO_BITS)/(sizeof(uint32_t)*8);
+    unsigned long prio_off = (int_id*GIC_PRIO_BITS)%(sizeof(uint32_t)*8);
+    gicd->IPRIORITYR[prio_ind] |= ((1 << GIC_PRIO_BITS)-1) << prio_off;
+
+    unsigned long cfg_ind = (int_id*GIC_CONFIG_BITS)/(sizeof(uint32_t)*8);
+    unsigned long cfg_off = (int_id*GIC_CONFIG_BITS)%(sizeof(uint32_t)*8);
+    gicd->ICFGR[cfg_ind] = (gicd->ICFGR[cfg_ind] & 
+        ~(((1U << GIC_CONFIG_BITS)-1) << cfg_off)) | (0x2U << cfg_off);
+}
+
+#else
+
+static inline void gicd_spi_lazy_init(unsigned long int_id) { }
+
+#endif
+
 void gicd_init(){
 
+#ifndef FAST_BOOT
     size_t int_num = gic_num_int();
 
     /* Bring distributor to known state */
@@ -87,16 +134,84 @@ void gicd_init(){
         gicd->ICFGR[i] = 0xAAAAAAAA;
 
     /* No need to setup gicd->NSACR as all interrupts are  setup to group 1 */
+#endif
 
     /* Enable distributor */
     gicd->CTLR |= GICD_CTLR_EN_BIT;
 }
 
+static const char* const gic_compatible[] = {
+    "arm,gic-400", "arm,cortex-a15-gic", "arm,cortex-a9-gic", "arm,gic-v2",
+};
+
+void gic_fdt_discover(){
+
+    uint64_t addr;
+    int node = -1;
+
+    for(size_t i = 0; node < 0 && 
+        i < sizeof(gic_compatible)/sizeof(gic_compatible[0]); i++) {
+        node = fdt_node_offset_by_compatible(-1, gic_compatible[i]);
+    }
+    if(node < 0) return;
+
+    if(fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        gicd = (void*)(uintptr_t)addr;
+    }
+    if(fdt_get_reg(node, 1, &addr, NULL) == 0) {
+        gicc = (void*)(uintptr_t)addr;
+    }
+}
+
+void gic_cpu_init() {
+    gicc_init();
+}
+
 void gic_init() {
     if(get_cpuid() == 0) {
         gicd_init();
     }
-    gicc_init();
+    gic_cpu_init();
+}
+
+void gic_migrate(unsigned long from, unsigned long to)
+{
+    size_t int_num = gic_num_int();
+
+    for (size_t id = GIC_CPU_PRIV; id < int_num && id < GIC_MAX_INTERUPTS;
+        id++) {
+        uint8_t trgt = gic_get_trgt(id);
+        if (trgt & gic_cpu_trgt(from)) {
+            gic_set_trgt(id, (trgt & ~gic_cpu_trgt(from)) | gic_cpu_trgt(to));
+        }
+    }
+}
+
+void gic_cpu_save(struct gic_cpu_state* state)
+{
+    /* The private interrupt registers are banked per cpu */
+    state->isenabler = gicd->ISENABLER[0];
+    for (size_t i = 0; i < GIC_NUM_PRIO_REGS(GIC_CPU_PRIV); i++) {
+        state->ipriorityr[i] = gicd->IPRIORITYR[i];
+    }
+    for (size_t i = 0; i < GIC_NUM_CONFIG_REGS(GIC_CPU_PRIV); i++) {
+        state->icfgr[i] = gicd->ICFGR[i];
+    }
+    state->pmr = gicc->PMR;
+}
+
+/* Pending interrupts are kept, one of them may have woken the cpu up */
+void gic_cpu_restore(struct gic_cpu_state* state)
+{
+    for (size_t i = 0; i < GIC_NUM_PRIO_REGS(GIC_CPU_PRIV); i++) {
+        gicd->IPRIORITYR[i] = state->ipriorityr[i];
+    }
+    for (size_t i = 0; i < GIC_NUM_CONFIG_REGS(GIC_CPU_PRIV); i++) {
+        gicd->ICFGR[i] = state->icfgr[i];
+    }
+    gicd->ISENABLER[0] = state->isenabler;
+    gicc->PMR = state->pmr;
+    gicc->CTLR |= GICC_CTLR_EN_BIT;
 }
 
 void gic_set_enable(unsigned long int_id, bool en){
@@ -106,6 +221,7 @@ void gic_set_enable(unsigned long int_id, bool en){
 
     spin_lock(&gicd_lock);
 
+    gicd_spi_lazy_init(int_id);
     if(en)
         gicd->ISENABLER[reg_ind] = bit;
     else
@@ -137,9 +253,33 @@ uint8_t gic_get_trgt(unsigned long int_id)
     return (gicd->ITARGETSR[reg_ind] & mask) >> off;
 }
 
+/**
+ * The cpu interface numbers need not match the logical ids, e.g. with
+ * clusters. Until a cpu registered its own, assume they do.
+ */
+uint8_t gic_cpu_trgt(unsigned long cpu)
+{
+    return gic_cpu_if[cpu] != 0 ? gic_cpu_if[cpu] : (uint8_t)(1U << cpu);
+}
+
+void gic_send_sgi_mask(const cpumask_t* cpus, unsigned long sgi_num)
+{
+    unsigned long trgt = 0;
+    unsigned long cpu;
+
+    for_each_cpu(cpu, cpus) {
+        trgt |= gic_cpu_trgt(cpu);
+    }
+
+    if (trgt != 0) {
+        gicd->SGIR = (trgt << GICD_SGIR_CPUTRGLST_OFF)
+            | (sgi_num & GICD_SGIR_SGIINTID_MSK);
+    }
+}
+
 void gic_send_sgi(unsigned long cpu_target, unsigned long sgi_num){
-    gicd->SGIR   = (1UL << (GICD_SGIR_CPUTRGLST_OFF + cpu_target))
-        | (sgi_num & GICD_SGIR_SGIINTID_MSK);
+    cpumask_t cpus = cpumask_of(cpu_target);
+    gic_send_sgi_mask(&cpus, sgi_num);
 }
 
 void gic_set_prio(unsigned long int_id, uint8_t prio){
@@ -149,6 +289,7 @@ void gic_set_prio(unsigned long int_id, uint8_t prio){
 
     spin_lock(&gicd_lock);
 
+    gicd_spi_lazy_init(int_id);
     gicd->IPRIORITYR[reg_ind] = (gicd->IPRIORITYR[reg_ind] & ~mask) | 
         ((prio << off) & mask);
 
@@ -20,6 +20,10 @@
 #include <spinlock.h>
 #include <fences.h>
 #include <irq.h>
+#include <fdt.h>
+#ifdef GIC_ITS
+#include <its.h>
+#endif
 
 volatile gicd_t* gicd = (void*)PLAT_GICD_BASE_ADDR;
 volatile gicr_t* gicr = (void*)PLAT_GICR_BASE_ADDR;
@@ -27,6 +31,9 @@ volatile gicr_t* gicr = (void*)PLAT_GICR_BASE_ADDR;
 spinlock_t gicd_lock = SPINLOCK_INITVAL;
 spinlock_t gicr_lock = SPINLOCK_INITVAL;
 
+/* Redistributor of each logical cpu, set by the cpu itself in gicr_init */
+static volatile gicr_t* gicr_cpu[NR_CPUS];
+
 
 inline unsigned long gic_num_irqs()
 {
@@ -44,19 +51,52 @@ static inline void gicc_init()
     sysreg_icc_igrpen1_el1_write(ICC_IGRPEN_EL1_ENB_BIT);
 }
 
+/**
+ * Redistributors need not be laid out in cpu order, e.g. with several
+ * clusters, so they are matched by the affinity in their GICR_TYPER. Falls
+ * back to the cpu's index if none matches.
+ */
+static volatile gicr_t* gicr_lookup(unsigned long cpuid, unsigned long mpidr)
+{
+    uint64_t aff = (MPIDR_AFF(mpidr, 3) << 24) | (mpidr & 0xffffff);
+    uintptr_t frame = (uintptr_t)gicr;
+
+    for (size_t i = 0; i < GICR_MAX_FRAMES; i++) {
+        volatile gicr_t* rdist = (void*)frame;
+        /* Two 32-bit reads, see gicd_set_route */
+        volatile uint32_t* typer = (uint32_t*)&rdist->TYPER;
+        uint64_t _typer = typer[0] | ((uint64_t)typer[1] << 32);
+
+        if ((_typer >> GICR_TYPER_AFF_OFF) == aff) {
+            return rdist;
+        }
+        if (_typer & GICR_TYPER_LAST_BIT) {
+            break;
+        }
+        frame += (_typer & GICR_TYPER_VLPIS_BIT) ? GICR_VLPI_FRAME_SIZE :
+            GICR_FRAME_SIZE;
+    }
+
+    return &gicr[cpuid];
+}
+
 static inline void gicr_init()
 {
+    volatile gicr_t* rdist = gicr_lookup(get_cpuid(), sysreg_mpidr_el1_read());
+
+    gicr_cpu[get_cpuid()] = rdist;
+
     gicd->CTLR |= (1ull << 6);
-    gicr[get_cpuid()].WAKER &= ~GICR_ProcessorSleep_BIT;
-    while(gicr[get_cpuid()].WAKER & GICR_ChildrenASleep_BIT) { }
+    rdist->WAKER &= ~GICR_ProcessorSleep_BIT;
+    while(rdist->WAKER & GICR_ChildrenASleep_BIT) { }
 
-    gicr[get_cpuid()].IGROUPR0 = -1;
-    gicr[get_cpuid()].ICENABLER0 = -1;
-    gicr[get_cpuid()].ICPENDR0 = -1;
-    gicr[get_cpuid()].ICACTIVER0 = -1;
+    rdist->IGROUPR0 = -1;
+    rdist->ICENABLER0 = -1;
+    rdist->ICPENDR0 = -1;
+    rdist->ICACTIVER0 = -1;
 
     for (int i = 0; i < GIC_NUM_PRIO_REGS(GIC_CPU_PRIV); i++) {
-        gicr[get_cpuid()].IPRIORITYR[i] = -1;
+        rdist->IPRIORITYR[i] = -1;
     }
 }
 
@@ -110,8 +150,77 @@ void gic_cpu_init()
     gicc_init();
 }
 
+void gic_cpu_save(struct gic_cpu_state* state)
+{
+    volatile gicr_t* rdist = gicr_cpu[get_cpuid()];
+
+    state->isenabler = rdist->ISENABLER0;
+    for (size_t i = 0; i < GIC_NUM_PRIO_REGS(GIC_CPU_PRIV); i++) {
+        state->ipriorityr[i] = rdist->IPRIORITYR[i];
+    }
+    state->icfgr[0] = rdist->ICFGR0;
+    state->icfgr[1] = rdist->ICFGR1;
+    state->pmr = sysreg_icc_pmr_el1_read();
+}
+
+/**
+ * Only the cpu interface is surely lost, the redistributor is usually kept
+ * powered. It is not reinitialized, so that pending interrupts, one of which
+ * may have woken the cpu up, are kept.
+ */
+void gic_cpu_restore(struct gic_cpu_state* state)
+{
+    volatile gicr_t* rdist = gicr_cpu[get_cpuid()];
+
+    sysreg_icc_sre_el1_write(sysreg_icc_sre_el1_read() | ICC_SRE_SRE_BIT);
+    ISB();
+    gicc_init();
+    for (size_t i = 0; i < GIC_NUM_PRIO_REGS(GIC_CPU_PRIV); i++) {
+        rdist->IPRIORITYR[i] = state->ipriorityr[i];
+    }
+    rdist->ICFGR0 = state->icfgr[0];
+    rdist->ICFGR1 = state->icfgr[1];
+    rdist->ISENABLER0 = state->isenabler;
+    sysreg_icc_pmr_el1_write(state->pmr);
+}
+
+#ifdef FAST_BOOT
+
+/**
+ * With FAST_BOOT the distributor is not swept at init, which costs several
+ * hundred register writes (each one a trap when running over a hypervisor).
+ * Instead, each SPI is brought to the default state the first time it is
+ * configured. Must be called with gicd_lock held.
+ */
+static uint32_t gicd_spi_ready[GIC_NUM_INT_REGS(GIC_MAX_INTERUPTS)];
+
+static void gicd_spi_lazy_init(unsigned long int_id)
+{
+    unsigned long reg_ind = GIC_INT_REG(int_id);
+    uint32_t mask = GIC_INT_MASK(int_id);
+
+    if (gicd_spi_ready[reg_ind] & mask) return;
+    gicd_spi_ready[reg_ind] |= mask;
+
+    gicd->IGROUPR[reg_ind] |= mask;
+    gicd->ICENABLER[reg_ind] = mask;
+    gicd->ICPENDR[reg_ind] = mask;
+    gicd->ICACTIVER[reg_ind] = mask;
+
+    unsigned long prio_ind = GIC_PRIO_REG(int_id);
+    unsigned long prio_off = GIC_PRIO_OFF(int_id);
+    gicd->IPRIORITYR[prio_ind] |= BIT_MASK(prio_off, GIC_PRIO_BITS);
+}
+
+#else
+
+static inline void gicd_spi_lazy_init(unsigned long int_id) { }
+
+#endif
+
 void gicd_init()
 {
+#ifndef FAST_BOOT
     size_t int_num = gic_num_irqs();
 
     /* Bring distributor to known state */
@@ -137,19 +246,48 @@ void gicd_init()
     /* ICFGR are platform dependent, lets leave them as is */
 
     /* No need to setup gicd->NSACR as all interrupts are  setup to group 1 */
+#endif
 
     /* Enable distributor and affinity routing */
     gicd->CTLR |= GICD_CTLR_ARE_NS_BIT | GICD_CTLR_ENA_BIT;
 }
 
+void gic_fdt_discover()
+{
+    uint64_t addr;
+    int node = fdt_node_offset_by_compatible(-1, "arm,gic-v3");
+
+    if (node < 0) return;
+
+    if (fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        gicd = (void*)(uintptr_t)addr;
+    }
+    if (fdt_get_reg(node, 1, &addr, NULL) == 0) {
+        gicr = (void*)(uintptr_t)addr;
+    }
+
+#ifdef GIC_ITS
+    node = fdt_node_offset_by_compatible(node, "arm,gic-v3-its");
+    if (node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        gits = (void*)(uintptr_t)addr;
+    }
+#endif
+}
+
 void gic_init()
 {
     gic_cpu_init();
 
     if (get_cpuid() == 0) {
         gicd_init();
+#ifdef GIC_ITS
+        its_init();
+#endif
     }
 
+#ifdef GIC_ITS
+    its_cpu_init(gicr_cpu[get_cpuid()]);
+#endif
 }
 
 void gic_handle()
@@ -157,7 +295,8 @@ void gic_handle()
     unsigned long ack = sysreg_icc_iar1_el1_read();
     unsigned long id = ack & ((1UL << 24) -1);
 
-    if (id >= 1022) return;
+    /* Special ids, LPIs start at GIC_FIRST_LPI */
+    if (id >= 1022 && id < GIC_FIRST_LPI) return;
 
     irq_handle(id);
 
@@ -201,6 +340,7 @@ void gicd_set_prio(unsigned long int_id, uint8_t prio)
 
     spin_lock(&gicd_lock);
 
+    gicd_spi_lazy_init(int_id);
     gicd->IPRIORITYR[reg_ind] =
         (gicd->IPRIORITYR[reg_ind] & ~mask) | ((prio << off) & mask);
 
@@ -306,6 +446,7 @@ void gicd_set_enable(unsigned long int_id, bool en)
 
     unsigned long reg_ind = GIC_INT_REG(int_id);
     spin_lock(&gicd_lock);
+    gicd_spi_lazy_init(int_id);
     if (en)
         gicd->ISENABLER[reg_ind] = bit;
     else
@@ -321,8 +462,8 @@ void gicr_set_prio(unsigned long int_id, uint8_t prio, uint32_t gicr_id)
 
     spin_lock(&gicr_lock);
 
-    gicr[gicr_id].IPRIORITYR[reg_ind] =
-        (gicr[gicr_id].IPRIORITYR[reg_ind] & ~mask) | ((prio << off) & mask);
+    gicr_cpu[gicr_id]->IPRIORITYR[reg_ind] =
+        (gicr_cpu[gicr_id]->IPRIORITYR[reg_ind] & ~mask) | ((prio << off) & mask);
 
     spin_unlock(&gicr_lock);
 }
@@ -335,7 +476,7 @@ unsigned long gicr_get_prio(unsigned long int_id, uint32_t gicr_id)
     spin_lock(&gicr_lock);
 
     unsigned long prio =
-        gicr[gicr_id].IPRIORITYR[reg_ind] >> off & BIT_MASK(off, GIC_PRIO_BITS);
+        gicr_cpu[gicr_id]->IPRIORITYR[reg_ind] >> off & BIT_MASK(off, GIC_PRIO_BITS);
 
     spin_unlock(&gicr_lock);
 
@@ -351,11 +492,11 @@ void gicr_set_icfgr(unsigned long int_id, uint8_t cfg, uint32_t gicr_id)
     unsigned long mask = ((1U << GIC_CONFIG_BITS) - 1) << off;
 
     if (reg_ind == 0) {
-        gicr[gicr_id].ICFGR0 =
-            (gicr[gicr_id].ICFGR0 & ~mask) | ((cfg << off) & mask);
+        gicr_cpu[gicr_id]->ICFGR0 =
+            (gicr_cpu[gicr_id]->ICFGR0 & ~mask) | ((cfg << off) & mask);
     } else {
-        gicr[gicr_id].ICFGR1 =
-            (gicr[gicr_id].ICFGR1 & ~mask) | ((cfg << off) & mask);
+        gicr_cpu[gicr_id]->ICFGR1 =
+            (gicr_cpu[gicr_id]->ICFGR1 & ~mask) | ((cfg << off) & mask);
     }
 
     spin_unlock(&gicr_lock);
@@ -367,8 +508,8 @@ enum int_state gicr_get_state(unsigned long int_id, uint32_t gicr_id)
 
     spin_lock(&gicr_lock);
 
-    enum int_state pend = (gicr[gicr_id].ISPENDR0 & mask) ? PEND : 0;
-    enum int_state act = (gicr[gicr_id].ISACTIVER0 & mask) ? ACT : 0;
+    enum int_state pend = (gicr_cpu[gicr_id]->ISPENDR0 & mask) ? PEND : 0;
+    enum int_state act = (gicr_cpu[gicr_id]->ISACTIVER0 & mask) ? ACT : 0;
 
     spin_unlock(&gicr_lock);
 
@@ -379,9 +520,9 @@ static void gicr_set_pend(unsigned long int_id, bool pend, uint32_t gicr_id)
 {
     spin_lock(&gicr_lock);
     if (pend) {
-        gicr[gicr_id].ISPENDR0 = (1U) << (int_id);
+        gicr_cpu[gicr_id]->ISPENDR0 = (1U) << (int_id);
     } else {
-        gicr[gicr_id].ICPENDR0 = (1U) << (int_id);
+        gicr_cpu[gicr_id]->ICPENDR0 = (1U) << (int_id);
     }
     spin_unlock(&gicr_lock);
 }
@@ -391,9 +532,9 @@ void gicr_set_act(unsigned long int_id, bool act, uint32_t gicr_id)
     spin_lock(&gicr_lock);
 
     if (act) {
-        gicr[gicr_id].ISACTIVER0 = GIC_INT_MASK(int_id);
+        gicr_cpu[gicr_id]->ISACTIVER0 = GIC_INT_MASK(int_id);
     } else {
-        gicr[gicr_id].ICACTIVER0 = GIC_INT_MASK(int_id);
+        gicr_cpu[gicr_id]->ICACTIVER0 = GIC_INT_MASK(int_id);
     }
 
     spin_unlock(&gicr_lock);
@@ -423,9 +564,9 @@ void gicr_set_enable(unsigned long int_id, bool en, uint32_t gicr_id)
 
     spin_lock(&gicr_lock);
     if (en)
-        gicr[gicr_id].ISENABLER0 = bit;
+        gicr_cpu[gicr_id]->ISENABLER0 = bit;
     else
-        gicr[gicr_id].ICENABLER0 = bit;
+        gicr_cpu[gicr_id]->ICENABLER0 = bit;
     spin_unlock(&gicr_lock);
 }
 
@@ -435,12 +576,49 @@ static bool irq_in_gicd(unsigned long int_id)
     else return false;
 }
 
-void gic_send_sgi(unsigned long cpu_target, unsigned long sgi_num)
+/* The ICC_SGI1R_EL1 fields, but the target list, that address cpu's group */
+static uint64_t gic_sgi_group(unsigned long cpu)
+{
+    unsigned long mpidr = cpu_mpidr[cpu];
+
+    return (MPIDR_AFF(mpidr, 1) << ICC_SGIR_AFF1_OFF) |
+        (MPIDR_AFF(mpidr, 2) << ICC_SGIR_AFF2_OFF) |
+        (MPIDR_AFF(mpidr, 3) << ICC_SGIR_AFF3_OFF) |
+        ((MPIDR_AFF(mpidr, 0) / ICC_SGIR_TRGLST_LEN) << ICC_SGIR_RS_OFF);
+}
+
+/**
+ * A write reaches the cpus of one cluster whose Aff0 falls in the same range
+ * of 16 (RS), so the targets are grouped by cluster and range.
+ */
+void gic_send_sgi_mask(const cpumask_t* cpus, unsigned long sgi_num)
 {
+    cpumask_t left = *cpus;
+    unsigned long first, cpu;
+
     if (sgi_num >= GIC_MAX_SGIS) return;
-    
-    unsigned long sgi = (1UL << (cpu_target & 0xffull)) | (sgi_num << 24);
-    sysreg_icc_sgi1r_el1_write(sgi); 
+
+    for_each_cpu(first, &left) {
+        uint64_t group = gic_sgi_group(first);
+        uint64_t trgt = 0;
+
+        for (cpu = first; cpu < NR_CPUS; cpu = cpumask_next(&left, cpu + 1)) {
+            if (gic_sgi_group(cpu) == group) {
+                trgt |= 1ULL <<
+                    (MPIDR_AFF(cpu_mpidr[cpu], 0) % ICC_SGIR_TRGLST_LEN);
+                cpumask_clear_cpu(&left, cpu);
+            }
+        }
+
+        sysreg_icc_sgi1r_el1_write(group | trgt |
+            ((uint64_t)sgi_num << ICC_SGIR_INTID_OFF));
+    }
+}
+
+void gic_send_sgi(unsigned long cpu_target, unsigned long sgi_num)
+{
+    cpumask_t cpus = cpumask_of(cpu_target);
+    gic_send_sgi_mask(&cpus, sgi_num);
 }
 
 void gic_set_prio(unsigned long int_id, uint8_t prio)
@@ -515,9 +693,25 @@ void gic_set_trgt(unsigned long int_id, uint8_t trgt)
     }
 }
 
+/* Routes to the logical cpu trgt, by its affinity */
 void gic_set_route(unsigned long int_id, unsigned long trgt)
 {
-    return gicd_set_route(int_id, trgt);
+    return gicd_set_route(int_id, cpu_mpidr[trgt] & MPIDR_AFF_MSK);
+}
+
+void gic_migrate(unsigned long from, unsigned long to)
+{
+    size_t int_num = gic_num_irqs();
+
+    for (size_t id = GIC_CPU_PRIV; id < int_num && id < GIC_MAX_INTERUPTS;
+        id++) {
+        /* Two 32-bit reads, see gicd_set_route */
+        volatile uint32_t* irouter = (uint32_t*)&gicd->IROUTER[id];
+        uint64_t route = irouter[0] | ((uint64_t)irouter[1] << 32);
+        if (route == (cpu_mpidr[from] & MPIDR_AFF_MSK)) {
+            gic_set_route(id, to);
+        }
+    }
 }
 
 void gic_set_enable(unsigned long int_id, bool en)
@@ -0,0 +1,21 @@
+#ifndef ARCH_CPU_PM_H
+#define ARCH_CPU_PM_H
+
+#include <core.h>
+
+/* Bytes saved by cpu_ctx_save, see start.S */
+#ifdef AARCH32
+#ifdef SIMD
+#define ARCH_CPU_CTX_SIZE   (112)
+#else
+#define ARCH_CPU_CTX_SIZE   (48)
+#endif
+#else
+#ifdef SIMD
+#define ARCH_CPU_CTX_SIZE   (176)
+#else
+#define ARCH_CPU_CTX_SIZE   (112)
+#endif
+#endif
+
+#endif /* ARCH_CPU_PM_H */
@@ -0,0 +1,30 @@
+#ifndef ARCH_HYPERCALL_H
+#define ARCH_HYPERCALL_H
+
+#include <core.h>
+
+/* Bao hypercalls: hvc #0 with the hypercall id in x0/r0, result in x0/r0 */
+static inline long arch_hypercall(unsigned long id, unsigned long arg0,
+    unsigned long arg1, unsigned long arg2)
+{
+#ifdef AARCH64
+    register unsigned long r0 asm("x0") = id;
+    register unsigned long r1 asm("x1") = arg0;
+    register unsigned long r2 asm("x2") = arg1;
+    register unsigned long r3 asm("x3") = arg2;
+#else
+    register unsigned long r0 asm("r0") = id;
+    register unsigned long r1 asm("r1") = arg0;
+    register unsigned long r2 asm("r2") = arg1;
+    register unsigned long r3 asm("r3") = arg2;
+#endif
+
+    asm volatile("hvc #0\n\t"
+        : "+r"(r0)
+        : "r"(r1), "r"(r2), "r"(r3)
+        : "memory");
+
+    return (long)r0;
+}
+
+#endif
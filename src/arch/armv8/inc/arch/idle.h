@@ -0,0 +1,19 @@
+#ifndef ARCH_IDLE_H
+#define ARCH_IDLE_H
+
+#include <core.h>
+#include <plat.h>
+#include <psci.h>
+
+/**
+ * PSCI CPU_SUSPEND power_state of the idle states, in the extended format
+ * with a 0 state id. Platforms with their own state ids override them.
+ */
+#ifndef PLAT_PSCI_RETENTION_STATE
+#define PLAT_PSCI_RETENTION_STATE   (PSCI_STATE_TYPE_STANDBY)
+#endif
+#ifndef PLAT_PSCI_POWERDOWN_STATE
+#define PLAT_PSCI_POWERDOWN_STATE   (PSCI_STATE_TYPE_POWERDOWN)
+#endif
+
+#endif /* ARCH_IDLE_H */
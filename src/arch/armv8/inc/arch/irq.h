@@ -3,7 +3,57 @@
 
 #define IPI_IRQ_ID (0)
 #define TIMER_IRQ_ID (27)
-#define IRQ_NUM (1024)
 #define IRQ_MAX_PRIO (0)
 
+#ifdef GIC_ITS
+/* LPIs handed out for MSIs, see its.h */
+#ifndef ITS_NUM_LPIS
+#define ITS_NUM_LPIS (256)
+#endif
+/* LPIs, from 8192, take the handler slots after the wired interrupts */
+#define IRQ_FIRST_LPI (8192)
+#define IRQ_NUM_WIRED (1024)
+#define IRQ_NUM (IRQ_NUM_WIRED + ITS_NUM_LPIS)
+#define ARCH_IRQ_SLOT(ID)                                       \
+    ((ID) >= IRQ_FIRST_LPI ? (ID) - IRQ_FIRST_LPI + IRQ_NUM_WIRED : \
+     (ID) < IRQ_NUM_WIRED ? (ID) : IRQ_NUM)
+#else
+#define IRQ_NUM (1024)
+#endif
+
+#ifndef __ASSEMBLER__
+
+/* Local interrupt masking, arch_irq_save returns the state to restore */
+static inline unsigned long arch_irq_save()
+{
+    unsigned long flags;
+#ifdef AARCH64
+    asm volatile("mrs %0, daif\n\tmsr daifset, #2\n\t"
+        : "=r"(flags) :: "memory");
+#else
+    asm volatile("mrs %0, cpsr\n\tcpsid i\n\t" : "=r"(flags) :: "memory");
+#endif
+    return flags;
+}
+
+static inline void arch_irq_restore(unsigned long flags)
+{
+#ifdef AARCH64
+    asm volatile("msr daif, %0\n\t" :: "r"(flags) : "memory");
+#else
+    asm volatile("msr cpsr_c, %0\n\t" :: "r"(flags) : "memory");
+#endif
+}
+
+static inline void arch_irq_enable()
+{
+#ifdef AARCH64
+    asm volatile("msr daifclr, #2\n\t" ::: "memory");
+#else
+    asm volatile("cpsie i\n\t" ::: "memory");
+#endif
+}
+
+#endif /* __ASSEMBLER__ */
+
 #endif /* ARCH_IRQ_H */
@@ -0,0 +1,28 @@
+#ifndef ARCH_SCHED_H
+#define ARCH_SCHED_H
+
+#include <core.h>
+
+/**
+ * Frame pushed by sched_ctx_switch: the callee-saved registers, with the
+ * return address at word ARCH_CTX_LR. New threads start with a zeroed frame
+ * returning to their entry point.
+ */
+#ifdef AARCH64
+#ifdef SIMD
+#define ARCH_CTX_SIZE   (176)   /* x19-x30, d8-d15, fpcr */
+#else
+#define ARCH_CTX_SIZE   (96)    /* x19-x30 */
+#endif
+#define ARCH_CTX_LR     (11)
+#else
+#ifdef SIMD
+#define ARCH_CTX_SIZE   (104)   /* d8-d15, r4-r12, lr */
+#define ARCH_CTX_LR     (25)
+#else
+#define ARCH_CTX_SIZE   (40)    /* r4-r12, lr */
+#define ARCH_CTX_LR     (9)
+#endif
+#endif
+
+#endif /* ARCH_SCHED_H */
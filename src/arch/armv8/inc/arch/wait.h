@@ -0,0 +1,45 @@
+#ifndef ARCH_WAIT_H
+#define ARCH_WAIT_H
+
+#include <core.h>
+
+/**
+ * Waits in wfe, bounded by the generic timer event stream enabled in
+ * arch_init, so every wait wakes up at least every WAIT_EVENT_PERIOD_US.
+ */
+#define ARCH_WAIT_BOUNDED   (1)
+
+#define CNTKCTL_EVNTEN      (1UL << 2)
+#define CNTKCTL_EVNTI_OFF   (4)
+#define CNTKCTL_EVNTI_LEN   (4)
+
+static inline void arch_wait_event()
+{
+    asm volatile("wfe\n\t" ::: "memory");
+}
+
+static inline void arch_wait_notify()
+{
+    asm volatile("dsb ishst\n\tsev\n\t" ::: "memory");
+}
+
+/**
+ * Waits for *addr to change from val. The exclusive load arms the monitor,
+ * a write to the word by another cpu then clears it generating the event
+ * that ends the wfe, no sev needed.
+ */
+static inline void arch_wait_word(const volatile uint32_t* addr, uint32_t val)
+{
+    uint32_t cur;
+
+#ifdef AARCH64
+    asm volatile("ldaxr %w0, [%1]\n\t" : "=&r"(cur) : "r"(addr) : "memory");
+#else
+    asm volatile("ldaex %0, [%1]\n\t" : "=&r"(cur) : "r"(addr) : "memory");
+#endif
+    if (cur == val) {
+        arch_wait_event();
+    }
+}
+
+#endif /* ARCH_WAIT_H */
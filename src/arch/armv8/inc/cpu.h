@@ -4,11 +4,17 @@
 #include <core.h>
 #include <sysregs.h>
 
+/**
+ * Cpu ids are logical, dense from 0 whatever the cluster layout, and kept in
+ * TPIDR_EL1 (TPIDRPRW on aarch32) by start.S. The boot cpu is 0.
+ */
 static inline unsigned long get_cpuid(){
-    unsigned long cpuid = sysreg_mpidr_el1_read();
-    return cpuid & MPIDR_CPU_MASK;
+    return sysreg_tpidr_el1_read();
 }
 
+/* MPIDR affinity of each logical cpu, for PSCI and interrupt routing */
+extern unsigned long cpu_mpidr[NR_CPUS];
+
 static bool cpu_is_master() {
     return get_cpuid() == 0;
 }
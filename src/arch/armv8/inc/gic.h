@@ -19,6 +19,7 @@
 
 #include <core.h>
 #include <bit.h>
+#include <cpumask.h>
 #include <plat.h>
 
 #define GICV2 (2)
@@ -28,6 +29,7 @@
 #define GIC_MAX_SGIS 16
 #define GIC_MAX_PPIS 16
 #define GIC_CPU_PRIV (GIC_MAX_SGIS + GIC_MAX_PPIS)
+#define GIC_FIRST_LPI (8192)
 #define GIC_MAX_SPIS (GIC_MAX_INTERUPTS - GIC_CPU_PRIV)
 #define GIC_PRIO_BITS 8
 #define GIC_TARGET_BITS 8
@@ -146,6 +148,28 @@ typedef struct {
 #define GICR_CTRL_DS_BIT (1 << 6)
 #define GICR_ProcessorSleep_BIT (0x2)
 #define GICR_ChildrenASleep_BIT (0x4)
+
+/* Redistributor Type Register, GICR_TYPER */
+
+#define GICR_TYPER_VLPIS_BIT (1ULL << 1)
+#define GICR_TYPER_LAST_BIT (1ULL << 4)
+#define GICR_TYPER_AFF_OFF (32)
+#define GICR_FRAME_SIZE (0x20000)
+#define GICR_VLPI_FRAME_SIZE (0x40000)
+
+/* Frames walked looking for a redistributor before giving up */
+#ifndef GICR_MAX_FRAMES
+#define GICR_MAX_FRAMES (512)
+#endif
+
+/* SGI Group 1 Register, ICC_SGI1R_EL1 */
+
+#define ICC_SGIR_TRGLST_LEN (16)
+#define ICC_SGIR_AFF1_OFF (16)
+#define ICC_SGIR_INTID_OFF (24)
+#define ICC_SGIR_AFF2_OFF (32)
+#define ICC_SGIR_RS_OFF (44)
+#define ICC_SGIR_AFF3_OFF (48)
 typedef struct {
     /* RD_base frame */
     uint32_t CTLR;
@@ -287,8 +311,29 @@ typedef struct {
 enum int_state { INV, PEND, ACT, PENDACT };
 
 void gic_init();
+void gic_fdt_discover();
 void gic_cpu_init();
+
+/* Private interrupt config of a cpu, lost when the cpu powers down */
+struct gic_cpu_state {
+    uint32_t isenabler;
+    uint32_t ipriorityr[GIC_NUM_PRIO_REGS(GIC_CPU_PRIV)];
+    uint32_t icfgr[GIC_NUM_CONFIG_REGS(GIC_CPU_PRIV)];
+    uint32_t pmr;
+};
+
+void gic_cpu_save(struct gic_cpu_state* state);
+/* Reenables the calling cpu's interface, then restores state */
+void gic_cpu_restore(struct gic_cpu_state* state);
 void gic_send_sgi(unsigned long cpu_target, unsigned long sgi_num);
+/**
+ * Sends sgi_num to every cpu in cpus in as few writes as the targets'
+ * affinities allow: one with GICv2, one per group of 16 cpus of a cluster
+ * with GICv3.
+ */
+void gic_send_sgi_mask(const cpumask_t* cpus, unsigned long sgi_num);
+/* GICv2 cpu interface target bit of a logical cpu */
+uint8_t gic_cpu_trgt(unsigned long cpu);
 
 void gic_set_enable(unsigned long int_id, bool en);
 void gic_set_prio(unsigned long int_id, uint8_t prio);
@@ -297,6 +342,8 @@ void gic_set_act(unsigned long int_id, bool act);
 void gic_set_state(unsigned long int_id, enum int_state state);
 void gic_set_trgt(unsigned long int_id, uint8_t trgt);
 void gic_set_route(unsigned long int_id, unsigned long trgt);
+/* Moves the SPIs targeting cpu from to cpu to */
+void gic_migrate(unsigned long from, unsigned long to);
 unsigned long gic_get_prio(unsigned long int_id);
 uint8_t gic_get_trgt(unsigned long int_id);
 enum int_state gic_get_state(unsigned long int_id);
@@ -312,6 +359,8 @@ unsigned long gicd_get_prio(unsigned long int_id);
 enum int_state gicd_get_state(unsigned long int_id);
 unsigned long gic_num_irqs();
 
+extern volatile gicd_t* gicd;
+
 void gicr_set_enable(unsigned long int_id, bool en, uint32_t gicr_id);
 void gicr_set_prio(unsigned long int_id, uint8_t prio, uint32_t gicr_id);
 void gicr_set_icfgr(unsigned long int_id, uint8_t cfg, uint32_t gicr_id);
@@ -336,6 +385,7 @@ static inline bool gic_is_priv(unsigned long int_id)
 #undef PLAT_GICD_BASE_ADDR
 #undef PLAT_GICC_BASE_ADDR
 #undef PLAT_GICR_BASE_ADDR
+#undef PLAT_GITS_BASE_ADDR
 #endif
 
 #ifndef PLAT_GICD_BASE_ADDR
@@ -350,6 +400,11 @@ static inline bool gic_is_priv(unsigned long int_id)
 #define PLAT_GICR_BASE_ADDR (0xF9020000)
 #endif
 
+/* No ITS unless the platform or the device tree has one */
+#ifndef PLAT_GITS_BASE_ADDR
+#define PLAT_GITS_BASE_ADDR (0)
+#endif
+
 
 
 #endif /* __GIC_H__ */
@@ -0,0 +1,174 @@
+#ifndef ITS_H
+#define ITS_H
+
+#include <core.h>
+#include <gic.h>
+#include <arch/irq.h>
+
+/**
+ * GICv3 Interrupt Translation Service, built with GIC_ITS=y. Devices raise
+ * LPIs by writing an event id to GITS_TRANSLATER, which the ITS translates,
+ * by the writer's device id, to an LPI and the collection (i.e. cpu) it is
+ * routed to, skipping the distributor. Each cpu gets a collection, with its
+ * logical id as collection id.
+ *
+ * The ITS tables, the LPI configuration and pending tables, and the command
+ * queue all live in normal memory, statically allocated. Commands are
+ * queued in batches and the ITS is kicked once per batch. If a batch is not
+ * consumed in time, or a command stalls the queue, the ITS is given up on:
+ * the call fails, as does any later one.
+ */
+
+/* Devices that can be mapped at once, and events of each */
+#ifndef ITS_MAX_DEVICES
+#define ITS_MAX_DEVICES     (16)
+#endif
+
+#ifndef ITS_MAX_EVENTS
+#define ITS_MAX_EVENTS      (32)
+#endif
+
+/* Bytes of each of the device and collection tables, a whole 64KB page */
+#ifndef ITS_TABLE_SIZE
+#define ITS_TABLE_SIZE      (0x10000)
+#endif
+
+#define ITS_CMDQ_SIZE       (0x1000)
+#define ITS_CMD_TIMEOUT_US  (1000)
+
+/* Interrupt id bits used for LPIs: 8192 LPIs from GIC_FIRST_LPI */
+#define ITS_LPI_ID_BITS     (14)
+#define ITS_PROP_TABLE_SIZE ((1UL << ITS_LPI_ID_BITS) - GIC_FIRST_LPI)
+#define ITS_PEND_TABLE_SIZE ((1UL << ITS_LPI_ID_BITS) / 8)
+#define ITS_PEND_TABLE_ALIGN (0x10000)
+
+#if ITS_NUM_LPIS > ITS_PROP_TABLE_SIZE
+#error "ITS_NUM_LPIS does not fit in ITS_LPI_ID_BITS"
+#endif
+
+/* ITS Control Register, GITS_CTLR */
+#define GITS_CTLR_EN_BIT            (1U << 0)
+#define GITS_CTLR_QUIESCENT_BIT     (1U << 31)
+
+/* ITS Type Register, GITS_TYPER */
+#define GITS_TYPER_ITT_SIZE_OFF     (4)
+#define GITS_TYPER_ITT_SIZE_LEN     (4)
+#define GITS_TYPER_IDBITS_OFF       (8)
+#define GITS_TYPER_IDBITS_LEN       (5)
+#define GITS_TYPER_DEVBITS_OFF      (13)
+#define GITS_TYPER_DEVBITS_LEN      (5)
+#define GITS_TYPER_PTA_BIT          (1ULL << 19)
+#define GITS_TYPER_HCC_OFF          (24)
+#define GITS_TYPER_HCC_LEN          (8)
+
+/* ITS Translation Table Descriptors, GITS_BASER<n> */
+#define GITS_NUM_BASER              (8)
+#define GITS_BASER_SIZE_OFF         (0)
+#define GITS_BASER_SIZE_LEN         (8)
+#define GITS_BASER_PGSZ_OFF         (8)
+#define GITS_BASER_PGSZ_LEN         (2)
+#define GITS_BASER_PGSZ_4K          (0ULL << GITS_BASER_PGSZ_OFF)
+#define GITS_BASER_PGSZ_16K         (1ULL << GITS_BASER_PGSZ_OFF)
+#define GITS_BASER_PGSZ_64K         (2ULL << GITS_BASER_PGSZ_OFF)
+#define GITS_BASER_ESZ_OFF          (48)
+#define GITS_BASER_ESZ_LEN          (5)
+#define GITS_BASER_TYPE_OFF         (56)
+#define GITS_BASER_TYPE_LEN         (3)
+#define GITS_BASER_TYPE_NONE        (0)
+#define GITS_BASER_TYPE_DEVICE      (1)
+#define GITS_BASER_TYPE_COLLECTION  (4)
+#define GITS_BASER_INDIRECT_BIT     (1ULL << 62)
+#define GITS_BASER_VALID_BIT        (1ULL << 63)
+#define GITS_BASER_PA_MSK           (0x0000fffffffff000ULL)
+
+/**
+ * Memory attributes shared by GITS_BASER, GITS_CBASER and the redistributor
+ * GICR_PROPBASER and GICR_PENDBASER: inner shareable, write-back. A
+ * shareability reading back as 0 means the GIC does not snoop the caches.
+ */
+#define GIC_MEM_SH_OFF              (10)
+#define GIC_MEM_SH_MSK              (3ULL << GIC_MEM_SH_OFF)
+#define GIC_MEM_SH_IS               (1ULL << GIC_MEM_SH_OFF)
+#define GIC_MEM_ICACHE_OFF_BASER    (59)
+#define GIC_MEM_ICACHE_OFF_RDIST    (7)
+#define GIC_MEM_ICACHE_MSK          (7ULL)
+#define GIC_MEM_CACHE_NC            (1ULL)
+#define GIC_MEM_CACHE_WAWB          (7ULL)
+
+/* ITS Command Queue Descriptor, GITS_CBASER */
+#define GITS_CBASER_VALID_BIT       (1ULL << 63)
+#define GITS_CBASER_PA_MSK          (0x000ffffffffff000ULL)
+
+/* Command queue read and write offsets, GITS_CREADR and GITS_CWRITER */
+#define GITS_CQ_OFF_MSK             (0xfffe0ULL)
+#define GITS_CREADR_STALLED_BIT     (1ULL << 0)
+
+/* Redistributor LPI registers */
+#define GICR_CTLR_ENABLE_LPIS_BIT   (1U << 0)
+#define GICR_TYPER_PLPIS_BIT        (1ULL << 0)
+#define GICR_TYPER_PROCNUM_OFF      (8)
+#define GICR_TYPER_PROCNUM_LEN      (16)
+#define GICR_PROPBASER_PA_MSK       (0x000ffffffffff000ULL)
+#define GICR_PENDBASER_PA_MSK       (0x000fffffffff0000ULL)
+#define GICR_PENDBASER_PTZ_BIT      (1ULL << 62)
+
+#define GICD_TYPER_LPIS_BIT         (1U << 17)
+
+/* LPI configuration table entries */
+#define LPI_PROP_EN_BIT             (1U << 0)
+#define LPI_PROP_RES1_BIT           (1U << 1)
+#define LPI_PROP_PRIO_MSK           (0xfc)
+
+/* ITS commands, 32 bytes each */
+#define ITS_CMD_MOVI                (0x01)
+#define ITS_CMD_INT                 (0x03)
+#define ITS_CMD_SYNC                (0x05)
+#define ITS_CMD_MAPD                (0x08)
+#define ITS_CMD_MAPC                (0x09)
+#define ITS_CMD_MAPTI               (0x0a)
+#define ITS_CMD_INV                 (0x0c)
+#define ITS_CMD_DISCARD             (0x0f)
+
+#define ITS_CMD_DEVID_OFF           (32)
+#define ITS_CMD_PINTID_OFF          (32)
+#define ITS_CMD_ITT_MSK             (0x000fffffffffff00ULL)
+#define ITS_CMD_RDBASE_MSK          (0x000fffffffff0000ULL)
+#define ITS_CMD_VALID_BIT           (1ULL << 63)
+
+typedef struct {
+    uint32_t CTLR;
+    uint32_t IIDR;
+    uint64_t TYPER;
+    uint8_t pad0[0x0080 - 0x0010];
+    uint64_t CBASER;
+    uint64_t CWRITER;
+    uint64_t CREADR;
+    uint8_t pad1[0x0100 - 0x0098];
+    uint64_t BASER[GITS_NUM_BASER];
+    uint8_t pad2[0x10040 - 0x0140];
+    /* Translation register frame */
+    uint32_t TRANSLATER;
+} __attribute__((__packed__, aligned(0x10000))) gits_t;
+
+extern volatile gits_t* gits;
+
+/* By cpu 0 from gic_init, once the distributor is up */
+void its_init();
+/**
+ * By each cpu from gic_init: enables its LPIs and maps its collection.
+ * Returns -1 if the ITS did not take the mapping.
+ */
+int its_cpu_init(volatile gicr_t* rdist);
+
+bool its_is_lpi(unsigned long int_id);
+void its_lpi_enable(unsigned long int_id, bool en);
+void its_lpi_set_prio(unsigned long int_id, uint8_t prio);
+/* Moves the LPIs routed to cpu from to cpu to */
+void its_migrate(unsigned long from, unsigned long to);
+
+/* See irq_msi_alloc and friends in irq.h */
+int its_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id);
+void its_msi_free(uint32_t dev_id);
+int its_msi_msg(unsigned id, uint64_t* addr, uint32_t* data);
+
+#endif /* ITS_H */
@@ -38,6 +38,19 @@
 #define MPIDR_AFFINITY_BITS (8)
 #define MPIDR_AFFLVL_MASK (0xff)
 #define MPIDR_U_BIT (1UL << 30)
+#define MPIDR_AFF3_OFF (32)
+#define MPIDR_AFF_MSK (0xff00ffffffULL)
+#define MPIDR_AFF(MPIDR, LVL) \
+    (((uint64_t)(MPIDR) >> ((LVL) == 3 ? MPIDR_AFF3_OFF : (LVL) * MPIDR_AFFINITY_BITS)) \
+        & MPIDR_AFFLVL_MASK)
+
+/**
+ * Cpus per cluster, numbers the cpus from their affinity when there is no
+ * firmware to start them in order, see start.S.
+ */
+#ifndef PLAT_CLUSTER_CPUS
+#define PLAT_CLUSTER_CPUS (4)
+#endif
 
 /* SPSR - Saved Program Status Register */
 
@@ -299,6 +312,12 @@
 #define CTR_CEG_LEN 4
 #define CTR_RES1 (1UL << 31)
 
+/* DCZID_EL0 - Data Cache Zero ID Register */
+
+#define DCZID_BS_OFF 0
+#define DCZID_BS_LEN 4
+#define DCZID_DZP_BIT (1UL << 4)
+
 /* CSSELR_EL1 - Cache Size Selection Register */
 
 #define CSSELR_IND_BIT 0
@@ -371,6 +390,13 @@
 #define HCR_TEA_BIT (1UL << 37)
 #define HCR_MIOCNCE_BIT (1UL << 38)
 
+/* CPACR_EL1, Architectural Feature Access Control Register */
+
+#define CPACR_FPEN_OFF (20)
+#define CPACR_FPEN_MSK (0x3 << CPACR_FPEN_OFF)
+#define CPACR_FPEN_TRAP (0x0 << CPACR_FPEN_OFF)
+#define CPACR_FPEN_NOTRAP (0x3 << CPACR_FPEN_OFF)
+
 /* ESR_ELx, Exception Syndrome Register (ELx) */
 
 #define ESR_ISS_OFF (0)
@@ -382,6 +408,7 @@
 
 #define ESR_EC_UNKWN (0x00)
 #define ESR_EC_WFIE (0x01)
+#define ESR_EC_FPTRAP (0x07)
 #define ESR_EC_SVC32 (0x11)
 #define ESR_EC_HVC32 (0x12)
 #define ESR_EC_SMC32 (0x13)
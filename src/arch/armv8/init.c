@@ -5,25 +5,75 @@
 #include <gic.h>
 #include <timer.h>
 #include <sysregs.h>
+#include <fdt.h>
+#include <bit.h>
+#include <wait.h>
 
 void _start();
+void _secondary_start();
+
+unsigned long cpu_mpidr[NR_CPUS];
+
+/**
+ * Makes the generic timer wake up wfe every WAIT_EVENT_PERIOD_US or less. An
+ * event is generated when the selected counter bit goes from 0 to 1, i.e.
+ * every 2^(bit + 1) ticks.
+ */
+static void wait_event_stream_init()
+{
+    uint64_t period = TIME_US(WAIT_EVENT_PERIOD_US);
+    unsigned long bit = 0;
+
+    while (bit < 15 && (2ULL << (bit + 1)) <= period) {
+        bit++;
+    }
+
+    unsigned long cntkctl = sysreg_cntkctl_el1_read();
+    cntkctl = bit_insert(cntkctl, bit, CNTKCTL_EVNTI_OFF, CNTKCTL_EVNTI_LEN);
+    sysreg_cntkctl_el1_write(cntkctl | CNTKCTL_EVNTEN);
+}
 
 __attribute__((weak))
 void arch_init(){
     unsigned long cpuid = get_cpuid();
+    cpu_mpidr[cpuid] = sysreg_mpidr_el1_read() & MPIDR_AFF_MSK;
     gic_init();
     TIMER_FREQ = sysreg_cntfrq_el0_read();
     sysreg_cntv_ctl_el0_write(1);
+    wait_event_stream_init();
 
 #if !(defined(SINGLE_CORE) || defined(NO_FIRMWARE))
-    if(cpuid == 0){
+    /**
+     * Logical ids are handed out densely, in device tree order, to the cpus
+     * that actually started. The table is filled before they run, so they can
+     * be targeted as soon as they are up.
+     */
+    unsigned long next = 1;
+    if(cpuid == 0 && fdt_cpu_num > 0){
+        for(size_t i = 0; i < fdt_cpu_num && next < NR_CPUS; i++) {
+            unsigned long mpidr = fdt_cpu_ids[i] & MPIDR_AFF_MSK;
+            if(mpidr == cpu_mpidr[cpuid]) continue;
+            cpu_mpidr[next] = mpidr;
+            if(psci_cpu_on(mpidr, (uintptr_t) _secondary_start, next) ==
+                PSCI_E_SUCCESS) {
+                next++;
+            }
+        }
+    } else if(cpuid == 0){
+        /* No device tree, probe until the firmware refuses */
         size_t i = 0;
         int ret = PSCI_E_SUCCESS;
         do {
-            if(i == cpuid) continue;
-            ret = psci_cpu_on(i, (uintptr_t) _start, 0);
-        } while(i++, ret == PSCI_E_SUCCESS);
+            if(i == cpu_mpidr[cpuid]) continue;
+            cpu_mpidr[next] = i;
+            ret = psci_cpu_on(i, (uintptr_t) _secondary_start, next);
+            if(ret == PSCI_E_SUCCESS) next++;
+        } while(i++, ret == PSCI_E_SUCCESS && next < NR_CPUS);
     }
 #endif
     arm_unmask_irq();
 }
+
+void arch_fdt_discover(){
+    gic_fdt_discover();
+}
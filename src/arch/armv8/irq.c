@@ -1,28 +1,74 @@
 #include <irq.h>
 #include <cpu.h>
 #include <gic.h>
+#ifdef GIC_ITS
+#include <its.h>
+#endif
 
 #ifndef GIC_VERSION
 #error "GIC_VERSION not defined for this platform"
 #endif
 
 void irq_enable(unsigned id) {
+#ifdef GIC_ITS
+   if (its_is_lpi(id)) {
+       its_lpi_enable(id, true);
+       return;
+   }
+#endif
    gic_set_enable(id, true); 
    if(GIC_VERSION == GICV2) {
-       gic_set_trgt(id, gic_get_trgt(id) | (1 << get_cpuid()));
+       gic_set_trgt(id, gic_get_trgt(id) | gic_cpu_trgt(get_cpuid()));
    } else {
        gic_set_route(id, get_cpuid());
    }
 }
 
+void irq_migrate(unsigned long from, unsigned long to) {
+    gic_migrate(from, to);
+#ifdef GIC_ITS
+    its_migrate(from, to);
+#endif
+}
+
 void irq_set_prio(unsigned id, unsigned prio){
+#ifdef GIC_ITS
+    if (its_is_lpi(id)) {
+        its_lpi_set_prio(id, (uint8_t) prio);
+        return;
+    }
+#endif
     gic_set_prio(id, (uint8_t) prio);
 }
 
-void irq_send_ipi(unsigned long target_cpu_mask) {
-    for(int i = 0; i < sizeof(target_cpu_mask)*8; i++) {
-        if(target_cpu_mask & (1ull << i)) {
-            gic_send_sgi(i, IPI_IRQ_ID);
-        }
-    }
+void irq_send_ipi(const cpumask_t* cpus) {
+    gic_send_sgi_mask(cpus, IPI_IRQ_ID);
+}
+
+#ifdef GIC_ITS
+
+int irq_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id) {
+    return its_msi_alloc(dev_id, num, first_id);
 }
+
+void irq_msi_free(uint32_t dev_id) {
+    its_msi_free(dev_id);
+}
+
+int irq_msi_msg(unsigned id, struct irq_msi_msg* msg) {
+    return its_msi_msg(id, &msg->addr, &msg->data);
+}
+
+#else
+
+int irq_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id) {
+    return -1;
+}
+
+void irq_msi_free(uint32_t dev_id) { }
+
+int irq_msi_msg(unsigned id, struct irq_msi_msg* msg) {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,508 @@
+#include <its.h>
+#include <cpu.h>
+#include <bit.h>
+#include <bitmap.h>
+#include <cache.h>
+#include <fences.h>
+#include <spinlock.h>
+#include <wait.h>
+#include <stdio.h>
+
+volatile gits_t* gits = (void*)PLAT_GITS_BASE_ADDR;
+
+struct its_cmd {
+    uint64_t dw[4];
+};
+
+/* The LPIs of a device's events 0..num-1 are consecutive from lpi */
+struct its_device {
+    uint32_t id;
+    size_t num;     /* 0 if the slot is free */
+    size_t lpi;     /* index from GIC_FIRST_LPI */
+};
+
+/* ITT entries are at most 16 bytes, and ITTs 256-byte aligned */
+#define ITS_ITT_SIZE    (ITS_MAX_EVENTS * 16)
+
+enum { ITS_STATE_INIT, ITS_STATE_READY, ITS_STATE_ABSENT, ITS_STATE_STALLED };
+
+static uint8_t its_dev_table[ITS_TABLE_SIZE] __attribute__((aligned(0x10000)));
+static uint8_t its_coll_table[ITS_TABLE_SIZE]
+    __attribute__((aligned(0x10000)));
+static struct its_cmd its_cmdq[ITS_CMDQ_SIZE / sizeof(struct its_cmd)]
+    __attribute__((aligned(0x1000)));
+static uint8_t its_prop_table[ITS_PROP_TABLE_SIZE]
+    __attribute__((aligned(0x1000)));
+/* Only ITS_PEND_TABLE_SIZE of each is used, but they must be 64KB aligned */
+static uint8_t its_pend_tables[NR_CPUS][ITS_PEND_TABLE_ALIGN]
+    __attribute__((aligned(ITS_PEND_TABLE_ALIGN)));
+static uint8_t its_itts[ITS_MAX_DEVICES][ITS_ITT_SIZE]
+    __attribute__((aligned(256)));
+
+static struct its_device its_devices[ITS_MAX_DEVICES];
+static unsigned long its_lpis_used[BITMAP_WORDS(ITS_NUM_LPIS)];
+/* Collection, i.e. cpu, each LPI is routed to */
+static uint16_t its_lpi_cpu[ITS_NUM_LPIS];
+static uint64_t its_rdbase[NR_CPUS];
+
+static volatile uint32_t its_state = ITS_STATE_INIT;
+static size_t its_dev_ids;
+static size_t its_event_bits;
+static size_t its_itt_entry_size;
+static bool its_pta;
+static bool its_noncoherent;
+static size_t its_cmd_wr;
+static size_t its_cmd_pending;
+static spinlock_t its_lock = SPINLOCK_INITVAL;
+
+/* Two 32-bit accesses, see gicd_set_route */
+static uint64_t its_read64(volatile uint64_t* reg)
+{
+    volatile uint32_t* reg32 = (volatile uint32_t*)reg;
+    return reg32[0] | ((uint64_t)reg32[1] << 32);
+}
+
+static void its_write64(volatile uint64_t* reg, uint64_t val)
+{
+    volatile uint32_t* reg32 = (volatile uint32_t*)reg;
+    reg32[0] = val;
+    reg32[1] = val >> 32;
+}
+
+/* Makes memory written by the cpu visible to the GIC */
+static void its_mem_sync(void* addr, size_t size)
+{
+    if (its_noncoherent) {
+        cache_clean_range(addr, size);
+    } else {
+        DSB(ishst);
+    }
+}
+
+/**
+ * Writes a table base register with inner shareable, write-back attributes,
+ * falling back to non-cacheable if the GIC does not take part in coherency.
+ */
+static uint64_t its_base_write(volatile uint64_t* reg, uint64_t val,
+    unsigned long icache_off)
+{
+    val &= ~(GIC_MEM_SH_MSK | (GIC_MEM_ICACHE_MSK << icache_off));
+    its_write64(reg, val | GIC_MEM_SH_IS | (GIC_MEM_CACHE_WAWB << icache_off));
+
+    uint64_t read = its_read64(reg);
+    if ((read & GIC_MEM_SH_MSK) == 0) {
+        its_noncoherent = true;
+        its_write64(reg, val | (GIC_MEM_CACHE_NC << icache_off));
+        read = its_read64(reg);
+    }
+
+    return read;
+}
+
+/**
+ * Waits for the ITS to process every queued command. Call with its_lock.
+ * Returns -1 if it did not, or did not for an earlier batch: the slots it
+ * did not consume can not be reused, so the ITS is marked stalled and
+ * commands are no longer queued.
+ */
+static int its_cmd_flush()
+{
+    uint64_t off = its_cmd_wr * sizeof(struct its_cmd);
+    uint64_t deadline = wait_deadline(TIME_US(ITS_CMD_TIMEOUT_US));
+    uint64_t creadr;
+
+    if (its_state != ITS_STATE_READY) {
+        return -1;
+    }
+
+    its_write64(&gits->CWRITER, off);
+    do {
+        creadr = its_read64(&gits->CREADR);
+        if ((creadr & GITS_CQ_OFF_MSK) == off) {
+            its_cmd_pending = 0;
+            return 0;
+        }
+    } while (!(creadr & GITS_CREADR_STALLED_BIT) && timer_get() < deadline);
+
+    its_state = ITS_STATE_STALLED;
+    printf("its: command queue %s at 0x%llx\n",
+        (creadr & GITS_CREADR_STALLED_BIT) ? "stalled" : "timed out",
+        (unsigned long long)(creadr & GITS_CQ_OFF_MSK));
+    return -1;
+}
+
+/**
+ * Queues a command, to be submitted by its_cmd_flush. The queue is empty
+ * between batches, it is only flushed early if a batch fills it. Commands
+ * are dropped once the ITS stalled, the batch's flush then fails.
+ */
+static void its_cmd(uint64_t dw0, uint64_t dw1, uint64_t dw2)
+{
+    size_t num = sizeof(its_cmdq) / sizeof(its_cmdq[0]);
+    struct its_cmd* cmd = &its_cmdq[its_cmd_wr];
+
+    if (its_cmd_pending == num - 1) {
+        its_cmd_flush();
+    }
+    if (its_state != ITS_STATE_READY) {
+        return;
+    }
+
+    cmd->dw[0] = dw0;
+    cmd->dw[1] = dw1;
+    cmd->dw[2] = dw2;
+    cmd->dw[3] = 0;
+    its_mem_sync(cmd, sizeof(*cmd));
+
+    its_cmd_wr = (its_cmd_wr + 1) % num;
+    its_cmd_pending++;
+}
+
+static void its_cmd_mapd(uint32_t dev_id, void* itt, size_t bits, bool valid)
+{
+    its_cmd(ITS_CMD_MAPD | ((uint64_t)dev_id << ITS_CMD_DEVID_OFF), bits - 1,
+        ((uintptr_t)itt & ITS_CMD_ITT_MSK) | (valid ? ITS_CMD_VALID_BIT : 0));
+}
+
+static void its_cmd_mapc(unsigned long cpu, uint64_t rdbase)
+{
+    its_cmd(ITS_CMD_MAPC, 0, cpu | (rdbase & ITS_CMD_RDBASE_MSK) |
+        ITS_CMD_VALID_BIT);
+}
+
+static void its_cmd_mapti(uint32_t dev_id, uint32_t event, size_t lpi,
+    unsigned long cpu)
+{
+    its_cmd(ITS_CMD_MAPTI | ((uint64_t)dev_id << ITS_CMD_DEVID_OFF),
+        event | ((uint64_t)(GIC_FIRST_LPI + lpi) << ITS_CMD_PINTID_OFF), cpu);
+}
+
+static void its_cmd_event(uint8_t op, uint32_t dev_id, uint32_t event,
+    unsigned long cpu)
+{
+    its_cmd(op | ((uint64_t)dev_id << ITS_CMD_DEVID_OFF), event, cpu);
+}
+
+static void its_cmd_sync(unsigned long cpu)
+{
+    its_cmd(ITS_CMD_SYNC, 0, its_rdbase[cpu] & ITS_CMD_RDBASE_MSK);
+}
+
+/* Returns the number of entries of the table, 0 if it could not be set */
+static size_t its_baser_init(volatile uint64_t* baser, void* table,
+    uint64_t type)
+{
+    uint64_t val = its_read64(baser);
+    size_t esz = ((val >> GITS_BASER_ESZ_OFF) & BIT_MASK(0, GITS_BASER_ESZ_LEN))
+        + 1;
+    size_t page = 0x1000;
+
+    /* The smallest page size the ITS takes */
+    for (uint64_t pgsz = 0; pgsz < 3; pgsz++, page *= 4) {
+        val = (type << GITS_BASER_TYPE_OFF) |
+            ((uint64_t)(esz - 1) << GITS_BASER_ESZ_OFF) |
+            ((uintptr_t)table & GITS_BASER_PA_MSK) |
+            (pgsz << GITS_BASER_PGSZ_OFF) | (ITS_TABLE_SIZE / page - 1) |
+            GITS_BASER_VALID_BIT;
+        val = its_base_write(baser, val, GIC_MEM_ICACHE_OFF_BASER);
+        if (((val >> GITS_BASER_PGSZ_OFF) & BIT_MASK(0, GITS_BASER_PGSZ_LEN))
+            == pgsz) {
+            its_mem_sync(table, ITS_TABLE_SIZE);
+            return ITS_TABLE_SIZE / esz;
+        }
+    }
+
+    its_write64(baser, 0);
+    return 0;
+}
+
+void its_init()
+{
+    if (gits == NULL || !(gicd->TYPER & GICD_TYPER_LPIS_BIT)) {
+        its_state = ITS_STATE_ABSENT;
+        wait_notify();
+        return;
+    }
+
+    gits->CTLR &= ~GITS_CTLR_EN_BIT;
+    while (!(gits->CTLR & GITS_CTLR_QUIESCENT_BIT)) { }
+
+    uint64_t typer = its_read64(&gits->TYPER);
+    its_itt_entry_size = ((typer >> GITS_TYPER_ITT_SIZE_OFF) &
+        BIT_MASK(0, GITS_TYPER_ITT_SIZE_LEN)) + 1;
+    its_event_bits = ((typer >> GITS_TYPER_IDBITS_OFF) &
+        BIT_MASK(0, GITS_TYPER_IDBITS_LEN)) + 1;
+    its_pta = (typer & GITS_TYPER_PTA_BIT) != 0;
+
+    for (size_t i = 0; i < GITS_NUM_BASER; i++) {
+        uint64_t type = (its_read64(&gits->BASER[i]) >> GITS_BASER_TYPE_OFF) &
+            BIT_MASK(0, GITS_BASER_TYPE_LEN);
+        if (type == GITS_BASER_TYPE_DEVICE) {
+            its_dev_ids = its_baser_init(&gits->BASER[i], its_dev_table, type);
+        } else if (type == GITS_BASER_TYPE_COLLECTION) {
+            its_baser_init(&gits->BASER[i], its_coll_table, type);
+        }
+    }
+
+    size_t devbits = ((typer >> GITS_TYPER_DEVBITS_OFF) &
+        BIT_MASK(0, GITS_TYPER_DEVBITS_LEN)) + 1;
+    if (devbits < sizeof(its_dev_ids) * 8 && its_dev_ids > (1UL << devbits)) {
+        its_dev_ids = 1UL << devbits;
+    }
+
+    its_base_write(&gits->CBASER, ((uintptr_t)its_cmdq & GITS_CBASER_PA_MSK) |
+        (ITS_CMDQ_SIZE / 0x1000 - 1) | GITS_CBASER_VALID_BIT,
+        GIC_MEM_ICACHE_OFF_BASER);
+    its_write64(&gits->CWRITER, 0);
+    its_cmd_wr = 0;
+
+    /* Lowest priority and disabled until irq_enable */
+    for (size_t i = 0; i < ITS_PROP_TABLE_SIZE; i++) {
+        its_prop_table[i] = LPI_PROP_PRIO_MSK | LPI_PROP_RES1_BIT;
+    }
+    its_mem_sync(its_prop_table, sizeof(its_prop_table));
+
+    gits->CTLR |= GITS_CTLR_EN_BIT;
+
+    its_state = ITS_STATE_READY;
+    wait_notify();
+}
+
+int its_cpu_init(volatile gicr_t* rdist)
+{
+    unsigned long cpuid = get_cpuid();
+
+    /* Without firmware the other cpus may get here before cpu 0 */
+    wait_until(its_state != ITS_STATE_INIT, WAIT_FOREVER);
+
+    volatile uint32_t* typer32 = (volatile uint32_t*)&rdist->TYPER;
+    uint64_t typer = typer32[0] | ((uint64_t)typer32[1] << 32);
+    if (its_state != ITS_STATE_READY || !(typer & GICR_TYPER_PLPIS_BIT)) {
+        return its_state == ITS_STATE_STALLED ? -1 : 0;
+    }
+
+    /* Once enabled, LPIs cannot be reconfigured, e.g. back from hotplug */
+    if (!(rdist->CTLR & GICR_CTLR_ENABLE_LPIS_BIT)) {
+        its_base_write(&rdist->PROPBASER,
+            ((uintptr_t)its_prop_table & GICR_PROPBASER_PA_MSK) |
+            (ITS_LPI_ID_BITS - 1), GIC_MEM_ICACHE_OFF_RDIST);
+        its_mem_sync(its_pend_tables[cpuid], ITS_PEND_TABLE_SIZE);
+        its_base_write(&rdist->PENDBASER,
+            ((uintptr_t)its_pend_tables[cpuid] & GICR_PENDBASER_PA_MSK) |
+            GICR_PENDBASER_PTZ_BIT, GIC_MEM_ICACHE_OFF_RDIST);
+        DSB(sy);
+        rdist->CTLR |= GICR_CTLR_ENABLE_LPIS_BIT;
+    }
+
+    its_rdbase[cpuid] = its_pta ? (uintptr_t)rdist :
+        ((typer >> GICR_TYPER_PROCNUM_OFF) &
+            BIT_MASK(0, GICR_TYPER_PROCNUM_LEN)) << 16;
+
+    spin_lock(&its_lock);
+    its_cmd_mapc(cpuid, its_rdbase[cpuid]);
+    its_cmd_sync(cpuid);
+    int ret = its_cmd_flush();
+    spin_unlock(&its_lock);
+
+    return ret;
+}
+
+bool its_is_lpi(unsigned long int_id)
+{
+    return int_id >= GIC_FIRST_LPI && int_id < GIC_FIRST_LPI + ITS_NUM_LPIS;
+}
+
+static struct its_device* its_device_of_lpi(size_t lpi)
+{
+    for (size_t i = 0; i < ITS_MAX_DEVICES; i++) {
+        struct its_device* dev = &its_devices[i];
+        if (dev->num != 0 && lpi >= dev->lpi && lpi < dev->lpi + dev->num) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+static struct its_device* its_device_of_id(uint32_t dev_id)
+{
+    for (size_t i = 0; i < ITS_MAX_DEVICES; i++) {
+        if (its_devices[i].num != 0 && its_devices[i].id == dev_id) {
+            return &its_devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Updates an LPI's configuration, which the ITS caches until told with INV */
+static void its_lpi_config(unsigned long int_id, uint8_t clear, uint8_t set,
+    bool route_here)
+{
+    size_t lpi = int_id - GIC_FIRST_LPI;
+    unsigned long cpuid = get_cpuid();
+
+    if (!its_is_lpi(int_id)) return;
+
+    spin_lock(&its_lock);
+    struct its_device* dev = its_device_of_lpi(lpi);
+    if (dev != NULL) {
+        uint32_t event = lpi - dev->lpi;
+        its_prop_table[lpi] = (its_prop_table[lpi] & ~clear) | set;
+        its_mem_sync(&its_prop_table[lpi], 1);
+        its_cmd_event(ITS_CMD_INV, dev->id, event, 0);
+        if (route_here && its_lpi_cpu[lpi] != cpuid) {
+            its_cmd_event(ITS_CMD_MOVI, dev->id, event, cpuid);
+            its_cmd_sync(its_lpi_cpu[lpi]);
+            its_lpi_cpu[lpi] = cpuid;
+        }
+        its_cmd_sync(its_lpi_cpu[lpi]);
+        its_cmd_flush();
+    }
+    spin_unlock(&its_lock);
+}
+
+/* Like SPIs, enabling an LPI routes it to the calling cpu */
+void its_lpi_enable(unsigned long int_id, bool en)
+{
+    its_lpi_config(int_id, LPI_PROP_EN_BIT, en ? LPI_PROP_EN_BIT : 0, en);
+}
+
+void its_lpi_set_prio(unsigned long int_id, uint8_t prio)
+{
+    its_lpi_config(int_id, LPI_PROP_PRIO_MSK, prio & LPI_PROP_PRIO_MSK, false);
+}
+
+void its_migrate(unsigned long from, unsigned long to)
+{
+    size_t lpi;
+    bool moved = false;
+
+    if (its_state != ITS_STATE_READY) return;
+
+    spin_lock(&its_lock);
+    bitmap_for_each(lpi, its_lpis_used, ITS_NUM_LPIS) {
+        struct its_device* dev = its_device_of_lpi(lpi);
+        if (its_lpi_cpu[lpi] == from && dev != NULL) {
+            its_cmd_event(ITS_CMD_MOVI, dev->id, lpi - dev->lpi, to);
+            its_lpi_cpu[lpi] = to;
+            moved = true;
+        }
+    }
+    if (moved) {
+        its_cmd_sync(from);
+        its_cmd_flush();
+    }
+    spin_unlock(&its_lock);
+}
+
+/* First of num free consecutive LPIs, ITS_NUM_LPIS if there are none */
+static size_t its_lpi_alloc(size_t num)
+{
+    size_t start = 0;
+
+    while (start + num <= ITS_NUM_LPIS) {
+        size_t used = bitmap_find_next(its_lpis_used, ITS_NUM_LPIS, start);
+        if (used >= start + num) {
+            for (size_t i = start; i < start + num; i++) {
+                bitmap_set(its_lpis_used, i);
+            }
+            return start;
+        }
+        start = used + 1;
+    }
+
+    return ITS_NUM_LPIS;
+}
+
+int its_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id)
+{
+    unsigned long cpuid = get_cpuid();
+    struct its_device* dev = NULL;
+    int ret = -1;
+
+    if (its_state != ITS_STATE_READY || num == 0 || num > ITS_MAX_EVENTS ||
+        dev_id >= its_dev_ids) {
+        return -1;
+    }
+
+    size_t bits = num > 1 ? BITS_PER_LONG - __builtin_clzl(num - 1) : 1;
+    if (bits > its_event_bits ||
+        (1UL << bits) * its_itt_entry_size > ITS_ITT_SIZE) {
+        return -1;
+    }
+
+    spin_lock(&its_lock);
+    for (size_t i = 0; i < ITS_MAX_DEVICES && dev == NULL; i++) {
+        if (its_devices[i].num == 0) dev = &its_devices[i];
+    }
+    size_t lpi = its_lpi_alloc(num);
+
+    if (dev != NULL && its_device_of_id(dev_id) == NULL &&
+        lpi < ITS_NUM_LPIS) {
+        dev->id = dev_id;
+        dev->num = num;
+        dev->lpi = lpi;
+
+        /* One batch: the device's table, then all of its events */
+        its_cmd_mapd(dev_id, its_itts[dev - its_devices], bits, true);
+        for (size_t i = 0; i < num; i++) {
+            its_lpi_cpu[lpi + i] = cpuid;
+            its_cmd_mapti(dev_id, i, lpi + i, cpuid);
+        }
+        its_cmd_sync(cpuid);
+        ret = its_cmd_flush();
+
+        if (ret == 0) {
+            *first_id = GIC_FIRST_LPI + lpi;
+        } else {
+            dev->num = 0;
+        }
+    }
+    if (ret != 0 && lpi < ITS_NUM_LPIS) {
+        for (size_t i = lpi; i < lpi + num; i++) {
+            bitmap_clear(its_lpis_used, i);
+        }
+    }
+    spin_unlock(&its_lock);
+
+    return ret;
+}
+
+void its_msi_free(uint32_t dev_id)
+{
+    spin_lock(&its_lock);
+    struct its_device* dev = its_device_of_id(dev_id);
+    if (dev != NULL) {
+        for (size_t i = 0; i < dev->num; i++) {
+            size_t lpi = dev->lpi + i;
+            its_cmd_event(ITS_CMD_DISCARD, dev_id, i, 0);
+            its_cmd_sync(its_lpi_cpu[lpi]);
+            its_prop_table[lpi] &= ~LPI_PROP_EN_BIT;
+            bitmap_clear(its_lpis_used, lpi);
+        }
+        its_mem_sync(&its_prop_table[dev->lpi], dev->num);
+        its_cmd_mapd(dev_id, NULL, 1, false);
+        its_cmd_flush();
+        dev->num = 0;
+    }
+    spin_unlock(&its_lock);
+}
+
+int its_msi_msg(unsigned id, uint64_t* addr, uint32_t* data)
+{
+    int ret = -1;
+
+    if (!its_is_lpi(id)) return -1;
+
+    spin_lock(&its_lock);
+    struct its_device* dev = its_device_of_lpi(id - GIC_FIRST_LPI);
+    if (dev != NULL) {
+        *addr = (uintptr_t)&gits->TRANSLATER;
+        *data = id - GIC_FIRST_LPI - dev->lpi;
+        ret = 0;
+    }
+    spin_unlock(&its_lock);
+
+    return ret;
+}
@@ -0,0 +1,76 @@
+#include <core.h>
+#include <fdt.h>
+#include <page_tables.h>
+#include <fences.h>
+
+#define MAPPED_LIMIT (0x100000000ULL)
+
+#ifdef MPU
+
+/* The first mpu region covers the lower 2GB as normal memory */
+uint64_t arch_mem_map(uint64_t start, uint64_t end)
+{
+    if (end > 0x80000000ULL) end = 0x80000000ULL;
+
+    return (end > start) ? end : start;
+}
+
+#else
+
+#ifdef AARCH64
+#define BLOCK_SIZE  L2_BLOCK_SIZE
+extern uint64_t l2_page_tables[];
+#define block_pte(ADDR) (&l2_page_tables[(ADDR) / BLOCK_SIZE])
+#define tlb_inval(ADDR) \
+    asm volatile("tlbi vaae1is, %0\n\t" :: "r"((ADDR) >> 12) : "memory")
+#else
+#define BLOCK_SIZE  L1_BLOCK_SIZE
+extern uint32_t page_table[];
+#define block_pte(ADDR) (&page_table[(ADDR) / BLOCK_SIZE])
+#define tlb_inval(ADDR) \
+    asm volatile("mcr p15, 0, %0, c8, c3, 3\n\t" /* tlbimvaais */ \
+        :: "r"((uint32_t)(ADDR)) : "memory")
+#endif
+
+/* Blocks holding some of the image, already normal memory and in use */
+static inline bool block_in_image(uint64_t addr)
+{
+    return addr < (uint64_t)MEM_BASE + MEM_SIZE &&
+        addr + BLOCK_SIZE > (uint64_t)MEM_BASE;
+}
+
+/**
+ * The static page tables map the whole lower 4GB with blocks, only
+ * [MEM_BASE, MEM_BASE + MEM_SIZE) as normal memory. Blocks in [start, end)
+ * are switched from device to normal memory using break-before-make, but
+ * for those holding the image, which can not be unmapped while running. A
+ * start within a block is only usable if that block holds the image.
+ */
+uint64_t arch_mem_map(uint64_t start, uint64_t end)
+{
+    uint64_t first = (start + BLOCK_SIZE - 1) & ~((uint64_t)BLOCK_SIZE - 1);
+
+    if (end > MAPPED_LIMIT) end = MAPPED_LIMIT;
+    end &= ~((uint64_t)BLOCK_SIZE - 1);
+
+    if (end <= first ||
+        (first != start && !block_in_image(first - BLOCK_SIZE))) {
+        return start;
+    }
+
+    for (uint64_t addr = first; addr < end; addr += BLOCK_SIZE) {
+        if (block_in_image(addr)) continue;
+        *block_pte(addr) = 0;
+        fence_sync_write();
+        tlb_inval(addr);
+        fence_sync();
+        *block_pte(addr) = (PTE_SUPERPAGE | PTE_MEM_FLAGS) + addr;
+    }
+
+    fence_sync();
+    ISB();
+
+    return end;
+}
+
+#endif
@@ -1,7 +1,18 @@
-arch_c_srcs:= init.c psci.c irq.c timer.c
+arch_c_srcs:= init.c psci.c irq.c timer.c cache.c mem.c
 
 ifeq ($(GIC_VERSION),GICV3)
 	arch_c_srcs+=gicv3.c
+ifneq ($(GIC_ITS),)
+	arch_c_srcs+=its.c
+endif
 else
 	arch_c_srcs+=gicv2.c
 endif
+
+ifneq ($(IDLE),)
+	arch_c_srcs+=idle.c
+endif
+
+ifneq ($(IDLE)$(HOTPLUG),)
+	arch_c_srcs+=cpu_pm.c
+endif
@@ -1,12 +1,28 @@
 #include <timer.h>
 #include <sysregs.h>
+#include <cpu.h>
 
 unsigned long TIMER_FREQ;
 
+/* 0 until the cpu programs its timer, CVAL is unknown out of reset */
+static uint64_t timer_deadline[NR_CPUS];
+
 void timer_set(uint64_t n)
 {
     uint64_t current = sysreg_cntvct_el0_read();
-    sysreg_cntv_cval_el0_write(current + n);
+    timer_set_abs(current + n);
+}
+
+void timer_set_abs(uint64_t time)
+{
+    timer_deadline[get_cpuid()] = time;
+    sysreg_cntv_cval_el0_write(time);
+}
+
+uint64_t timer_get_deadline()
+{
+    uint64_t deadline = timer_deadline[get_cpuid()];
+    return deadline != 0 ? deadline : TIMER_NO_DEADLINE;
 }
 
 uint64_t timer_get()
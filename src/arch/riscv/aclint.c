@@ -0,0 +1,32 @@
+#include <aclint.h>
+#include <fdt.h>
+
+#ifdef STD_ADDR_SPACE
+#undef PLAT_ACLINT_SSWI_BASE
+#endif
+
+#ifdef PLAT_ACLINT_SSWI_BASE
+volatile uint32_t* aclint_sswi = (void*)PLAT_ACLINT_SSWI_BASE;
+#else
+volatile uint32_t* aclint_sswi = NULL;
+#endif
+
+/* A valid device tree without the node means there is none */
+void aclint_fdt_discover()
+{
+    uint64_t addr;
+    int node = -1;
+
+    if (!fdt_valid()) return;
+
+    while ((node = fdt_node_offset_by_compatible(node, "riscv,aclint-sswi"))
+        >= 0) {
+        if (fdt_node_is_available(node)) break;
+    }
+
+    if (node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        aclint_sswi = (void*)(uintptr_t)addr;
+    } else {
+        aclint_sswi = NULL;
+    }
+}
@@ -0,0 +1,63 @@
+#include <aplic.h>
+#include <fdt.h>
+
+volatile aplic_t* aplic = (void*)APLIC_BASE;
+
+void aplic_fdt_discover()
+{
+    uint64_t addr;
+    int node = -1;
+
+    /* The machine domain, if the firmware left it visible, has children */
+    while ((node = fdt_node_offset_by_compatible(node, "riscv,aplic")) >= 0) {
+        if (fdt_node_is_available(node) &&
+            fdt_getprop(node, "riscv,children", NULL) == NULL) {
+            break;
+        }
+    }
+
+    if (node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        aplic = (void*)(uintptr_t)addr;
+    }
+}
+
+/* Sources keep their configuration, harts may enable them before this */
+void aplic_init()
+{
+    aplic->domaincfg = APLIC_DOMAINCFG_IE_BIT | APLIC_DOMAINCFG_DM_BIT;
+}
+
+/* The target's hart index is the hart id, as in the IMSIC layout */
+void aplic_enable_interrupt(unsigned long hart, unsigned id, bool en)
+{
+    if (!aplic_is_source(id)) return;
+
+    if (en) {
+        aplic->sourcecfg[id - 1] = APLIC_SOURCECFG_SM_LEVEL1;
+        aplic->target[id - 1] = (hart << APLIC_TARGET_HART_OFF) | id;
+        aplic->setienum = id;
+    } else {
+        aplic->clrienum = id;
+    }
+}
+
+void aplic_migrate(unsigned long from, unsigned long to)
+{
+    for (unsigned id = 1; id < APLIC_NUM_SOURCES; id++) {
+        if (aplic->sourcecfg[id - 1] != APLIC_SOURCECFG_SM_INACTIVE &&
+            (aplic->target[id - 1] >> APLIC_TARGET_HART_OFF) == from) {
+            aplic->target[id - 1] = (to << APLIC_TARGET_HART_OFF) | id;
+        }
+    }
+}
+
+/**
+ * In MSI mode a level source is forwarded once and its pending bit cleared.
+ * If the device still asserts it, only setipnum makes it pending again.
+ */
+void aplic_handled(unsigned id)
+{
+    if (aplic_is_source(id)) {
+        aplic->setipnum_le = id;
+    }
+}
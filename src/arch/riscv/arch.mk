@@ -12,8 +12,42 @@ else
 $(error RISC-V $(ARCH_SUB) not supported!)
 endif
 
+# Optional vector extension. Enables the vector unit at boot, preserves the
+# vector state across interrupts and builds the RVV string/checksum routines.
+ifeq ($(RVV), y)
+riscv_march:=$(riscv_march)cv
+endif
+
 ARCH_GENERIC_FLAGS = -mcmodel=medany -march=$(riscv_march) -mabi=$(riscv_abi)
 ARCH_ASFLAGS = 
 ARCH_CFLAGS = 
 ARCH_CPPFLAGS =	
+
+ifeq ($(RVV), y)
+ARCH_CPPFLAGS+=-DRVV
+endif
+
+# Interrupt controller, set by the platform: the PLIC, or the AIA's APLIC in
+# MSI mode with per-hart IMSICs.
+IRQC?=PLIC
+ifeq ($(IRQC), AIA)
+ARCH_CPPFLAGS+=-DIRQC_AIA
+else ifneq ($(IRQC), PLIC)
+$(error RISC-V interrupt controller $(IRQC) not supported!)
+endif
+
+# Optional paging. By default the guest runs in Bare mode.
+ifeq ($(MMU), sv39)
+ARCH_CPPFLAGS+=-DMMU -DMMU_SV39
+else ifeq ($(MMU), sv48)
+ARCH_CPPFLAGS+=-DMMU -DMMU_SV48
+else ifneq ($(MMU),)
+$(error RISC-V MMU mode $(MMU) not supported!)
+endif
+
+ifneq ($(MMU),)
+ifneq ($(ARCH_SUB), riscv64)
+$(error RISC-V paging is only supported for riscv64!)
+endif
+endif
 ARCH_LDFLAGS = --specs=nano.specs
@@ -0,0 +1,109 @@
+#include <cache.h>
+#include <cpu.h>
+#include <csrs.h>
+#include <fences.h>
+#include <plat.h>
+#include <string.h>
+
+#ifndef PLAT_CACHE_BLOCK_SIZE
+#define PLAT_CACHE_BLOCK_SIZE (64)
+#endif
+
+/**
+ * Zicbom/Zicboz operate on cache blocks whose size is not discoverable from
+ * S-mode. It is given by the platform, or by riscv,cbom-block-size in the dt
+ * (see cpu_isa_discover).
+ */
+size_t cache_block_size = PLAT_CACHE_BLOCK_SIZE;
+
+#define CBO_INVAL   (0)
+#define CBO_CLEAN   (1)
+#define CBO_FLUSH   (2)
+#define CBO_ZERO    (4)
+
+#define CBO(OP, ADDR) \
+    asm volatile(".insn i 0x0f, 0x2, x0, %0, " XSTR(OP) "\n\t" \
+        :: "r"(ADDR) : "memory")
+
+size_t cache_line_size()
+{
+    return cache_block_size;
+}
+
+/**
+ * Without Zicbom there are no means for S-mode to maintain the caches and we
+ * assume the platform to be coherent, thus only ordering is needed.
+ */
+
+void cache_clean_range(void* addr, size_t size)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZICBOM)) {
+        size_t line = cache_block_size;
+        uintptr_t end = (uintptr_t)addr + size;
+        for (uintptr_t l = (uintptr_t)addr & ~(line - 1); l < end; l += line) {
+            CBO(CBO_CLEAN, l);
+        }
+    }
+    fence_sync();
+}
+
+void cache_flush_range(void* addr, size_t size)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZICBOM)) {
+        size_t line = cache_block_size;
+        uintptr_t end = (uintptr_t)addr + size;
+        for (uintptr_t l = (uintptr_t)addr & ~(line - 1); l < end; l += line) {
+            CBO(CBO_FLUSH, l);
+        }
+    }
+    fence_sync();
+}
+
+void cache_inval_range(void* addr, size_t size)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZICBOM) && size > 0) {
+        size_t line = cache_block_size;
+        uintptr_t start = (uintptr_t)addr;
+        uintptr_t end = start + size;
+
+        fence_sync();
+
+        if (start & (line - 1)) {
+            start &= ~(line - 1);
+            CBO(CBO_FLUSH, start);
+            start += line;
+        }
+
+        if ((end & (line - 1)) && (end & ~(line - 1)) >= start) {
+            end &= ~(line - 1);
+            CBO(CBO_FLUSH, end);
+        }
+
+        for (uintptr_t l = start; l < end; l += line) {
+            CBO(CBO_INVAL, l);
+        }
+    }
+    fence_sync();
+}
+
+void mem_zero_lines(void* addr, size_t size)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZICBOZ)) {
+        size_t block = cache_block_size;
+        uintptr_t start = (uintptr_t)addr;
+        uintptr_t end = start + size;
+        uintptr_t zstart = (start + block - 1) & ~(block - 1);
+        uintptr_t zend = end & ~(block - 1);
+
+        if (zstart < zend) {
+            memset(addr, 0, zstart - start);
+            for (uintptr_t b = zstart; b < zend; b += block) {
+                CBO(CBO_ZERO, b);
+            }
+            memset((void*)zend, 0, end - zend);
+            return;
+        }
+    }
+
+    memset(addr, 0, size);
+}
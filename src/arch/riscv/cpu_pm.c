@@ -0,0 +1,86 @@
+#include <cpu_pm.h>
+#include <cpu.h>
+#include <csrs.h>
+#include <sbi.h>
+#ifdef IRQC_AIA
+#include <imsic.h>
+#endif
+
+struct cpu_pm_state {
+    /* fs0-fs11 are saved with 8 byte stores, also on rv32 */
+    unsigned long ctx[ARCH_CPU_CTX_SIZE / sizeof(unsigned long)]
+        __attribute__((aligned(8)));
+    unsigned long sie;
+    uint64_t stimecmp;
+};
+
+static struct cpu_pm_state cpu_pm_states[NR_CPUS];
+
+/**
+ * The PLIC and APLIC are not per hart, only the local enables and Sstc's
+ * compare. The IMSIC file is set up again, its CSRs may not survive.
+ */
+static struct cpu_pm_state* cpu_pm_save()
+{
+    struct cpu_pm_state* state = &cpu_pm_states[get_cpuid()];
+
+    state->sie = csrs_sie_read();
+    if (CPU_HAS_EXTENSION(CPU_EXT_SSTC)) {
+        state->stimecmp = csrs_stimecmp_read();
+    }
+
+    return state;
+}
+
+static void cpu_pm_restore(struct cpu_pm_state* state)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_SSTC)) {
+        csrs_stimecmp_write(state->stimecmp);
+    }
+#ifdef IRQC_AIA
+    imsic_init();
+#endif
+    csrs_sie_write(state->sie);
+}
+
+int cpu_powerdown(unsigned long suspend_type)
+{
+    struct cpu_pm_state* state = cpu_pm_save();
+
+    if (cpu_ctx_save(state->ctx) == 0) {
+        return sbi_hart_suspend(suspend_type, (unsigned long)_cpu_resume,
+            (unsigned long)state->ctx).error == SBI_SUCCESS ? 0 : -1;
+    }
+
+    cpu_pm_restore(state);
+    return 1;
+}
+
+int cpu_off()
+{
+    struct cpu_pm_state* state = cpu_pm_save();
+
+    if (cpu_ctx_save(state->ctx) == 0) {
+        sbi_hart_stop();
+        return -1;
+    }
+
+    cpu_pm_restore(state);
+    return 1;
+}
+
+int cpu_on(unsigned long cpu)
+{
+    if (cpu >= NR_CPUS) {
+        return -1;
+    }
+
+    return sbi_hart_start(cpu, (unsigned long)_cpu_resume,
+        (unsigned long)cpu_pm_states[cpu].ctx).error == SBI_SUCCESS ? 0 : -1;
+}
+
+bool cpu_is_off(unsigned long cpu)
+{
+    struct sbiret ret = sbi_hart_status(cpu);
+    return ret.error == SBI_SUCCESS && ret.value == SBI_HSM_STATE_STOPPED;
+}
@@ -1,7 +1,14 @@
 #include <core.h>
 #include <csrs.h>
+#ifdef IRQC_AIA
+#include <imsic.h>
+#else
 #include <plic.h>
+#endif
 #include <irq.h>
+#ifdef RVV
+#include <vector.h>
+#endif
 
 static bool is_external(unsigned long cause) {
     switch(cause) {
@@ -13,18 +20,36 @@ static bool is_external(unsigned long cause) {
     }
 }
 
+/* With the scheduler the trap entry is in sched.S, which calls this */
+#ifdef SCHED
+void exception_handle(){
+#else
 __attribute__((interrupt("supervisor"), aligned(4)))
 void exception_handler(){
+#endif
     
+#ifdef RVV
+    unsigned long vs = rvv_irq_enter();
+#endif
+
     unsigned long scause = csrs_scause_read();
     if(is_external(scause)) {
+#ifdef IRQC_AIA
+        imsic_handle();
+#else
         plic_handle();
+#endif
     } else {
        size_t msb = sizeof(unsigned long) * 8 - 1;
        unsigned long id = (scause & ~(1ull << msb)) + 1024;
-       irq_handle(id);
+       /* Clear before handling so that an IPI sent meanwhile is not lost */
        if(id == IPI_IRQ_ID) {
            csrs_sip_clear(SIP_SSIE);
        }
+       irq_handle(id);
     }
+
+#ifdef RVV
+    rvv_irq_exit(vs);
+#endif
 }
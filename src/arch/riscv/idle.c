@@ -0,0 +1,43 @@
+#include <idle.h>
+#include <cpu_pm.h>
+#include <sbi.h>
+#include <wfi.h>
+
+static bool idle_wfi(const struct idle_state* state)
+{
+    wfi();
+    return true;
+}
+
+static bool idle_retention(const struct idle_state* state)
+{
+    return sbi_hart_suspend(state->param, 0, 0).error == SBI_SUCCESS;
+}
+
+static bool idle_powerdown(const struct idle_state* state)
+{
+    return cpu_powerdown(state->param) >= 0;
+}
+
+const struct idle_state idle_states[] = {
+    {
+        .name = "wfi",
+        .enter = idle_wfi,
+    },
+    {
+        .name = "retention",
+        .exit_latency_us = PLAT_IDLE_RETENTION_LATENCY_US,
+        .target_residency_us = PLAT_IDLE_RETENTION_RESIDENCY_US,
+        .enter = idle_retention,
+        .param = PLAT_SBI_RETENTION_STATE,
+    },
+    {
+        .name = "powerdown",
+        .exit_latency_us = PLAT_IDLE_POWERDOWN_LATENCY_US,
+        .target_residency_us = PLAT_IDLE_POWERDOWN_RESIDENCY_US,
+        .enter = idle_powerdown,
+        .param = PLAT_SBI_POWERDOWN_STATE,
+    },
+};
+
+const size_t idle_states_num = sizeof(idle_states) / sizeof(idle_states[0]);
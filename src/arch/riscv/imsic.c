@@ -0,0 +1,95 @@
+#include <imsic.h>
+#include <irq.h>
+#include <cpu.h>
+#include <csrs.h>
+#include <fdt.h>
+#include <bitmap.h>
+
+volatile imsic_file_t* imsic = (void*)IMSIC_BASE;
+
+/* Supervisor external interrupt, as the cause in interrupts-extended */
+#define IMSIC_IRQ_S_EXT (9)
+
+static inline uint32_t imsic_fdt32(const uint32_t* cell)
+{
+    const uint8_t* b = (const uint8_t*)cell;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+        ((uint32_t)b[2] << 8) | b[3];
+}
+
+void imsic_fdt_discover()
+{
+    uint64_t addr;
+    int node = -1;
+    int len;
+
+    /* Skip the machine-level files, if the firmware left them visible */
+    while ((node = fdt_node_offset_by_compatible(node, "riscv,imsics")) >= 0) {
+        const uint32_t* irqs = fdt_getprop(node, "interrupts-extended", &len);
+        if (fdt_node_is_available(node) && irqs != NULL && len >= 8 &&
+            imsic_fdt32(&irqs[1]) == IMSIC_IRQ_S_EXT) {
+            break;
+        }
+    }
+
+    if (node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        imsic = (void*)(uintptr_t)addr;
+    }
+}
+
+static inline void imsic_csr_write(unsigned long reg, unsigned long val)
+{
+    csrs_siselect_write(reg);
+    csrs_sireg_write(val);
+}
+
+/* Claims the highest priority pending EIID, i.e. the lowest */
+static inline unsigned long imsic_claim()
+{
+    unsigned long topei;
+    asm volatile("csrrw %0, " XSTR(CSR_STOPEI) ", zero\n\t"
+        : "=r"(topei) :: "memory");
+    return topei >> IMSIC_TOPEI_ID_OFF;
+}
+
+/**
+ * The eie/eip registers are XLEN wide, so on rv64 only the even numbered
+ * ones exist.
+ */
+void imsic_init()
+{
+    size_t regs = BITMAP_WORDS(IMSIC_NUM_IDS + 1);
+
+    imsic_csr_write(IMSIC_EIDELIVERY, 0);
+    imsic_csr_write(IMSIC_EITHRESHOLD, 0);
+
+    for (size_t i = 0; i < regs; i++) {
+        unsigned long eie = 0;
+        for (size_t id = i * BITS_PER_LONG;
+            id < (i + 1) * BITS_PER_LONG && id <= IMSIC_IPI_ID; id++) {
+            if (id > 0) eie |= BITMAP_BIT(id);
+        }
+        imsic_csr_write(IMSIC_EIE0 + i * (BITS_PER_LONG / 32), eie);
+    }
+
+    imsic_csr_write(IMSIC_EIDELIVERY, 1);
+}
+
+void imsic_handle()
+{
+    unsigned long id;
+
+    while ((id = imsic_claim()) != 0) {
+        if (id == IMSIC_IPI_ID) {
+            irq_handle(IPI_IRQ_ID);
+        } else {
+            irq_handle(id);
+            aplic_handled(id);
+        }
+    }
+}
+
+void imsic_send_ipi(unsigned long hart)
+{
+    imsic[hart].seteipnum_le = IMSIC_IPI_ID;
+}
@@ -0,0 +1,37 @@
+#ifndef ACLINT_H
+#define ACLINT_H
+
+#include <core.h>
+#include <plat.h>
+
+/**
+ * ACLINT supervisor software interrupt device (SSWI): writing 1 to a hart's
+ * SETSSIP register raises its supervisor software interrupt, without going
+ * through the firmware. The hart acknowledges it by clearing sip.SSIP, as
+ * for IPIs sent by the SBI.
+ *
+ * The block comes from the platform (PLAT_ACLINT_SSWI_BASE) or from a
+ * "riscv,aclint-sswi" device tree node, which takes precedence. Without
+ * either, IPIs fall back to sbi_send_ipi. Registers are indexed by hart id,
+ * i.e. a single block for all harts.
+ */
+
+#define ACLINT_SSWI_MAX_HARTS   (4095)
+
+extern volatile uint32_t* aclint_sswi;
+
+void aclint_fdt_discover();
+
+static inline bool aclint_sswi_present()
+{
+    return aclint_sswi != NULL;
+}
+
+static inline void aclint_sswi_send(unsigned long hart)
+{
+    if (hart < ACLINT_SSWI_MAX_HARTS) {
+        aclint_sswi[hart] = 1;
+    }
+}
+
+#endif /* ACLINT_H */
@@ -0,0 +1,95 @@
+#ifndef APLIC_H
+#define APLIC_H
+
+#include <core.h>
+#include <plat.h>
+
+/**
+ * Advanced Platform-Level Interrupt Controller, supervisor domain, built
+ * with IRQC=AIA. The domain runs in MSI delivery mode: a pending source is
+ * forwarded as a write of its EIID to the target hart's IMSIC, so there is
+ * no claim/complete. Source i is sent as EIID i, its interrupt id, which is
+ * what the IMSIC hands back. The firmware owns the machine domain, which
+ * must delegate the sources and set up the MSI addresses for this one.
+ */
+
+#ifdef STD_ADDR_SPACE
+#undef PLAT_APLIC_BASE
+#endif
+
+#ifdef PLAT_APLIC_BASE
+#define APLIC_BASE  PLAT_APLIC_BASE
+#else
+#define APLIC_BASE  (0xd000000)
+#endif
+
+/* Sources 1..APLIC_NUM_SOURCES-1, from the platform */
+#ifdef PLAT_APLIC_NUM_SOURCES
+#define APLIC_NUM_SOURCES   PLAT_APLIC_NUM_SOURCES
+#else
+#define APLIC_NUM_SOURCES   (96)
+#endif
+
+#define APLIC_MAX_SOURCES   (1024)
+
+#define APLIC_DOMAINCFG_IE_BIT      (1U << 8)
+#define APLIC_DOMAINCFG_DM_BIT      (1U << 2)
+#define APLIC_DOMAINCFG_BE_BIT      (1U << 0)
+
+#define APLIC_SOURCECFG_D_BIT       (1U << 10)
+#define APLIC_SOURCECFG_SM_INACTIVE (0)
+#define APLIC_SOURCECFG_SM_EDGE1    (4)
+#define APLIC_SOURCECFG_SM_LEVEL1   (6)
+
+#define APLIC_TARGET_HART_OFF       (18)
+#define APLIC_TARGET_EIID_MSK       (0x7ff)
+
+typedef struct {
+    uint32_t domaincfg;
+    uint32_t sourcecfg[APLIC_MAX_SOURCES - 1];
+    uint8_t res0[0x1bc0 - 0x1000];
+    uint32_t mmsiaddrcfg;
+    uint32_t mmsiaddrcfgh;
+    uint32_t smsiaddrcfg;
+    uint32_t smsiaddrcfgh;
+    uint8_t res1[0x1c00 - 0x1bd0];
+    uint32_t setip[APLIC_MAX_SOURCES / 32];
+    uint8_t res2[0x1cdc - 0x1c80];
+    uint32_t setipnum;
+    uint8_t res3[0x1d00 - 0x1ce0];
+    uint32_t in_clrip[APLIC_MAX_SOURCES / 32];
+    uint8_t res4[0x1ddc - 0x1d80];
+    uint32_t clripnum;
+    uint8_t res5[0x1e00 - 0x1de0];
+    uint32_t setie[APLIC_MAX_SOURCES / 32];
+    uint8_t res6[0x1edc - 0x1e80];
+    uint32_t setienum;
+    uint8_t res7[0x1f00 - 0x1ee0];
+    uint32_t clrie[APLIC_MAX_SOURCES / 32];
+    uint8_t res8[0x1fdc - 0x1f80];
+    uint32_t clrienum;
+    uint8_t res9[0x2000 - 0x1fe0];
+    uint32_t setipnum_le;
+    uint32_t setipnum_be;
+    uint8_t res10[0x3000 - 0x2008];
+    uint32_t genmsi;
+    uint32_t target[APLIC_MAX_SOURCES - 1];
+} aplic_t;
+
+extern volatile aplic_t* aplic;
+
+void aplic_fdt_discover();
+void aplic_init();
+/* Routes the source to the hart's IMSIC and enables it */
+void aplic_enable_interrupt(unsigned long hart, unsigned id, bool en);
+/* Moves the sources routed to hart from to hart to */
+void aplic_migrate(unsigned long from, unsigned long to);
+/* After handling, resends a level source still asserted */
+void aplic_handled(unsigned id);
+
+static inline bool aplic_is_source(unsigned long id)
+{
+    return id > 0 && id < APLIC_NUM_SOURCES;
+}
+
+#endif /* APLIC_H */
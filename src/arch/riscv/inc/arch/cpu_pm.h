@@ -0,0 +1,14 @@
+#ifndef ARCH_CPU_PM_H
+#define ARCH_CPU_PM_H
+
+#include <core.h>
+#include <csrs.h>
+
+/* Bytes saved by cpu_ctx_save, see start.S */
+#ifdef __riscv_flen
+#define ARCH_CPU_CTX_SIZE   (16 * REGLEN + 12 * 8)
+#else
+#define ARCH_CPU_CTX_SIZE   (14 * REGLEN)
+#endif
+
+#endif /* ARCH_CPU_PM_H */
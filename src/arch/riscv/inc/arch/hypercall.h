@@ -0,0 +1,14 @@
+#ifndef ARCH_HYPERCALL_H
+#define ARCH_HYPERCALL_H
+
+#include <core.h>
+#include <sbi.h>
+
+/* Bao hypercalls are an SBI extension with the hypercall id as function id */
+static inline long arch_hypercall(unsigned long id, unsigned long arg0,
+    unsigned long arg1, unsigned long arg2)
+{
+    return sbi_bao_hypercall(id, arg0, arg1, arg2).error;
+}
+
+#endif
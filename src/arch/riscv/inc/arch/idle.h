@@ -0,0 +1,15 @@
+#ifndef ARCH_IDLE_H
+#define ARCH_IDLE_H
+
+#include <core.h>
+#include <plat.h>
+
+/* SBI HSM hart_suspend suspend_type of the idle states */
+#ifndef PLAT_SBI_RETENTION_STATE
+#define PLAT_SBI_RETENTION_STATE    (0x00000000UL)
+#endif
+#ifndef PLAT_SBI_POWERDOWN_STATE
+#define PLAT_SBI_POWERDOWN_STATE    (0x80000000UL)
+#endif
+
+#endif /* ARCH_IDLE_H */
@@ -1,10 +1,35 @@
 #ifndef ARCH_IRQ_H
 #define ARCH_IRQ_H
 
+#include <csrs.h>
+
 #define IPI_IRQ_ID (1025)
 #define TIMER_IRQ_ID (1029)
 
 #define IRQ_NUM (1030)
 #define IRQ_MAX_PRIO (-1)
 
+#ifndef __ASSEMBLER__
+
+/* Local interrupt masking, arch_irq_save returns the state to restore */
+static inline unsigned long arch_irq_save()
+{
+    unsigned long flags;
+    asm volatile("csrrci %0, sstatus, %1\n\t"
+        : "=r"(flags) : "i"(SSTATUS_SIE) : "memory");
+    return flags & SSTATUS_SIE;
+}
+
+static inline void arch_irq_restore(unsigned long flags)
+{
+    asm volatile("csrs sstatus, %0\n\t" :: "r"(flags) : "memory");
+}
+
+static inline void arch_irq_enable()
+{
+    asm volatile("csrsi sstatus, %0\n\t" :: "i"(SSTATUS_SIE) : "memory");
+}
+
+#endif /* __ASSEMBLER__ */
+
 #endif /* ARCH_IRQ_H */
@@ -0,0 +1,19 @@
+#ifndef ARCH_SCHED_H
+#define ARCH_SCHED_H
+
+#include <core.h>
+#include <csrs.h>
+
+/**
+ * Frame pushed by sched_ctx_switch: ra, s0-s11 and fcsr followed, if there
+ * is an FPU, by fs0-fs11. New threads start with a zeroed frame returning to
+ * their entry point.
+ */
+#ifdef __riscv_flen
+#define ARCH_CTX_SIZE   (16 * REGLEN + 12 * 8)
+#else
+#define ARCH_CTX_SIZE   (16 * REGLEN)
+#endif
+#define ARCH_CTX_LR     (0)
+
+#endif /* ARCH_SCHED_H */
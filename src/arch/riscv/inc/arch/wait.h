@@ -0,0 +1,44 @@
+#ifndef ARCH_WAIT_H
+#define ARCH_WAIT_H
+
+#include <core.h>
+#include <cpu.h>
+#include <plat.h>
+
+/**
+ * With Zawrs, waits in wrs.nto on a word's reservation, or for a short,
+ * implementation defined, time in wrs.sto. Otherwise spins with pause hints.
+ * A wrs.nto wait is only bounded by a write to the word or an interrupt.
+ */
+#define ARCH_WAIT_BOUNDED   (0)
+
+static inline void arch_wait_event()
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZAWRS)) {
+        /* wrs.sto */
+        asm volatile(".insn i 0x73, 0, x0, x0, 0x01d\n\t" ::: "memory");
+    } else {
+        /* pause */
+        asm volatile(".insn i 0x0f, 0, x0, x0, 0x010\n\t" ::: "memory");
+    }
+}
+
+static inline void arch_wait_notify()
+{
+}
+
+static inline void arch_wait_word(const volatile uint32_t* addr, uint32_t val)
+{
+    if (CPU_HAS_EXTENSION(CPU_EXT_ZAWRS)) {
+        uint32_t cur;
+        asm volatile("lr.w %0, (%1)\n\t" : "=&r"(cur) : "r"(addr) : "memory");
+        if (cur == val) {
+            /* wrs.nto */
+            asm volatile(".insn i 0x73, 0, x0, x0, 0x00d\n\t" ::: "memory");
+        }
+    } else {
+        arch_wait_event();
+    }
+}
+
+#endif /* ARCH_WAIT_H */
@@ -4,7 +4,31 @@
 #include <core.h>
 #include <util.h>
 
-#define CPU_HAS_EXTENSION(EXT) (DEFINED(EXT))
+/**
+ * ISA extensions, known at build time if the platform defines CPU_EXT_<X>,
+ * which lets the compiler drop the fallback, or else found at boot by
+ * cpu_isa_discover. The bits are written once, by the primary hart before
+ * the others run C code, so testing one is a load and a branch.
+ */
+enum cpu_ext_id {
+    CPU_EXT_SSTC_ID,
+    CPU_EXT_ZICBOM_ID,
+    CPU_EXT_ZICBOZ_ID,
+    CPU_EXT_ZAWRS_ID,
+    CPU_EXT_SVPBMT_ID,
+    CPU_EXT_V_ID,
+    CPU_EXT_NUM
+};
+
+extern unsigned long cpu_isa;
+
+#define CPU_HAS_EXTENSION(EXT) (DEFINED(EXT) || ((cpu_isa >> EXT##_ID) & 1))
+
+/**
+ * Sets cpu_isa to the extensions every hart in the device tree has. Called
+ * by the primary hart, before the page tables are built if there are any.
+ */
+void cpu_isa_discover();
 
 extern int primary_hart;
 
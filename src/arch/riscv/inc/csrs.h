@@ -96,6 +96,15 @@
 #define SSTATUS_UPIE    (1ULL << 4)
 #define SSTATUS_SPIE    (1ULL << 5)
 #define SSTATUS_SPP     (1ULL << 8)
+#define SSTATUS_VS_OFF  (9)
+#define SSTATUS_VS_MSK  (3ULL << SSTATUS_VS_OFF)
+#define SSTATUS_VS_OFF_STATE    (0ULL << SSTATUS_VS_OFF)
+#define SSTATUS_VS_INITIAL      (1ULL << SSTATUS_VS_OFF)
+#define SSTATUS_VS_CLEAN        (2ULL << SSTATUS_VS_OFF)
+#define SSTATUS_VS_DIRTY        (3ULL << SSTATUS_VS_OFF)
+#define SSTATUS_FS_OFF  (13)
+#define SSTATUS_FS_MSK  (3ULL << SSTATUS_FS_OFF)
+#define SSTATUS_FS_INITIAL      (1ULL << SSTATUS_FS_OFF)
 
 #define SIE_USIE    (1ULL << 0)
 #define SIE_SSIE    (1ULL << 1)
@@ -137,6 +146,14 @@
 #define CSR_STIMECMP      0x14D
 #define CSR_STIMECMPH     0x15D
 
+/* Smaia/Ssaia supervisor CSRs, numbers for older assemblers */
+#define CSR_SISELECT      0x150
+#define CSR_SIREG         0x151
+#define CSR_STOPEI        0x15C
+#define CSR_STOPI         0xDB0
+
+#ifndef __ASSEMBLER__
+
 #define STR(s)  #s
 #define XSTR(s)  STR(s)
 
@@ -179,6 +196,7 @@ CSRS_GEN_ACCESSORS(sstatus);
 CSRS_GEN_ACCESSORS(sie);
 CSRS_GEN_ACCESSORS(sip);
 CSRS_GEN_ACCESSORS(scause);
+CSRS_GEN_ACCESSORS(satp);
 
 #if (RV64)
 CSRS_GEN_ACCESSORS(time);
@@ -192,5 +210,14 @@ CSRS_GEN_ACCESSORS_NAMED(stimecmph, CSR_STIMECMPH);
 CSRS_GEN_ACCESSORS_MERGED(stimecmp, stimecmpl, stimecmph);
 #endif
 
+CSRS_GEN_ACCESSORS_NAMED(siselect, CSR_SISELECT);
+CSRS_GEN_ACCESSORS_NAMED(sireg, CSR_SIREG);
+
+#ifdef RVV
+CSRS_GEN_ACCESSORS(vlenb);
+#endif
+
+#endif /* __ASSEMBLER__ */
+
 
 #endif /* __ARCH_CSRS_H__ */
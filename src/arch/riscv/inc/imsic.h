@@ -0,0 +1,66 @@
+#ifndef IMSIC_H
+#define IMSIC_H
+
+#include <core.h>
+#include <plat.h>
+#include <aplic.h>
+
+/**
+ * Incoming MSI Controller, supervisor interrupt files, built with IRQC=AIA.
+ * Each hart has its own file, a page at IMSIC_BASE + hart * IMSIC_FILE_SIZE,
+ * where writing an EIID to seteipnum_le makes it pending there. The hart
+ * configures and claims from its own file through the siselect/sireg and
+ * stopei CSRs, so taking an interrupt needs no MMIO at all.
+ *
+ * EIIDs 1..APLIC_NUM_SOURCES-1 are the wired sources, forwarded by the
+ * APLIC, and are enabled on every hart: the APLIC target decides which hart
+ * gets each. IMSIC_IPI_ID, right above, carries the IPIs.
+ */
+
+#ifdef STD_ADDR_SPACE
+#undef PLAT_IMSIC_BASE
+#endif
+
+#ifdef PLAT_IMSIC_BASE
+#define IMSIC_BASE  PLAT_IMSIC_BASE
+#else
+#define IMSIC_BASE  (0x28000000)
+#endif
+
+/* Highest EIID, at least 63 */
+#ifdef PLAT_IMSIC_NUM_IDS
+#define IMSIC_NUM_IDS   PLAT_IMSIC_NUM_IDS
+#else
+#define IMSIC_NUM_IDS   (255)
+#endif
+
+#define IMSIC_FILE_SIZE (0x1000)
+#define IMSIC_IPI_ID    (APLIC_NUM_SOURCES)
+
+#if IMSIC_IPI_ID > IMSIC_NUM_IDS
+#error "the IMSIC has no EIID left for IPIs past the APLIC sources"
+#endif
+
+/* Indirect registers, through siselect */
+#define IMSIC_EIDELIVERY    (0x70)
+#define IMSIC_EITHRESHOLD   (0x72)
+#define IMSIC_EIP0          (0x80)
+#define IMSIC_EIE0          (0xc0)
+
+#define IMSIC_TOPEI_ID_OFF  (16)
+
+typedef struct {
+    uint32_t seteipnum_le;
+    uint32_t seteipnum_be;
+    uint8_t res[IMSIC_FILE_SIZE - 0x8];
+} imsic_file_t;
+
+extern volatile imsic_file_t* imsic;
+
+void imsic_fdt_discover();
+/* Per hart, also on the way back from a non-retentive suspend */
+void imsic_init();
+void imsic_handle();
+void imsic_send_ipi(unsigned long hart);
+
+#endif /* IMSIC_H */
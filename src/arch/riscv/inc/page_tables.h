@@ -1,16 +1,32 @@
 #ifndef PAGE_TABLES_H
 #define PAGE_TABLES_H
 
+#include <core.h>
+#include <bit.h>
+#include <csrs.h>
+
 #define PAGE_SIZE 0x1000ULL
 #define PT_SIZE (PAGE_SIZE)
 #define PAGE_ADDR_MSK (~(PAGE_SIZE - 1))
 #define PAGE_SHIFT (12)
-#define SUPERPAGE_SIZE(N) ((PAGE_SIZE) << (((2-N))*9))
+#define PT_ENTRIES (PT_SIZE / sizeof(pte_t))
+
+#ifdef MMU_SV48
+#define PT_LVLS (4)
+#define PT_SATP_MODE SATP_MODE_48
+#else
+#define PT_LVLS (3)
+#define PT_SATP_MODE SATP_MODE_39
+#endif
 
-#define PT_LVLS (3)  // assumes sv39 for rv64
 #define PTE_INDEX_SHIFT(LEVEL) ((9 * (PT_LVLS - 1 - (LEVEL))) + 12)
+#define PT_LVL_SIZE(LEVEL) (1ULL << PTE_INDEX_SHIFT(LEVEL))
+#define SUPERPAGE_SIZE(N) PT_LVL_SIZE((N) + (PT_LVLS - 3))
 #define PTE_ADDR_MSK BIT_MASK(12, 44)
 
+/* Leaf entries are only used up to gigapages, i.e. the last three levels */
+#define PT_LEAF_MIN_LVL (PT_LVLS - 3)
+
 #define PTE_INDEX(LEVEL, ADDR) (((ADDR) >> PTE_INDEX_SHIFT(LEVEL)) & (0x1FF))
 #define PTE_FLAGS_MSK BIT_MASK(0, 8)
 
@@ -36,12 +52,36 @@
 #define PTE_RSW_LEN 2
 #define PTE_RSW_MSK BIT_MASK(PTE_RSW_OFF, PTE_RSW_LEN)
 
+#define PTE_PPN_OFF 10
+#define PTE_PPN_LEN 44
+#define PTE_PPN_MSK BIT_MASK(PTE_PPN_OFF, PTE_PPN_LEN)
+
+/* Svpbmt page-based memory types. Must be zero if Svpbmt is not present. */
+#define PTE_PBMT_OFF 61
+#define PTE_PBMT_LEN 2
+#define PTE_PBMT_MSK BIT_MASK(PTE_PBMT_OFF, PTE_PBMT_LEN)
+#define PTE_PBMT_PMA (0ULL << PTE_PBMT_OFF)
+#define PTE_PBMT_NC (1ULL << PTE_PBMT_OFF)
+#define PTE_PBMT_IO (2ULL << PTE_PBMT_OFF)
+
 #define PTE_TABLE (0)
 #define PTE_PAGE (PTE_RWX)
 #define PTE_SUPERPAGE (PTE_PAGE)
 
+#define PTE_MEM_FLAGS (PTE_V | PTE_RWX | PTE_AD | PTE_GLOBAL)
+#define PTE_DEV_FLAGS (PTE_V | PTE_RW | PTE_AD | PTE_GLOBAL)
+
 typedef unsigned long pte_t;
 
+enum pt_mem_type {
+    PT_MEM_NORMAL,  /* cacheable memory, PMA attributes */
+    PT_MEM_NC,      /* non-cacheable, idempotent memory */
+    PT_MEM_IO,      /* non-cacheable, non-idempotent, strongly ordered */
+};
+
+extern unsigned long pt_satp;
+
 void pt_init();
+int pt_set_mem_type(uintptr_t addr, size_t size, enum pt_mem_type type);
 
 #endif /* PAGE_TABLES_H */
@@ -65,8 +65,11 @@ extern volatile plic_global_t * plic_global;
 extern volatile plic_hart_t *plic_hart;
 
 void plic_init();
+void plic_fdt_discover();
 void plic_handle();
 void plic_enable_interrupt(int cntxt, int int_id, bool en);
+/* Moves the interrupts enabled for hart from to hart to */
+void plic_migrate(int from, int to);
 void plic_set_prio(int int_id, int prio);
 
 #endif /* __PLIC_H__ */
@@ -15,6 +15,12 @@
 #define SBI_ERR_INVALID_ADDRESS (-5)
 #define SBI_ERR_ALREADY_AVAILABLE (-6)
 
+#define SBI_HSM_STATE_STARTED (0)
+#define SBI_HSM_STATE_STOPPED (1)
+#define SBI_HSM_STATE_START_PENDING (2)
+#define SBI_HSM_STATE_STOP_PENDING (3)
+#define SBI_HSM_STATE_SUSPENDED (4)
+
 struct sbiret {
     long error;
     long value;
@@ -75,5 +81,10 @@ struct sbiret sbi_hart_start(unsigned long hartid, unsigned long start_addr,
                              unsigned long priv);
 struct sbiret sbi_hart_stop();
 struct sbiret sbi_hart_status(unsigned long hartid);
+struct sbiret sbi_hart_suspend(uint32_t suspend_type, unsigned long resume_addr,
+                               unsigned long opaque);
+
+struct sbiret sbi_bao_hypercall(unsigned long id, unsigned long arg0,
+                                unsigned long arg1, unsigned long arg2);
 
 #endif /* __SBI_H__ */
@@ -41,10 +41,11 @@ static inline void spin_lock(spinlock_t* lock){
 
 static inline void spin_unlock(spinlock_t* lock){
 
+    /* Release: the critical section must be visible before the lock is */
     asm volatile (
+        "fence rw, w\n\t"
         "sw zero, %0\n\t"
-        "fence rw, rw\n\t"  //Is the full blown barrier really needed?
-        :: "m"(*lock));
+        :: "m"(*lock) : "memory");
 }
 
 #endif /* __ARCH_SPINLOCK__ */
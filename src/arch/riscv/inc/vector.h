@@ -0,0 +1,56 @@
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <core.h>
+#include <csrs.h>
+
+/* Largest VLEN, in bits, the per-hart save areas are sized for */
+#ifndef RVV_VLEN_MAX
+#define RVV_VLEN_MAX (512)
+#endif
+
+#define RVV_CTX_SIZE ((32 * RVV_VLEN_MAX / 8) + (4 * REGLEN))
+
+#ifndef __ASSEMBLER__
+
+#include <cpu.h>
+
+extern uint8_t rvv_ctx[NR_CPUS][RVV_CTX_SIZE];
+
+void rvv_init();
+void rvv_save(void* ctx);
+void rvv_restore(void* ctx);
+
+/**
+ * Interrupt handlers may use vector instructions (e.g. auto-vectorized or
+ * RVV string functions) so the interrupted vector state is preserved. It is
+ * saved on entry only if sstatus.VS is Dirty, after which VS is set to Clean.
+ * While VS stays Clean the per-hart area matches the live state, so on exit
+ * it only needs to be restored if the handler dirtied it.
+ */
+static inline unsigned long rvv_irq_enter()
+{
+    unsigned long vs = csrs_sstatus_read() & SSTATUS_VS_MSK;
+
+    if (vs == SSTATUS_VS_DIRTY) {
+        rvv_save(rvv_ctx[get_cpuid()]);
+        csrs_sstatus_clear(SSTATUS_VS_MSK);
+        csrs_sstatus_set(SSTATUS_VS_CLEAN);
+    }
+
+    return vs;
+}
+
+static inline void rvv_irq_exit(unsigned long vs)
+{
+    if ((vs == SSTATUS_VS_DIRTY || vs == SSTATUS_VS_CLEAN) &&
+        (csrs_sstatus_read() & SSTATUS_VS_MSK) == SSTATUS_VS_DIRTY) {
+        rvv_restore(rvv_ctx[get_cpuid()]);
+        csrs_sstatus_clear(SSTATUS_VS_MSK);
+        csrs_sstatus_set(SSTATUS_VS_CLEAN);
+    }
+}
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* VECTOR_H */
@@ -1,9 +1,19 @@
 #include <core.h>
 #include <cpu.h>
 #include <page_tables.h>
+#ifdef IRQC_AIA
+#include <aplic.h>
+#include <imsic.h>
+#else
 #include <plic.h>
+#include <aclint.h>
+#endif
 #include <sbi.h>
 #include <csrs.h>
+#include <fdt.h>
+#ifdef RVV
+#include <vector.h>
+#endif
 
 extern void _start();
 
@@ -11,14 +21,43 @@ __attribute__((weak))
 void arch_init(){
 #ifndef SINGLE_CORE
     unsigned long hart_id = get_cpuid();
-    struct sbiret ret = (struct sbiret){ .error = SBI_SUCCESS };
-    size_t i = 0;    
-    do {
-        if(i == hart_id) continue;
-        ret = sbi_hart_start(i, (unsigned long) &_start, 0);
-    } while(i++, ret.error == SBI_SUCCESS);
+    if(fdt_cpu_num > 0) {
+        for(size_t i = 0; i < fdt_cpu_num; i++) {
+            if(fdt_cpu_ids[i] == hart_id) continue;
+            sbi_hart_start(fdt_cpu_ids[i], (unsigned long) &_start, 0);
+        }
+    } else {
+        /* No device tree, probe until the firmware refuses */
+        struct sbiret ret = (struct sbiret){ .error = SBI_SUCCESS };
+        size_t i = 0;    
+        do {
+            if(i == hart_id) continue;
+            ret = sbi_hart_start(i, (unsigned long) &_start, 0);
+        } while(i++, ret.error == SBI_SUCCESS);
+    }
 #endif
+#ifdef RVV
+    rvv_init();
+#endif
+#ifdef IRQC_AIA
+    if(cpu_is_master()) {
+        aplic_init();
+    }
+    imsic_init();
+#else
     plic_init();   
+#endif
     csrs_sie_set(SIE_SEIE);
     csrs_sstatus_set(SSTATUS_SIE);
 }
+
+void arch_fdt_discover(){
+    cpu_isa_discover();
+#ifdef IRQC_AIA
+    aplic_fdt_discover();
+    imsic_fdt_discover();
+#else
+    plic_fdt_discover();
+    aclint_fdt_discover();
+#endif
+}
@@ -1,12 +1,24 @@
 #include <irq.h>
 #include <cpu.h>
 #include <csrs.h>
-#include <plic.h>
 #include <sbi.h>
+#ifdef IRQC_AIA
+#include <aplic.h>
+#include <imsic.h>
+#include <fences.h>
+#else
+#include <plic.h>
+#include <aclint.h>
+#include <fences.h>
+#endif
 
 void irq_enable(unsigned id) {
     if(id < 1024) {
+#ifdef IRQC_AIA
+        aplic_enable_interrupt(get_cpuid(), id, true);
+#else
         plic_enable_interrupt(get_cpuid(), id, true);
+#endif
     } else if (id == TIMER_IRQ_ID) {
         csrs_sie_set(SIE_STIE);
     } else if (id == IPI_IRQ_ID) {
@@ -14,10 +26,67 @@ void irq_enable(unsigned id) {
     }
 }
 
+void irq_migrate(unsigned long from, unsigned long to) {
+#ifdef IRQC_AIA
+    aplic_migrate(from, to);
+#else
+    plic_migrate(from, to);
+#endif
+}
+
+/* With the AIA, priorities are fixed by EIID, the lower the higher */
 void irq_set_prio(unsigned id, unsigned prio) {
+#ifndef IRQC_AIA
     plic_set_prio(id, prio);
+#endif
+}
+
+#ifdef IRQC_AIA
+
+/* Straight to each hart's interrupt file, no firmware call */
+void irq_send_ipi(const cpumask_t* cpus) {
+    unsigned long cpu;
+
+    /* Orders the IPI's payload before the MMIO writes */
+    fence_sync();
+    for_each_cpu(cpu, cpus) {
+        imsic_send_ipi(cpu);
+    }
+}
+
+#else
+
+/**
+ * Cpu ids are hart ids. Through the ACLINT SSWI if there is one, else with
+ * the SBI, a window of a word of harts per call.
+ */
+void irq_send_ipi(const cpumask_t* cpus) {
+    unsigned long base, harts;
+
+    if (aclint_sswi_present()) {
+        unsigned long cpu;
+        fence_sync();
+        for_each_cpu(cpu, cpus) {
+            aclint_sswi_send(cpu);
+        }
+        return;
+    }
+
+    for (base = 0; (harts = cpumask_window(cpus, base, &base)) != 0;
+        base += BITS_PER_LONG) {
+        sbi_send_ipi(harts, base);
+    }
 }
 
-void irq_send_ipi(unsigned long target_cpu_mask) {
-    sbi_send_ipi(target_cpu_mask, 0);
+#endif
+
+/* No MSI controller */
+int irq_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id) {
+    return -1;
+}
+
+void irq_msi_free(uint32_t dev_id) { }
+
+int irq_msi_msg(unsigned id, struct irq_msi_msg* msg) {
+    return -1;
 }
@@ -0,0 +1,120 @@
+#include <cpu.h>
+#include <csrs.h>
+#include <fdt.h>
+#include <string.h>
+
+unsigned long cpu_isa;
+
+extern size_t cache_block_size;
+
+/* As in riscv,isa-extensions, and as the multi-letter ones of riscv,isa */
+static const char* const cpu_isa_names[CPU_EXT_NUM] = {
+    [CPU_EXT_SSTC_ID] = "sstc",
+    [CPU_EXT_ZICBOM_ID] = "zicbom",
+    [CPU_EXT_ZICBOZ_ID] = "zicboz",
+    [CPU_EXT_ZAWRS_ID] = "zawrs",
+    [CPU_EXT_SVPBMT_ID] = "svpbmt",
+    [CPU_EXT_V_ID] = "v",
+};
+
+static unsigned long cpu_isa_from_extensions(int cpu)
+{
+    unsigned long isa = 0;
+
+    for (size_t i = 0; i < CPU_EXT_NUM; i++) {
+        if (fdt_prop_has_string(cpu, "riscv,isa-extensions", cpu_isa_names[i])) {
+            isa |= 1UL << i;
+        }
+    }
+
+    return isa;
+}
+
+/**
+ * The older riscv,isa string, e.g. "rv64imafdcv_zicbom_sstc": single letter
+ * extensions follow the base, multi-letter ones are separated by '_'.
+ */
+static unsigned long cpu_isa_from_string(const char* str, size_t len)
+{
+    unsigned long isa = 0;
+    size_t i = 4;
+
+    if (len < 4 || strncmp(str, "rv", 2) != 0) return 0;
+
+    for (; i < len && str[i] != '_' && str[i] != '\0'; i++) {
+        if (str[i] == 'v') isa |= 1UL << CPU_EXT_V_ID;
+    }
+
+    while (i < len && str[i] == '_') {
+        size_t start = ++i;
+        while (i < len && str[i] != '_' && str[i] != '\0') i++;
+        for (size_t j = 0; j < CPU_EXT_NUM; j++) {
+            const char* name = cpu_isa_names[j];
+            if (strlen(name) > 1 && strlen(name) == i - start &&
+                strncmp(&str[start], name, i - start) == 0) {
+                isa |= 1UL << j;
+            }
+        }
+    }
+
+    return isa;
+}
+
+/* The extensions all cpus have, false if none is described */
+static bool cpu_isa_from_fdt(unsigned long* isa)
+{
+    int cpus = fdt_path_offset("/cpus");
+    bool found = false;
+    int cpu;
+
+    if (cpus < 0) return false;
+
+    *isa = ~0UL;
+    fdt_for_each_subnode(cpu, cpus) {
+        int len;
+        const char* str;
+
+        if (!fdt_prop_has_string(cpu, "device_type", "cpu") ||
+            !fdt_node_is_available(cpu)) {
+            continue;
+        }
+
+        if (fdt_getprop(cpu, "riscv,isa-extensions", NULL) != NULL) {
+            *isa &= cpu_isa_from_extensions(cpu);
+        } else if ((str = fdt_getprop(cpu, "riscv,isa", &len)) != NULL) {
+            *isa &= cpu_isa_from_string(str, len);
+        } else {
+            *isa = 0;
+        }
+        found = true;
+
+        uint32_t block = fdt_getprop_u32(cpu, "riscv,cbom-block-size", 0);
+        if (block != 0 && (block & (block - 1)) == 0) {
+            cache_block_size = block;
+        }
+    }
+
+    return found;
+}
+
+void cpu_isa_discover()
+{
+    static bool done = false;
+    unsigned long isa;
+
+    if (done) return;
+    done = true;
+
+    if (cpu_isa_from_fdt(&isa)) {
+        cpu_isa = isa & ((1UL << CPU_EXT_NUM) - 1);
+        return;
+    }
+
+    /* Without a device tree, a writable sstatus.VS tells there is a V unit */
+    unsigned long sstatus = csrs_sstatus_read();
+    csrs_sstatus_set(SSTATUS_VS_INITIAL);
+    if (csrs_sstatus_read() & SSTATUS_VS_MSK) {
+        cpu_isa |= 1UL << CPU_EXT_V_ID;
+    }
+    csrs_sstatus_write(sstatus);
+}
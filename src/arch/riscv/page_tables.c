@@ -0,0 +1,187 @@
+#include <core.h>
+#include <page_tables.h>
+#include <cpu.h>
+#include <csrs.h>
+#include <sbi.h>
+#include <spinlock.h>
+#include <fences.h>
+#include <plat.h>
+#include <fdt.h>
+#include <cache.h>
+
+/* Identity map the lower 256GB, i.e. the positive half of the Sv39 space */
+#define PT_IDMAP_SIZE (1ULL << 38)
+
+#ifndef PT_POOL_SIZE
+#define PT_POOL_SIZE (16)
+#endif
+
+static pte_t root_pt[PT_ENTRIES] __attribute__((aligned(PT_SIZE)));
+static pte_t pt_pool[PT_POOL_SIZE][PT_ENTRIES] __attribute__((aligned(PT_SIZE)));
+static size_t pt_pool_next;
+static spinlock_t pt_lock = SPINLOCK_INITVAL;
+
+unsigned long pt_satp;
+
+static inline void sfence_vma(uintptr_t addr, size_t size)
+{
+    asm volatile("sfence.vma\n\t" ::: "memory");
+    sbi_remote_sfence_vma(0, -1UL, addr, size);
+}
+
+static inline pte_t* pte_table(pte_t pte)
+{
+    return (pte_t*)(((pte & PTE_PPN_MSK) >> PTE_PPN_OFF) << PAGE_SHIFT);
+}
+
+static inline pte_t pte_make(uintptr_t addr, pte_t flags)
+{
+    return (((addr >> PAGE_SHIFT) << PTE_PPN_OFF) & PTE_PPN_MSK) | flags;
+}
+
+static inline bool pte_is_leaf(pte_t pte)
+{
+    return (pte & PTE_RWX) != 0;
+}
+
+static pte_t pt_type_flags(enum pt_mem_type type)
+{
+    pte_t flags, pbmt;
+
+    switch (type) {
+        case PT_MEM_NC:
+            flags = PTE_MEM_FLAGS;
+            pbmt = PTE_PBMT_NC;
+            break;
+        case PT_MEM_IO:
+            flags = PTE_DEV_FLAGS;
+            pbmt = PTE_PBMT_IO;
+            break;
+        default:
+            flags = PTE_MEM_FLAGS;
+            pbmt = PTE_PBMT_PMA;
+            break;
+    }
+
+    if (CPU_HAS_EXTENSION(CPU_EXT_SVPBMT)) {
+        flags |= pbmt;
+    }
+
+    return flags;
+}
+
+/**
+ * Replaces an invalid or leaf entry at level lvl with a next level table.
+ * A leaf is broken into PT_ENTRIES leaves with the same attributes so the
+ * translation does not change until the caller overwrites part of it.
+ */
+static int pt_split(pte_t *pte, size_t lvl)
+{
+    if (pt_pool_next >= PT_POOL_SIZE) {
+        return -1;
+    }
+
+    pte_t *table = pt_pool[pt_pool_next++];
+
+    if ((*pte & PTE_VALID) && pte_is_leaf(*pte)) {
+        uintptr_t addr = (uintptr_t)pte_table(*pte);
+        pte_t flags = *pte & ~PTE_PPN_MSK;
+        for (size_t i = 0; i < PT_ENTRIES; i++) {
+            table[i] = pte_make(addr + i * PT_LVL_SIZE(lvl + 1), flags);
+        }
+    }
+
+    fence_ord_write();
+    *pte = pte_make((uintptr_t)table, PTE_VALID | PTE_TABLE);
+
+    return 0;
+}
+
+static int pt_map(uintptr_t addr, size_t size, pte_t flags)
+{
+    uintptr_t end = addr + size;
+
+    while (addr < end) {
+        pte_t *pt = root_pt;
+        for (size_t lvl = 0; lvl < PT_LVLS; lvl++) {
+            size_t lvl_size = PT_LVL_SIZE(lvl);
+            pte_t *pte = &pt[PTE_INDEX(lvl, addr)];
+
+            if (lvl >= PT_LEAF_MIN_LVL && !(addr & (lvl_size - 1)) &&
+                (end - addr) >= lvl_size) {
+                *pte = pte_make(addr, flags);
+                addr += lvl_size;
+                break;
+            }
+
+            if (!(*pte & PTE_VALID) || pte_is_leaf(*pte)) {
+                if (pt_split(pte, lvl) < 0) {
+                    return -1;
+                }
+            }
+
+            pt = pte_table(*pte);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Dirty lines left by a cacheable mapping could later be written back over
+ * what is written through the uncached one, so they are cleaned and
+ * invalidated before the range stops being cacheable.
+ */
+int pt_set_mem_type(uintptr_t addr, size_t size, enum pt_mem_type type)
+{
+    if ((addr | size) & (PAGE_SIZE - 1)) {
+        return -1;
+    }
+
+    if (type != PT_MEM_NORMAL) {
+        cache_flush_range((void*)addr, size);
+    }
+
+    spin_lock(&pt_lock);
+    int ret = pt_map(addr, size, pt_type_flags(type));
+    spin_unlock(&pt_lock);
+
+    if (csrs_satp_read() != 0) {
+        sfence_vma(addr, size);
+    }
+
+    return ret;
+}
+
+/**
+ * Builds the identity map. Everything is mapped as IO using gigapages except
+ * the guest's RAM which is refined using the largest possible leaves (down to
+ * 2MB for the expected alignment of MEM_BASE and MEM_SIZE). Called by the
+ * primary hart before any hart writes pt_satp to satp.
+ */
+void pt_init()
+{
+    /* Svpbmt decides the attributes */
+    cpu_isa_discover();
+    pt_map(0, PT_IDMAP_SIZE, pt_type_flags(PT_MEM_IO));
+    pt_map(MEM_BASE, MEM_SIZE, pt_type_flags(PT_MEM_NORMAL));
+
+    pt_satp = PT_SATP_MODE | ((uintptr_t)root_pt >> PAGE_SHIFT);
+    fence_ord_write();
+}
+
+/**
+ * Memory beyond MEM_BASE + MEM_SIZE found in the device tree is initially
+ * mapped as IO by pt_init.
+ */
+uint64_t arch_mem_map(uint64_t start, uint64_t end)
+{
+    if (end > PT_IDMAP_SIZE) end = PT_IDMAP_SIZE;
+    end &= PAGE_ADDR_MSK;
+
+    if (end <= start || pt_set_mem_type(start, end - start, PT_MEM_NORMAL)) {
+        return start;
+    }
+
+    return end;
+}
@@ -17,6 +17,8 @@
 #include <irq.h>
 #include <spinlock.h>
 #include <cpu.h>
+#include <fdt.h>
+#include <bitmap.h>
 
 #include <stdio.h>
 
@@ -27,6 +29,20 @@
 volatile plic_global_t * plic_global = (void*) PLIC_BASE;
 volatile plic_hart_t *plic_hart = (void*) PLIC_HART_BASE;
 
+void plic_fdt_discover(){
+    uint64_t addr;
+    int node = fdt_node_offset_by_compatible(-1, "riscv,plic0");
+
+    if(node < 0) {
+        node = fdt_node_offset_by_compatible(-1, "sifive,plic-1.0.0");
+    }
+
+    if(node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        plic_global = (void*)(uintptr_t)addr;
+        plic_hart = (void*)(uintptr_t)(addr + (PLIC_HART_BASE - PLIC_BASE));
+    }
+}
+
 void plic_probe(){
     uint32_t *ptr =  (void*) plic_global->enbl;
 
@@ -47,9 +63,9 @@ void plic_init(){
 
 void plic_enable_interrupt(int hid, int int_id, bool en){
 
-    int reg_ind = int_id/(sizeof(uint32_t)*8);
-    uint32_t mask = 1U << (int_id%(sizeof(uint32_t)*8));
-    
+    int reg_ind = BITMAP32_WORD(int_id);
+    uint32_t mask = BITMAP32_BIT(int_id);
+
     int cntxt = plic_hartidpriv_to_context(hid, PRIV_S);
     if(cntxt < 0) return;
 
@@ -61,6 +77,20 @@ void plic_enable_interrupt(int hid, int int_id, bool en){
 
 }
 
+void plic_migrate(int from, int to){
+
+    int from_cntxt = plic_hartidpriv_to_context(from, PRIV_S);
+    int to_cntxt = plic_hartidpriv_to_context(to, PRIV_S);
+
+    for(int i = 0; i < PLIC_NUM_ENBL_REGS; i++){
+        uint32_t enbl = plic_global->enbl[from_cntxt][i];
+        if(enbl != 0) {
+            plic_global->enbl[to_cntxt][i] |= enbl;
+            plic_global->enbl[from_cntxt][i] = 0;
+        }
+    }
+}
+
 void plic_set_prio(int int_id, int prio){
     plic_global->prio[int_id] = prio;
 }
@@ -38,6 +38,9 @@
 #define SBI_HART_START_FID  (0)
 #define SBI_HART_STOP_FID   (1)
 #define SBI_HART_STATUS_FID   (2)
+#define SBI_HART_SUSPEND_FID  (3)
+
+#define SBI_EXTID_BAO (0x08000ba0)
 
 static inline struct sbiret sbi_ecall(long eid, long fid, long a0, long a1,
                                       long a2, long a3, long a4, long a5)
@@ -183,3 +186,16 @@ struct sbiret sbi_hart_status(unsigned long hartid)
                      0, 0, 0, 0, 0);   
 }
 
+struct sbiret sbi_hart_suspend(uint32_t suspend_type, unsigned long resume_addr,
+                               unsigned long opaque)
+{
+    return sbi_ecall(SBI_EXTID_HSM, SBI_HART_SUSPEND_FID, suspend_type,
+                     resume_addr, opaque, 0, 0, 0);
+}
+
+struct sbiret sbi_bao_hypercall(unsigned long id, unsigned long arg0,
+                                unsigned long arg1, unsigned long arg2)
+{
+    return sbi_ecall(SBI_EXTID_BAO, id, arg0, arg1, arg2, 0, 0, 0);
+}
+
@@ -1,3 +1,29 @@
-arch_c_srcs:= init.c plic.c sbi.c exceptions.c irq.c timer.c
-arch_s_srcs:= start.S
+arch_c_srcs:= init.c isa.c sbi.c exceptions.c irq.c timer.c cache.c
+arch_s_srcs:= start.S string.S
 
+ifeq ($(IRQC), AIA)
+	arch_c_srcs+=aplic.c imsic.c
+else
+	arch_c_srcs+=plic.c aclint.c
+endif
+
+ifneq ($(MMU),)
+	arch_c_srcs+=page_tables.c
+endif
+
+ifeq ($(RVV), y)
+	arch_c_srcs+=vector.c
+	arch_s_srcs+=vector.S rvv_string.S rvv_checksum.S
+endif
+
+ifneq ($(SCHED),)
+	arch_s_srcs+=sched.S
+endif
+
+ifneq ($(IDLE),)
+	arch_c_srcs+=idle.c
+endif
+
+ifneq ($(IDLE)$(HOTPLUG),)
+	arch_c_srcs+=cpu_pm.c
+endif
@@ -5,6 +5,9 @@
 #include <csrs.h>
 #include <sbi.h>
 
+/* 0 until the hart programs its timer */
+static uint64_t timer_deadline[NR_CPUS];
+
 void timer_enable()
 {
 }
@@ -14,13 +17,23 @@ uint64_t timer_get()
     return csrs_time_read();
 }
 
-void timer_set(uint64_t n)
+void timer_set_abs(uint64_t time)
 {
-    uint64_t next_tick = timer_get() + n;
-
+    timer_deadline[get_cpuid()] = time;
     if (CPU_HAS_EXTENSION(CPU_EXT_SSTC)) {
-        csrs_stimecmp_write(next_tick);
+        csrs_stimecmp_write(time);
     } else {
-        sbi_set_timer(next_tick);
+        sbi_set_timer(time);
     }
 }
+
+void timer_set(uint64_t n)
+{
+    timer_set_abs(timer_get() + n);
+}
+
+uint64_t timer_get_deadline()
+{
+    uint64_t deadline = timer_deadline[get_cpuid()];
+    return deadline != 0 ? deadline : TIMER_NO_DEADLINE;
+}
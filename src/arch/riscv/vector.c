@@ -0,0 +1,28 @@
+#include <vector.h>
+#include <cpu.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+uint8_t rvv_ctx[NR_CPUS][RVV_CTX_SIZE] __attribute__((aligned(16)));
+
+/**
+ * The vector unit was enabled in start.S and the libc string routines are
+ * replaced by vector ones, so it can not just be turned off again. Stop if the
+ * save areas are too small for this hart's VLEN as interrupts would otherwise
+ * corrupt the state of the code they interrupt. The same if there is no vector
+ * unit at all, rather than faulting on the first vector instruction.
+ */
+void rvv_init()
+{
+    if (!CPU_HAS_EXTENSION(CPU_EXT_V)) {
+        printf("RVV build on a hart without the V extension\n");
+        exit(-1);
+    }
+
+    unsigned long vlen = csrs_vlenb_read() * 8;
+
+    if (vlen > RVV_VLEN_MAX) {
+        printf("VLEN %lu larger than RVV_VLEN_MAX (%d)\n", vlen, RVV_VLEN_MAX);
+        exit(-1);
+    }
+}
@@ -0,0 +1,16 @@
+#include <bench.h>
+#include <stdio.h>
+
+void bench_run()
+{
+    printf("timer frequency %llu Hz\n", (unsigned long long)TIMER_FREQ);
+    string_bench();
+    printf_bench();
+    ipc_bench();
+#ifdef SCHED
+    sched_bench();
+#endif
+#ifdef JOBS
+    jobs_bench();
+#endif
+}
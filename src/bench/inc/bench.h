@@ -0,0 +1,24 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <core.h>
+#include <timer.h>
+
+/**
+ * Microbenchmarks, built with BENCH=y and run by the master cpu before the
+ * test application starts.
+ */
+void bench_run();
+
+void string_bench();
+void printf_bench();
+void ipc_bench();
+void sched_bench();
+void jobs_bench();
+
+static inline unsigned long long bench_ticks_to_ns(uint64_t ticks)
+{
+    return (ticks * 1000000000ull) / TIMER_FREQ;
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,56 @@
+#include <bench.h>
+#include <ipc.h>
+#include <stdio.h>
+
+#define IPC_BENCH_SHM_SIZE  (0x4000)
+#define IPC_BENCH_MSGS      (0x10000)
+#define IPC_BENCH_BATCH     (32)
+
+static uint8_t ipc_bench_shm[IPC_BENCH_SHM_SIZE]
+    __attribute__((aligned(IPC_CACHE_LINE)));
+
+/**
+ * Per message cost of a channel on a single cpu: batches of messages are
+ * sent, with one notification per batch (suppressed, as the consumer is not
+ * armed), and then received. This is the memory bound part of inter-VM
+ * messaging, without the doorbell traps it amortizes.
+ */
+void ipc_bench()
+{
+    static const size_t sizes[] = { 8, 64, 256 };
+    uint8_t msg[256] = { 0 };
+
+    printf("%-8s %8s %12s\n", "ipc", "size", "ns/msg");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int mpsc = 0; mpsc < 2; mpsc++) {
+            struct ipc_channel ch;
+            struct ipc_config cfg = {
+                .shm = ipc_bench_shm,
+                .shm_size = sizeof(ipc_bench_shm),
+                .msg_size = sizes[s],
+                .create = true,
+                .mpsc = mpsc,
+            };
+
+            if (ipc_channel_init(&ch, &cfg) != 0) {
+                continue;
+            }
+
+            uint64_t start = timer_get();
+            for (size_t i = 0; i < IPC_BENCH_MSGS; i += IPC_BENCH_BATCH) {
+                for (size_t j = 0; j < IPC_BENCH_BATCH; j++) {
+                    ipc_send(&ch, msg, sizes[s]);
+                }
+                ipc_notify(&ch);
+                for (size_t j = 0; j < IPC_BENCH_BATCH; j++) {
+                    ipc_recv(&ch, msg, sizeof(msg));
+                }
+            }
+            uint64_t ticks = timer_get() - start;
+
+            printf("%-8s %8u %12llu\n", mpsc ? "mpsc" : "spsc",
+                (unsigned)sizes[s], bench_ticks_to_ns(ticks) / IPC_BENCH_MSGS);
+        }
+    }
+}
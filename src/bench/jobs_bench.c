@@ -0,0 +1,124 @@
+#include <bench.h>
+#include <jobs.h>
+#include <cpu.h>
+#include <stdio.h>
+
+#define JOBS_BENCH_ITEMS    (1 << 14)
+#define JOBS_BENCH_ROUNDS   (256)
+#define JOBS_BENCH_REPS     (4)
+/* Time for the other cpus to boot and start serving jobs */
+#define JOBS_BENCH_WAIT_MS  (100)
+
+static uint32_t jobs_bench_out[JOBS_BENCH_ITEMS];
+
+static inline uint32_t jobs_bench_work(size_t i)
+{
+    uint32_t x = i + 1;
+
+    for (size_t r = 0; r < JOBS_BENCH_ROUNDS; r++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+
+    return x;
+}
+
+static void jobs_bench_for(size_t begin, size_t end, void* arg)
+{
+    for (size_t i = begin; i < end; i++) {
+        jobs_bench_out[i] = jobs_bench_work(i);
+    }
+}
+
+static void jobs_bench_sum(size_t begin, size_t end, void* result, void* arg)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        sum += jobs_bench_work(i);
+    }
+
+    *(uint64_t*)result = sum;
+}
+
+static void jobs_bench_add(void* result, const void* other, void* arg)
+{
+    *(uint64_t*)result += *(const uint64_t*)other;
+}
+
+/* Best of a few runs of parallel_for or parallel_reduce, in ticks */
+static uint64_t jobs_bench_time(bool reduce, uint64_t* sum)
+{
+    uint64_t best = ~0ULL;
+
+    for (size_t rep = 0; rep < JOBS_BENCH_REPS; rep++) {
+        uint64_t start = timer_get();
+        if (reduce) {
+            parallel_reduce(0, JOBS_BENCH_ITEMS, 0, sum, sizeof(*sum),
+                jobs_bench_sum, jobs_bench_add, NULL);
+        } else {
+            parallel_for(0, JOBS_BENCH_ITEMS, 0, jobs_bench_for, NULL);
+        }
+        uint64_t ticks = timer_get() - start;
+        if (ticks < best) best = ticks;
+    }
+
+    return best;
+}
+
+static unsigned long long jobs_bench_speedup(uint64_t base, uint64_t ticks)
+{
+    return ticks != 0 ? (base * 100) / ticks : 0;
+}
+
+/**
+ * Scaling of a compute bound parallel_for and parallel_reduce, from the
+ * calling cpu alone to every cpu serving jobs, adding one at a time.
+ */
+void jobs_bench()
+{
+    unsigned long self = get_cpuid();
+    uint64_t base_for = 0, base_reduce = 0, ref_sum = 0;
+    cpumask_t cpus;
+    cpumask_t mask = cpumask_of(self);
+    cpumask_t all = CPUMASK_ALL;
+
+    timer_wait(TIME_MS(JOBS_BENCH_WAIT_MS));
+    jobs_get_cpus(&cpus);
+    cpumask_clear_cpu(&cpus, self);
+
+    printf("%-8s %8s %10s %8s %10s %8s\n", "jobs", "cpus", "for us",
+        "speedup", "reduce us", "speedup");
+
+    for (unsigned n = 1; ; n++) {
+        uint64_t sum = 0;
+
+        jobs_set_cpus(&mask);
+        uint64_t ticks_for = jobs_bench_time(false, &sum);
+        uint64_t ticks_reduce = jobs_bench_time(true, &sum);
+
+        if (n == 1) {
+            base_for = ticks_for;
+            base_reduce = ticks_reduce;
+            ref_sum = sum;
+        }
+
+        unsigned long long s_for = jobs_bench_speedup(base_for, ticks_for);
+        unsigned long long s_reduce =
+            jobs_bench_speedup(base_reduce, ticks_reduce);
+        printf("%-8s %8u %10llu %5llu.%02llu %10llu %5llu.%02llu%s\n", "",
+            n, bench_ticks_to_ns(ticks_for) / 1000, s_for / 100, s_for % 100,
+            bench_ticks_to_ns(ticks_reduce) / 1000, s_reduce / 100,
+            s_reduce % 100, sum != ref_sum ? " mismatch" : "");
+
+        if (cpumask_empty(&cpus)) {
+            break;
+        }
+        unsigned long next = cpumask_first(&cpus);
+        cpumask_set_cpu(&mask, next);
+        cpumask_clear_cpu(&cpus, next);
+    }
+
+    jobs_set_cpus(&all);
+}
@@ -0,0 +1,123 @@
+#include <bench.h>
+#include <fmt.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PRINTF_BENCH_ITER   (10000)
+#define PRINTF_BENCH_BUF    (128)
+
+typedef int (*snprintf_fn_t)(char*, size_t, const char*, ...);
+
+/**
+ * The libc entry resolves to the core printf when building with CORE_PRINTF.
+ * Called through volatile pointers so the calls are not turned into builtins.
+ */
+static snprintf_fn_t volatile impls[] = { snprintf, fmt_snprintf };
+
+static uint64_t printf_bench_case(snprintf_fn_t fn, unsigned c, char* buf)
+{
+    uint64_t start = timer_get();
+
+    for (unsigned i = 0; i < PRINTF_BENCH_ITER; i++) {
+        switch (c) {
+            case 0:
+                fn(buf, PRINTF_BENCH_BUF, "cpu%d: %s\n", i & 7, "timer_handler");
+                break;
+            case 1:
+                fn(buf, PRINTF_BENCH_BUF, "%llu", 0x123456789abcdefull + i);
+                break;
+            case 2:
+                fn(buf, PRINTF_BENCH_BUF, "%08x %p", i, (void*)buf);
+                break;
+            case 3:
+                fn(buf, PRINTF_BENCH_BUF, "%-8s %8u %12llu", "memcpy", i,
+                    (unsigned long long)i * 1000);
+                break;
+#ifdef PRINTF_FLOAT
+            case 4:
+                fn(buf, PRINTF_BENCH_BUF, "%.3f", 1.5 * i);
+                break;
+#endif
+        }
+    }
+
+    return timer_get() - start;
+}
+
+#ifdef PRINTF_FLOAT
+/* %f output checked against glibc, rounding from the exact binary value */
+static const struct {
+    const char* fmt;
+    double val;
+    const char* expect;
+} printf_float_checks[] = {
+    { "%.1f", 7.25, "7.2" },
+    { "%+.0f", 2.5, "+2" },
+    { "%.0f", 3.5, "4" },
+    { "%.2f", 2.675, "2.67" },
+    { "%.3f", 999.9995, "1000.000" },
+    { "%.1f", 0.05, "0.1" },
+    { "%f", 1e22, "10000000000000000000000.000000" },
+    { "%f", 1e300, "100000000000000005250476025520442024870446858110815915"
+        "491585411551180245798890819578637137508044786404370444383288387817"
+        "694252323536043057564479218478670698284838720092657580373783023379"
+        "478809005936895323497079994508111903896764088007465274278014249457"
+        "9258788820056842838115669472196386865459400540160.000000" },
+};
+
+static void printf_float_check()
+{
+    static char buf[320];
+    size_t fails = 0;
+
+    for (size_t i = 0; i < sizeof(printf_float_checks) /
+        sizeof(printf_float_checks[0]); i++) {
+        fmt_snprintf(buf, sizeof(buf), printf_float_checks[i].fmt,
+            printf_float_checks[i].val);
+        if (strcmp(buf, printf_float_checks[i].expect) != 0) {
+            printf("printf check: \"%s\" gave %s\n",
+                printf_float_checks[i].fmt, buf);
+            fails++;
+        }
+    }
+
+    if (fails == 0) {
+        printf("printf check: %%f ok\n");
+    }
+}
+#endif
+
+/**
+ * Per call cost of the libc snprintf against the core one for a few typical
+ * formats. Build with CORE_PRINTF=n to measure against newlib.
+ */
+void printf_bench()
+{
+    static const char* const names[] = {
+        "int+str", "u64", "hex+ptr", "mixed", "float",
+    };
+    char buf[PRINTF_BENCH_BUF];
+#ifdef PRINTF_FLOAT
+    unsigned ncases = 5;
+#else
+    unsigned ncases = 4;
+#endif
+
+#ifdef CORE_PRINTF
+    printf("printf bench: built with CORE_PRINTF, libc is the core version\n");
+#endif
+#ifdef PRINTF_FLOAT
+    printf_float_check();
+#endif
+    printf("%-8s %12s %12s\n", "format", "libc ns", "core ns");
+
+    for (unsigned c = 0; c < ncases; c++) {
+        uint64_t ticks[2];
+        for (size_t i = 0; i < 2; i++) {
+            ticks[i] = printf_bench_case(impls[i], c, buf);
+        }
+        printf("%-8s %12llu %12llu\n", names[c],
+            bench_ticks_to_ns(ticks[0]) / PRINTF_BENCH_ITER,
+            bench_ticks_to_ns(ticks[1]) / PRINTF_BENCH_ITER);
+    }
+}
@@ -0,0 +1,126 @@
+#include <bench.h>
+#include <sched.h>
+#include <cpu.h>
+#include <stdio.h>
+
+#define SCHED_BENCH_ITER        (10000)
+#define SCHED_BENCH_STACK_SIZE  (0x1000)
+
+static struct thread sched_bench_thread;
+static uint8_t sched_bench_stack[SCHED_BENCH_STACK_SIZE]
+    __attribute__((aligned(16)));
+static struct mutex sched_bench_mutex = MUTEX_INITVAL;
+
+static volatile uint64_t sched_bench_start;
+static uint64_t sched_bench_min;
+static uint64_t sched_bench_max;
+static uint64_t sched_bench_sum;
+
+static void sched_bench_sample()
+{
+    uint64_t ticks = timer_get() - sched_bench_start;
+
+    if (ticks < sched_bench_min) sched_bench_min = ticks;
+    if (ticks > sched_bench_max) sched_bench_max = ticks;
+    sched_bench_sum += ticks;
+}
+
+static void sched_bench_print(const char* name)
+{
+    printf("%-10s %10llu %10llu %10llu\n", name,
+        bench_ticks_to_ns(sched_bench_min),
+        bench_ticks_to_ns(sched_bench_sum / SCHED_BENCH_ITER),
+        bench_ticks_to_ns(sched_bench_max));
+}
+
+static void sched_bench_reset()
+{
+    sched_bench_min = ~0ULL;
+    sched_bench_max = 0;
+    sched_bench_sum = 0;
+}
+
+static void sched_bench_run(const char* name, thread_fn_t fn, unsigned prio)
+{
+    sched_bench_reset();
+    thread_create(&sched_bench_thread, name, fn, NULL, prio, get_cpuid(),
+        sched_bench_stack, sizeof(sched_bench_stack));
+}
+
+static void sched_bench_join()
+{
+    while (sched_bench_thread.state != THREAD_DONE) {
+        thread_yield();
+    }
+}
+
+/* Bounces with the calling thread, at the same priority */
+static void sched_bench_yield(void* arg)
+{
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        thread_yield();
+    }
+}
+
+/* Measures from before thread_resume to running, preempting the caller */
+static void sched_bench_wake(void* arg)
+{
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        thread_suspend();
+        sched_bench_sample();
+    }
+}
+
+/* Measures from before mutex_unlock to the waiter owning the mutex */
+static void sched_bench_handover(void* arg)
+{
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        thread_suspend();
+        mutex_lock(&sched_bench_mutex);
+        sched_bench_sample();
+        mutex_unlock(&sched_bench_mutex);
+    }
+}
+
+/**
+ * Switch latencies on the calling cpu: a same priority yield, a higher
+ * priority thread resumed by a lower priority one, and a mutex handed over
+ * to a higher priority waiter, which had boosted the owner meanwhile.
+ */
+void sched_bench()
+{
+    unsigned self_prio = thread_self()->prio;
+
+    printf("%-10s %10s %10s %10s\n", "sched", "min ns", "avg ns", "max ns");
+
+    sched_bench_run("yield", sched_bench_yield, self_prio);
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        sched_bench_start = timer_get();
+        thread_yield();
+        sched_bench_sample();
+    }
+    sched_bench_join();
+    /* Each sample is a round trip through the other thread */
+    sched_bench_min /= 2;
+    sched_bench_max /= 2;
+    sched_bench_sum /= 2;
+    sched_bench_print("yield");
+
+    sched_bench_run("wake", sched_bench_wake, SCHED_PRIO_MAX);
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        sched_bench_start = timer_get();
+        thread_resume(&sched_bench_thread);
+    }
+    sched_bench_join();
+    sched_bench_print("wake");
+
+    sched_bench_run("handover", sched_bench_handover, SCHED_PRIO_MAX);
+    for (size_t i = 0; i < SCHED_BENCH_ITER; i++) {
+        mutex_lock(&sched_bench_mutex);
+        thread_resume(&sched_bench_thread);
+        sched_bench_start = timer_get();
+        mutex_unlock(&sched_bench_mutex);
+    }
+    sched_bench_join();
+    sched_bench_print("handover");
+}
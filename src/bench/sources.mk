@@ -0,0 +1,7 @@
+bench_c_srcs:=bench.c string_bench.c printf_bench.c ipc_bench.c
+ifneq ($(SCHED),)
+bench_c_srcs+=sched_bench.c
+endif
+ifneq ($(JOBS),)
+bench_c_srcs+=jobs_bench.c
+endif
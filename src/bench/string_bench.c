@@ -0,0 +1,115 @@
+#include <bench.h>
+#include <arch_string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_BENCH_MAX_SIZE   (1024 * 1024)
+#define STRING_BENCH_BYTES      (8 * 1024 * 1024)
+#define STRING_BENCH_MAX_ITER   (1024 * 1024)
+
+enum string_op { OP_MEMCPY, OP_MEMSET, OP_MEMCMP, OP_STRLEN, OP_NUM };
+
+struct string_impl {
+    void* (*memcpy)(void*, const void*, size_t);
+    void* (*memset)(void*, int, size_t);
+    int (*memcmp)(const void*, const void*, size_t);
+    size_t (*strlen)(const char*);
+};
+
+/**
+ * Called through volatile pointers so the compiler can neither inline nor
+ * replace the calls with builtins. With ARCH_STRING the libc names resolve
+ * to the arch routines, there is no libc version left to compare against.
+ */
+static const struct string_impl* volatile impls[] = {
+#ifndef ARCH_STRING
+    &(struct string_impl) { memcpy, memset, memcmp, strlen },
+#endif
+    &(struct string_impl) { arch_memcpy, arch_memset, arch_memcmp, arch_strlen },
+};
+
+#define STRING_BENCH_IMPLS  (sizeof(impls) / sizeof(impls[0]))
+
+static const char* const op_names[OP_NUM] = {
+    [OP_MEMCPY] = "memcpy",
+    [OP_MEMSET] = "memset",
+    [OP_MEMCMP] = "memcmp",
+    [OP_STRLEN] = "strlen",
+};
+
+static uint64_t string_bench_op(const struct string_impl* impl,
+    enum string_op op, uint8_t* dst, uint8_t* src, size_t size, size_t iter)
+{
+    uint64_t start = timer_get();
+
+    for (size_t i = 0; i < iter; i++) {
+        switch (op) {
+            case OP_MEMCPY:
+                impl->memcpy(dst, src, size);
+                break;
+            case OP_MEMSET:
+                impl->memset(dst, (int)i, size);
+                break;
+            case OP_MEMCMP:
+                impl->memcmp(dst, src, size);
+                break;
+            default:
+                impl->strlen((const char*)src);
+                break;
+        }
+    }
+
+    return timer_get() - start;
+}
+
+/**
+ * Measures the libc and arch versions of each routine from 1B to 1MB, each
+ * size repeated for roughly STRING_BENCH_BYTES. memcmp compares equal buffers
+ * and strlen scans size - 1 characters. With ARCH_STRING only the arch ones.
+ */
+void string_bench()
+{
+    uint8_t* src = malloc(STRING_BENCH_MAX_SIZE);
+    uint8_t* dst = malloc(STRING_BENCH_MAX_SIZE);
+
+    if (src == NULL || dst == NULL) {
+        printf("string bench: out of memory\n");
+        free(src);
+        free(dst);
+        return;
+    }
+
+#ifdef ARCH_STRING
+    printf("string bench: libc is replaced with ARCH_STRING, no comparison, "
+        "build with ARCH_STRING=n for it\n");
+    printf("%-8s %8s %12s\n", "op", "size", "arch ns");
+#else
+    printf("%-8s %8s %12s %12s\n", "op", "size", "libc ns", "arch ns");
+#endif
+
+    for (enum string_op op = 0; op < OP_NUM; op++) {
+        for (size_t size = 1; size <= STRING_BENCH_MAX_SIZE; size *= 4) {
+            size_t iter = STRING_BENCH_BYTES / size;
+            if (iter > STRING_BENCH_MAX_ITER) iter = STRING_BENCH_MAX_ITER;
+
+            memset(src, 'a', size);
+            src[size - 1] = '\0';
+            memcpy(dst, src, size);
+
+            uint64_t ticks[STRING_BENCH_IMPLS];
+            for (size_t i = 0; i < STRING_BENCH_IMPLS; i++) {
+                ticks[i] = string_bench_op(impls[i], op, dst, src, size, iter);
+            }
+
+            printf("%-8s %8u", op_names[op], (unsigned)size);
+            for (size_t i = 0; i < STRING_BENCH_IMPLS; i++) {
+                printf(" %12llu", bench_ticks_to_ns(ticks[i]) / iter);
+            }
+            printf("\n");
+        }
+    }
+
+    free(src);
+    free(dst);
+}
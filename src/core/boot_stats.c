@@ -0,0 +1,29 @@
+#include <boot_stats.h>
+#include <timer.h>
+#include <stdio.h>
+
+uint64_t boot_timestamps[BOOT_PHASE_NUM];
+
+static const char* const boot_phase_names[BOOT_PHASE_NUM] = {
+    [BOOT_PHASE_ENTRY] = "entry",
+    [BOOT_PHASE_BSS] = "bss",
+    [BOOT_PHASE_CONSOLE] = "console",
+    [BOOT_PHASE_ARCH] = "arch",
+};
+
+static inline unsigned long long ticks_to_us(uint64_t ticks)
+{
+    return (ticks * 1000000ull) / TIMER_FREQ;
+}
+
+void boot_stats_print()
+{
+    uint64_t entry = boot_timestamps[BOOT_PHASE_ENTRY];
+
+    printf("boot phases (us since entry):\n");
+    for (size_t i = BOOT_PHASE_ENTRY + 1; i < BOOT_PHASE_NUM; i++) {
+        printf("    %-8s %8llu (+%llu)\n", boot_phase_names[i],
+            ticks_to_us(boot_timestamps[i] - entry),
+            ticks_to_us(boot_timestamps[i] - boot_timestamps[i - 1]));
+    }
+}
@@ -0,0 +1,27 @@
+#include <checksum.h>
+
+uint16_t checksum16_generic(const void* buf, size_t size)
+{
+    const uint8_t* p = buf;
+    uint64_t sum = 0;
+
+    for (; size >= 2; size -= 2, p += 2) {
+        sum += (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    if (size > 0) {
+        sum += p[0];
+    }
+
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return (uint16_t)~sum;
+}
+
+__attribute__((weak))
+uint16_t checksum16(const void* buf, size_t size)
+{
+    return checksum16_generic(buf, size);
+}
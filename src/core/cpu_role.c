@@ -0,0 +1,49 @@
+#include <cpu_role.h>
+#include <cpu.h>
+#include <irq.h>
+#include <smp.h>
+#include <wfi.h>
+#ifdef IDLE
+#include <idle.h>
+#endif
+#ifdef HOTPLUG
+#include <hotplug.h>
+#endif
+
+static const struct cpu_role cpu_role_default = { .name = NULL };
+
+const struct cpu_role* cpu_role()
+{
+    if (cpu_roles == NULL) {
+        return &cpu_role_default;
+    }
+
+    return &cpu_roles[get_cpuid()];
+}
+
+void cpu_role_init()
+{
+    if (cpu_role()->irqs_off) {
+        arch_irq_save();
+    }
+}
+
+void cpu_idle()
+{
+    const struct cpu_role* role = cpu_role();
+
+#ifdef HOTPLUG
+    hotplug_check();
+#endif
+
+    if (role->irqs_off) {
+        /* Nothing interrupts this cpu, pending IPIs are polled instead */
+        smp_poll();
+    } else if (role->idle == CPU_IDLE_WFI) {
+#ifdef IDLE
+        idle_enter();
+#else
+        wfi();
+#endif
+    }
+}
@@ -0,0 +1,164 @@
+#include <cyclic.h>
+#include <cpu.h>
+#include <irq.h>
+#include <timer.h>
+#include <cpu_role.h>
+#include <stdio.h>
+
+#define CYCLIC_NEVER    (~0ULL)
+
+struct cyclic_cpu {
+    uint64_t frame;
+    uint64_t release[CYCLIC_MAX_JOBS];
+    uint64_t deadline[CYCLIC_MAX_JOBS];
+    struct cyclic_stats stats;
+} __attribute__((aligned(64)));
+
+static struct cyclic_cpu cyclic_cpus[NR_CPUS];
+static volatile uint64_t cyclic_epoch;
+
+__attribute__((weak))
+void cyclic_overrun(unsigned long cpu, const struct cyclic_job* job,
+    uint64_t late)
+{
+    printf("cpu%lu: %s overran by %llu ticks\n", cpu,
+        job->name != NULL ? job->name : "job", (unsigned long long)late);
+}
+
+const struct cyclic_stats* cyclic_get_stats(unsigned long cpu)
+{
+    return cpu < NR_CPUS ? &cyclic_cpus[cpu].stats : NULL;
+}
+
+/* The wait loop only needs the interrupt to wake up, it just disarms it */
+static void cyclic_timer_handler(unsigned id)
+{
+    timer_set_abs(CYCLIC_NEVER);
+}
+
+/**
+ * The first cpu to get here sets the epoch a bit ahead of now, the others
+ * pick it up.
+ */
+static uint64_t cyclic_epoch_get()
+{
+    uint64_t epoch = 0;
+    uint64_t start = timer_get() + TIME_US(CYCLIC_START_DELAY_US);
+
+    if (__atomic_compare_exchange_n(&cyclic_epoch, &epoch, start, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return start;
+    }
+
+    return epoch;
+}
+
+/**
+ * Waits for time. Interrupts are masked around the check and wfi, which
+ * still wakes up on the pending timer, so its handler can not run in between
+ * and leave the cpu sleeping with the timer disarmed.
+ */
+static void cyclic_wait(uint64_t time)
+{
+    uint64_t wake = time - TIME_US(CYCLIC_SPIN_US);
+
+    if (timer_get() < wake) {
+        unsigned long flags = arch_irq_save();
+        timer_set_abs(wake);
+        while (timer_get() < wake) {
+            cpu_idle();
+        }
+        arch_irq_restore(flags);
+    }
+
+    while (timer_get() < time);
+}
+
+static bool cyclic_setup(struct cyclic_cpu* cpu,
+    const struct cyclic_table* table)
+{
+    if (table->num_jobs == 0 || table->num_jobs > CYCLIC_MAX_JOBS ||
+        table->frame_us == 0) {
+        return false;
+    }
+
+    cpu->frame = TIME_US(table->frame_us);
+
+    for (size_t i = 0; i < table->num_jobs; i++) {
+        const struct cyclic_job* job = &table->jobs[i];
+        uint32_t end = (i + 1 < table->num_jobs) ?
+            table->jobs[i + 1].offset_us : table->frame_us;
+
+        if (job->offset_us >= table->frame_us || job->offset_us > end) {
+            return false;
+        }
+        if (job->budget_us != 0 && job->offset_us + job->budget_us < end) {
+            end = job->offset_us + job->budget_us;
+        }
+
+        cpu->release[i] = TIME_US(job->offset_us);
+        cpu->deadline[i] = TIME_US(end);
+    }
+
+    return true;
+}
+
+void cyclic_run()
+{
+    unsigned long id = get_cpuid();
+    struct cyclic_cpu* cpu = &cyclic_cpus[id];
+    const struct cyclic_table* table =
+        (cyclic_tables != NULL) ? &cyclic_tables[id] : NULL;
+
+    irq_set_handler(TIMER_IRQ_ID, cyclic_timer_handler);
+    irq_enable(TIMER_IRQ_ID);
+    irq_set_prio(TIMER_IRQ_ID, IRQ_MAX_PRIO);
+
+    if (table == NULL || !cyclic_setup(cpu, table)) {
+        if (table != NULL && table->num_jobs != 0) {
+            printf("cpu%lu: invalid cyclic table\n", id);
+        }
+        while (1) {
+            cpu_idle();
+        }
+    }
+
+    /* Start at the first frame boundary, counted from the epoch, ahead */
+    uint64_t base = cyclic_epoch_get();
+    uint64_t now = timer_get();
+    if (now > base) {
+        base += ((now - base) / cpu->frame + 1) * cpu->frame;
+    }
+
+    while (1) {
+        for (size_t i = 0; i < table->num_jobs; i++) {
+            const struct cyclic_job* job = &table->jobs[i];
+            uint64_t release = base + cpu->release[i];
+            uint64_t deadline = base + cpu->deadline[i];
+
+            cyclic_wait(release);
+            uint64_t start = timer_get();
+            job->fn(job->arg);
+            uint64_t end = timer_get();
+
+            if (start - release > cpu->stats.max_release_jitter) {
+                cpu->stats.max_release_jitter = start - release;
+            }
+            if (end > deadline) {
+                cpu->stats.overruns++;
+                cyclic_overrun(id, job, end - deadline);
+            }
+        }
+
+        base += cpu->frame;
+        cpu->stats.frames++;
+
+        /* Resynchronize with the next boundary if whole frames were lost */
+        now = timer_get();
+        if (now >= base + cpu->frame) {
+            uint64_t skip = (now - base) / cpu->frame;
+            base += skip * cpu->frame;
+            cpu->stats.skipped_frames += skip;
+        }
+    }
+}
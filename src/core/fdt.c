@@ -0,0 +1,505 @@
+#include <fdt.h>
+#include <plat.h>
+#include <uart.h>
+
+/**
+ * The blob might live in memory mapped as device memory, so all accesses are
+ * aligned and strings are compared byte by byte instead of using newlib's
+ * optimized routines.
+ */
+
+#define FDT_ALIGN(X)        (((X) + 3) & ~3)
+#define FDT_MAX_DEPTH       (16)
+#define FDT_VERSION_MIN     (16)
+
+struct fdt_header {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+};
+
+const void* fdt_blob;
+
+static const uint8_t* fdt_struct;
+static const char* fdt_strings;
+static size_t fdt_struct_size;
+static size_t fdt_strings_size;
+
+static inline uint32_t fdt32_ld(const void* ptr)
+{
+    return __builtin_bswap32(*(const uint32_t*)ptr);
+}
+
+static uint64_t fdt_read_cells(const uint32_t* cells, size_t num)
+{
+    uint64_t val = 0;
+    for (size_t i = 0; i < num; i++) {
+        val = (val << 32) | fdt32_ld(&cells[i]);
+    }
+    return val;
+}
+
+static bool fdt_streq(const char* a, const char* b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) return false;
+        if (a[i] == '\0') return true;
+    }
+    return true;
+}
+
+static size_t fdt_strnlen(const char* s, size_t max)
+{
+    size_t len = 0;
+    while (len < max && s[len] != '\0') len++;
+    return len;
+}
+
+static bool fdt_init()
+{
+    static bool init_done = false;
+
+    if (init_done) return fdt_struct != NULL;
+    init_done = true;
+
+    const struct fdt_header* hdr = fdt_blob;
+    if (hdr == NULL || ((uintptr_t)hdr & 0x7)) return false;
+    if (fdt32_ld(&hdr->magic) != FDT_MAGIC) return false;
+    if (fdt32_ld(&hdr->last_comp_version) > FDT_VERSION_MIN ||
+        fdt32_ld(&hdr->version) < FDT_VERSION_MIN) {
+        return false;
+    }
+
+    uint32_t totalsize = fdt32_ld(&hdr->totalsize);
+    uint32_t off_struct = fdt32_ld(&hdr->off_dt_struct);
+    uint32_t off_strings = fdt32_ld(&hdr->off_dt_strings);
+    uint32_t size_struct = fdt32_ld(&hdr->size_dt_struct);
+    uint32_t size_strings = fdt32_ld(&hdr->size_dt_strings);
+
+    if ((off_struct & 0x3) || off_struct > totalsize ||
+        size_struct > totalsize - off_struct || off_strings > totalsize ||
+        size_strings > totalsize - off_strings) {
+        return false;
+    }
+
+    fdt_struct = (const uint8_t*)fdt_blob + off_struct;
+    fdt_strings = (const char*)fdt_blob + off_strings;
+    fdt_struct_size = size_struct;
+    fdt_strings_size = size_strings;
+
+    return true;
+}
+
+bool fdt_valid()
+{
+    return fdt_init();
+}
+
+/**
+ * Returns the tag at offset and the offset of the tag following it in next.
+ * Anything malformed is reported as FDT_END.
+ */
+static uint32_t fdt_next_tag(int offset, int* next)
+{
+    if (offset < 0 || (size_t)offset + sizeof(uint32_t) > fdt_struct_size) {
+        return FDT_END;
+    }
+
+    uint32_t tag = fdt32_ld(fdt_struct + offset);
+    size_t off = offset + sizeof(uint32_t);
+    size_t len;
+
+    switch (tag) {
+        case FDT_BEGIN_NODE:
+            len = fdt_strnlen((const char*)fdt_struct + off,
+                fdt_struct_size - off);
+            off += len + 1;
+            break;
+        case FDT_PROP:
+            if (off + 2 * sizeof(uint32_t) > fdt_struct_size) return FDT_END;
+            off += 2 * sizeof(uint32_t) + fdt32_ld(fdt_struct + off);
+            break;
+        case FDT_END_NODE:
+        case FDT_NOP:
+            break;
+        default:
+            return FDT_END;
+    }
+
+    if (off > fdt_struct_size) return FDT_END;
+
+    *next = FDT_ALIGN(off);
+    return tag;
+}
+
+int fdt_next_node(int node, int* depth)
+{
+    int next = 0;
+
+    if (!fdt_init()) return -1;
+
+    if (node >= 0 && fdt_next_tag(node, &next) != FDT_BEGIN_NODE) {
+        return -1;
+    }
+
+    while (true) {
+        int offset = next;
+        switch (fdt_next_tag(offset, &next)) {
+            case FDT_BEGIN_NODE:
+                if (depth != NULL) (*depth)++;
+                return offset;
+            case FDT_END_NODE:
+                if (depth != NULL && --(*depth) < 0) return -1;
+                break;
+            case FDT_END:
+                return -1;
+            default:
+                break;
+        }
+    }
+}
+
+int fdt_first_subnode(int node)
+{
+    int depth = 0;
+
+    node = fdt_next_node(node, &depth);
+    return (depth == 1) ? node : -1;
+}
+
+int fdt_next_subnode(int node)
+{
+    int depth = 1;
+
+    do {
+        node = fdt_next_node(node, &depth);
+    } while (node >= 0 && depth > 1);
+
+    return (depth == 1) ? node : -1;
+}
+
+int fdt_parent(int node)
+{
+    int stack[FDT_MAX_DEPTH];
+    int depth = 0;
+
+    for (int n = 0; n >= 0 && depth < FDT_MAX_DEPTH;
+        n = fdt_next_node(n, &depth)) {
+        stack[depth] = n;
+        if (n == node) return (depth > 0) ? stack[depth - 1] : -1;
+    }
+
+    return -1;
+}
+
+const char* fdt_get_name(int node)
+{
+    if (!fdt_init() || node < 0 || (size_t)node >= fdt_struct_size) {
+        return NULL;
+    }
+    return (const char*)fdt_struct + node + sizeof(uint32_t);
+}
+
+const void* fdt_getprop(int node, const char* name, int* len)
+{
+    int next;
+
+    if (!fdt_init() || fdt_next_tag(node, &next) != FDT_BEGIN_NODE) {
+        return NULL;
+    }
+
+    while (true) {
+        int offset = next;
+        uint32_t tag = fdt_next_tag(offset, &next);
+        if (tag == FDT_NOP) continue;
+        if (tag != FDT_PROP) break;
+
+        const uint8_t* prop = fdt_struct + offset + sizeof(uint32_t);
+        uint32_t nameoff = fdt32_ld(prop + sizeof(uint32_t));
+        if (nameoff >= fdt_strings_size) continue;
+
+        if (fdt_streq(fdt_strings + nameoff, name,
+                fdt_strings_size - nameoff)) {
+            if (len != NULL) *len = fdt32_ld(prop);
+            return prop + 2 * sizeof(uint32_t);
+        }
+    }
+
+    return NULL;
+}
+
+uint32_t fdt_getprop_u32(int node, const char* name, uint32_t dflt)
+{
+    int len;
+    const void* prop = fdt_getprop(node, name, &len);
+    return (prop != NULL && len == sizeof(uint32_t)) ? fdt32_ld(prop) : dflt;
+}
+
+bool fdt_prop_has_string(int node, const char* name, const char* str)
+{
+    int len;
+    const char* prop = fdt_getprop(node, name, &len);
+
+    while (prop != NULL && len > 0) {
+        size_t slen = fdt_strnlen(prop, len);
+        if (fdt_streq(prop, str, slen + 1)) return true;
+        prop += slen + 1;
+        len -= slen + 1;
+    }
+
+    return false;
+}
+
+bool fdt_node_is_compatible(int node, const char* compat)
+{
+    return fdt_prop_has_string(node, "compatible", compat);
+}
+
+bool fdt_node_is_available(int node)
+{
+    int len;
+    const char* status = fdt_getprop(node, "status", &len);
+    return status == NULL || fdt_streq(status, "okay", len) ||
+        fdt_streq(status, "ok", len);
+}
+
+int fdt_node_offset_by_compatible(int start, const char* compat)
+{
+    int node = (start < 0) ? 0 : fdt_next_node(start, NULL);
+
+    for (; node >= 0; node = fdt_next_node(node, NULL)) {
+        if (fdt_node_is_compatible(node, compat)) return node;
+    }
+
+    return -1;
+}
+
+/**
+ * Matches a path component against a node name. The unit address may be
+ * omitted from the component if it is unambiguous.
+ */
+static bool fdt_name_matches(const char* name, const char* comp, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (name[i] != comp[i]) return false;
+    }
+    return name[len] == '\0' || name[len] == '@';
+}
+
+int fdt_path_offset(const char* path)
+{
+    int node = 0;
+
+    if (!fdt_init() || path == NULL) return -1;
+
+    if (path[0] != '/') {
+        size_t len = 0;
+        while (path[len] != '\0' && path[len] != '/' && path[len] != ':') {
+            len++;
+        }
+
+        int aliases = fdt_path_offset("/aliases");
+        if (aliases < 0) return -1;
+
+        const char* alias = NULL;
+        int next;
+        fdt_next_tag(aliases, &next);
+        while (alias == NULL) {
+            int offset = next;
+            uint32_t tag = fdt_next_tag(offset, &next);
+            if (tag == FDT_NOP) continue;
+            if (tag != FDT_PROP) return -1;
+            const uint8_t* prop = fdt_struct + offset + sizeof(uint32_t);
+            uint32_t nameoff = fdt32_ld(prop + sizeof(uint32_t));
+            if (nameoff < fdt_strings_size &&
+                fdt_name_matches(fdt_strings + nameoff, path, len)) {
+                alias = (const char*)prop + 2 * sizeof(uint32_t);
+            }
+        }
+
+        return (alias[0] == '/') ? fdt_path_offset(alias) : -1;
+    }
+
+    while (*path != '\0' && *path != ':') {
+        while (*path == '/') path++;
+
+        size_t len = 0;
+        while (path[len] != '\0' && path[len] != '/' && path[len] != ':') {
+            len++;
+        }
+        if (len == 0) break;
+
+        int child;
+        fdt_for_each_subnode(child, node) {
+            if (fdt_name_matches(fdt_get_name(child), path, len)) break;
+        }
+        if (child < 0) return -1;
+
+        node = child;
+        path += len;
+    }
+
+    return node;
+}
+
+/**
+ * Reads the idx-th (address, size) pair of the node's reg property and
+ * translates the address to the cpu address space through the ranges of the
+ * parent buses. Cells beyond the two least significant are ignored.
+ */
+int fdt_get_reg(int node, size_t idx, uint64_t* addr, uint64_t* size)
+{
+    int parent = fdt_parent(node);
+    if (parent < 0) return -1;
+
+    size_t ac = fdt_getprop_u32(parent, "#address-cells", 2);
+    size_t sc = fdt_getprop_u32(parent, "#size-cells", 1);
+
+    int len;
+    const uint32_t* reg = fdt_getprop(node, "reg", &len);
+    size_t entry = ac + sc;
+    if (reg == NULL || entry == 0 ||
+        (idx + 1) * entry * sizeof(uint32_t) > (size_t)len) {
+        return -1;
+    }
+
+    reg += idx * entry;
+    uint64_t a = fdt_read_cells(reg, ac);
+    if (size != NULL) *size = fdt_read_cells(reg + ac, sc);
+
+    while (parent != 0) {
+        int bus = parent;
+        parent = fdt_parent(bus);
+        if (parent < 0) return -1;
+
+        const uint32_t* ranges = fdt_getprop(bus, "ranges", &len);
+        if (ranges == NULL) return -1;
+        if (len == 0) continue;
+
+        size_t cac = fdt_getprop_u32(bus, "#address-cells", 2);
+        size_t csc = fdt_getprop_u32(bus, "#size-cells", 1);
+        size_t pac = fdt_getprop_u32(parent, "#address-cells", 2);
+        size_t rentry = cac + pac + csc;
+        size_t num = len / (rentry * sizeof(uint32_t));
+
+        size_t i;
+        for (i = 0; i < num; i++, ranges += rentry) {
+            uint64_t child = fdt_read_cells(ranges, cac);
+            uint64_t paddr = fdt_read_cells(ranges + cac, pac);
+            uint64_t rsize = fdt_read_cells(ranges + cac + pac, csc);
+            if (a >= child && a - child < rsize) {
+                a = paddr + (a - child);
+                break;
+            }
+        }
+        if (i == num) return -1;
+    }
+
+    *addr = a;
+    return 0;
+}
+
+size_t fdt_cpu_num;
+unsigned long fdt_cpu_ids[NR_CPUS];
+uint64_t mem_limit = (uint64_t)MEM_BASE + MEM_SIZE;
+uintptr_t uart_addr = (uintptr_t)UART_ADDR;
+
+__attribute__((weak))
+void arch_fdt_discover()
+{
+
+}
+
+__attribute__((weak))
+uint64_t arch_mem_map(uint64_t start, uint64_t end)
+{
+    return end;
+}
+
+static void fdt_discover_cpus()
+{
+    int cpus = fdt_path_offset("/cpus");
+    if (cpus < 0) return;
+
+    size_t ac = fdt_getprop_u32(cpus, "#address-cells", 1);
+    int cpu;
+    fdt_for_each_subnode(cpu, cpus) {
+        int len;
+        const uint32_t* reg = fdt_getprop(cpu, "reg", &len);
+        if (!fdt_prop_has_string(cpu, "device_type", "cpu") || reg == NULL ||
+            (size_t)len < ac * sizeof(uint32_t) || !fdt_node_is_available(cpu)) {
+            continue;
+        }
+        if (fdt_cpu_num < NR_CPUS) {
+            fdt_cpu_ids[fdt_cpu_num++] = fdt_read_cells(reg, ac);
+        }
+    }
+}
+
+static void fdt_discover_mem()
+{
+    extern char _heap_base;
+    uint64_t heap = (uintptr_t)&_heap_base;
+    int node;
+
+    fdt_for_each_subnode(node, 0) {
+        if (!fdt_prop_has_string(node, "device_type", "memory") ||
+            !fdt_node_is_available(node)) {
+            continue;
+        }
+
+        uint64_t base, size;
+        for (size_t i = 0; fdt_get_reg(node, i, &base, &size) == 0; i++) {
+            if (heap < base || heap - base >= size) continue;
+
+            uint64_t end = base + size;
+            uint64_t mapped = (uint64_t)MEM_BASE + MEM_SIZE;
+            if (end > mapped) {
+                end = arch_mem_map(mapped, end);
+            }
+            mem_limit = end;
+            return;
+        }
+    }
+}
+
+static void fdt_discover_uart()
+{
+#ifdef PLAT_UART_COMPATIBLE
+    int chosen = fdt_path_offset("/chosen");
+    int node = fdt_path_offset(fdt_getprop(chosen, "stdout-path", NULL));
+    uint64_t addr;
+
+    if (node < 0 || !fdt_node_is_compatible(node, PLAT_UART_COMPATIBLE)) {
+        node = -1;
+        do {
+            node = fdt_node_offset_by_compatible(node, PLAT_UART_COMPATIBLE);
+        } while (node >= 0 && !fdt_node_is_available(node));
+    }
+
+    if (node >= 0 && fdt_get_reg(node, 0, &addr, NULL) == 0) {
+        uart_addr = addr;
+    }
+#endif
+}
+
+/**
+ * Called once, by the first cpu to run _init, before the console and any
+ * interrupt controller are initialized.
+ */
+void fdt_discover()
+{
+    if (!fdt_init()) return;
+
+    fdt_discover_cpus();
+    fdt_discover_mem();
+    fdt_discover_uart();
+    arch_fdt_discover();
+}
@@ -0,0 +1,670 @@
+#include <fmt.h>
+#include <console.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Console output is handed to console_write in chunks of this size */
+#define FMT_CONSOLE_BUF_SIZE    (64)
+/* Enough for any 64-bit value in octal */
+#define FMT_INT_DIGITS          (22)
+/* Fraction digits computed for %f, further ones are printed as zeros */
+#define FMT_FLOAT_MAX_PREC      (17)
+
+#define FMT_LEFT    (1 << 0)
+#define FMT_PLUS    (1 << 1)
+#define FMT_SPACE   (1 << 2)
+#define FMT_ALT     (1 << 3)
+#define FMT_ZERO    (1 << 4)
+#define FMT_UPPER   (1 << 5)
+#define FMT_PTR     (1 << 6)
+
+/**
+ * Output sink. Characters go to buf until size is reached, after which they
+ * are either flushed (console) or dropped (string), total counting them all.
+ */
+struct fmt_out {
+    char* buf;
+    size_t size;
+    size_t pos;
+    size_t total;
+    void (*flush)(struct fmt_out* out);
+};
+
+struct fmt_spec {
+    unsigned flags;
+    int width;
+    int prec;
+};
+
+static void fmt_putc(struct fmt_out* out, char c)
+{
+    if (out->pos >= out->size) {
+        if (out->flush == NULL) {
+            out->total++;
+            return;
+        }
+        out->flush(out);
+    }
+
+    out->buf[out->pos++] = c;
+    out->total++;
+}
+
+static void fmt_pad(struct fmt_out* out, char c, int n)
+{
+    for (; n > 0; n--) {
+        fmt_putc(out, c);
+    }
+}
+
+static void fmt_string(struct fmt_out* out, const struct fmt_spec* spec,
+    const char* s, size_t len)
+{
+    int pad = spec->width - (int)len;
+
+    if (!(spec->flags & FMT_LEFT)) {
+        fmt_pad(out, ' ', pad);
+    }
+    for (size_t i = 0; i < len; i++) {
+        fmt_putc(out, s[i]);
+    }
+    if (spec->flags & FMT_LEFT) {
+        fmt_pad(out, ' ', pad);
+    }
+}
+
+/* Writes the digits of val in reverse order, returns how many */
+static int fmt_digits(char* digits, unsigned long long val, unsigned base,
+    bool upper)
+{
+    const char* xdigits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int n = 0;
+
+    if (base == 10) {
+        while (val != 0) {
+            unsigned long long q = val / 10;
+            digits[n++] = '0' + (char)(val - (q * 10));
+            val = q;
+        }
+    } else {
+        unsigned shift = (base == 16) ? 4 : 3;
+        while (val != 0) {
+            digits[n++] = xdigits[val & (base - 1)];
+            val >>= shift;
+        }
+    }
+
+    return n;
+}
+
+static void fmt_integer(struct fmt_out* out, const struct fmt_spec* spec,
+    unsigned long long val, bool neg, unsigned base)
+{
+    char digits[FMT_INT_DIGITS];
+    char prefix[2];
+    int nprefix = 0;
+    unsigned flags = spec->flags;
+
+    if (neg) {
+        prefix[nprefix++] = '-';
+    } else if (flags & FMT_PLUS) {
+        prefix[nprefix++] = '+';
+    } else if (flags & FMT_SPACE) {
+        prefix[nprefix++] = ' ';
+    } else if ((flags & FMT_ALT) && base == 16 &&
+        (val != 0 || (flags & FMT_PTR))) {
+        prefix[nprefix++] = '0';
+        prefix[nprefix++] = (flags & FMT_UPPER) ? 'X' : 'x';
+    }
+
+    int ndigits = fmt_digits(digits, val, base, flags & FMT_UPPER);
+    int zeros = ((spec->prec < 0) ? 1 : spec->prec) - ndigits;
+    if (zeros < 0) {
+        zeros = 0;
+    }
+    if ((flags & FMT_ALT) && base == 8 && zeros == 0) {
+        zeros = 1;
+    }
+
+    int pad = spec->width - (nprefix + zeros + ndigits);
+    if (!(flags & (FMT_LEFT | FMT_ZERO))) {
+        fmt_pad(out, ' ', pad);
+    }
+    for (int i = 0; i < nprefix; i++) {
+        fmt_putc(out, prefix[i]);
+    }
+    if (flags & FMT_ZERO) {
+        fmt_pad(out, '0', pad);
+    }
+    fmt_pad(out, '0', zeros);
+    while (ndigits > 0) {
+        fmt_putc(out, digits[--ndigits]);
+    }
+    if (flags & FMT_LEFT) {
+        fmt_pad(out, ' ', pad);
+    }
+}
+
+#ifdef PRINTF_FLOAT
+/**
+ * Doubles are converted exactly, from their binary value, with small fixed
+ * size big integers of 32-bit words: the integer part is below 2^1024 and
+ * the fraction has at most 1074 bits.
+ */
+#define FMT_FLOAT_INT_WORDS     (33)    /* 1024 bits and a carry */
+#define FMT_FLOAT_FRAC_WORDS    (35)    /* 1074 bits and the next digit */
+#define FMT_FLOAT_INT_CHUNKS    (35)    /* 309 digits, 9 per chunk */
+#define FMT_FLOAT_CHUNK         (1000000000U)
+
+/* w = val << shift, w having room for it */
+static void fmt_big_set(uint32_t* w, size_t n, uint64_t val, unsigned shift)
+{
+    size_t i = shift / 32;
+    unsigned off = shift % 32;
+
+    memset(w, 0, n * sizeof(*w));
+    w[i++] = (uint32_t)(val << off);
+    for (val = off ? (val >> (32 - off)) : (val >> 32); val != 0; val >>= 32) {
+        w[i++] = (uint32_t)val;
+    }
+}
+
+/* w += 1 */
+static void fmt_big_inc(uint32_t* w, size_t n)
+{
+    for (size_t i = 0; i < n && ++w[i] == 0; i++);
+}
+
+/**
+ * Splits w in base 10^9 chunks, least significant first, clobbering it.
+ * Returns how many, at least one.
+ */
+static size_t fmt_big_chunks(uint32_t* w, size_t n, uint32_t* chunks)
+{
+    size_t nchunks = 0;
+
+    while (n > 0 && w[n - 1] == 0) {
+        n--;
+    }
+    do {
+        uint64_t rem = 0;
+        for (size_t i = n; i > 0; i--) {
+            rem = (rem << 32) | w[i - 1];
+            w[i - 1] = (uint32_t)(rem / FMT_FLOAT_CHUNK);
+            rem %= FMT_FLOAT_CHUNK;
+        }
+        chunks[nchunks++] = (uint32_t)rem;
+        while (n > 0 && w[n - 1] == 0) {
+            n--;
+        }
+    } while (n > 0);
+
+    return nchunks;
+}
+
+/**
+ * Takes the next decimal digit of the fraction w, of q bits: multiplies it
+ * by 10 and returns what overflows past them.
+ */
+static char fmt_big_frac_digit(uint32_t* w, size_t n, unsigned q)
+{
+    uint64_t carry = 0;
+    size_t i = q / 32;
+    unsigned off = q % 32;
+
+    for (size_t j = 0; j < n; j++) {
+        carry += (uint64_t)w[j] * 10;
+        w[j] = (uint32_t)carry;
+        carry >>= 32;
+    }
+
+    uint64_t win = w[i] | ((uint64_t)w[i + 1] << 32);
+    w[i] &= (1U << off) - 1;
+    w[i + 1] = 0;
+
+    return (char)(win >> off);
+}
+
+/* Compares the fraction w, of q bits, with one half */
+static int fmt_big_frac_cmp_half(const uint32_t* w, unsigned q)
+{
+    if (q == 0) {
+        return -1;
+    }
+
+    size_t i = (q - 1) / 32;
+    uint32_t half = 1U << ((q - 1) % 32);
+    if (!(w[i] & half)) {
+        return -1;
+    } else if (w[i] & (half - 1)) {
+        return 1;
+    }
+    while (i > 0) {
+        if (w[--i] != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Fixed notation only, rounded to nearest, ties to even, from the exact
+ * value, as glibc does. Precisions beyond FMT_FLOAT_MAX_PREC are padded
+ * with zeros.
+ */
+static void fmt_float(struct fmt_out* out, const struct fmt_spec* spec,
+    double val)
+{
+    bool upper = spec->flags & FMT_UPPER;
+    bool neg = __builtin_signbit(val);
+
+    if (val != val || __builtin_isinf(val)) {
+        static const char* const names[2][2] = {
+            { "inf", "INF" }, { "nan", "NAN" },
+        };
+        char s[4];
+        size_t n = 0;
+        if (neg) {
+            s[n++] = '-';
+        } else if (spec->flags & (FMT_PLUS | FMT_SPACE)) {
+            s[n++] = (spec->flags & FMT_PLUS) ? '+' : ' ';
+        }
+        memcpy(&s[n], names[val != val][upper], 3);
+        fmt_string(out, spec, s, n + 3);
+        return;
+    }
+
+    /* val = mant * 2^exp */
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    uint64_t mant = bits & ((1ULL << 52) - 1);
+    int exp = (int)((bits >> 52) & 0x7ff);
+    if (exp != 0) {
+        mant |= 1ULL << 52;
+        exp -= 1075;
+    } else {
+        exp = -1074;
+    }
+    while (mant != 0 && !(mant & 1) && exp < 0) {
+        mant >>= 1;
+        exp++;
+    }
+
+    uint32_t iw[FMT_FLOAT_INT_WORDS];
+    uint32_t fw[FMT_FLOAT_FRAC_WORDS];
+    unsigned q = 0;
+    if (mant == 0 || exp >= 0) {
+        fmt_big_set(iw, FMT_FLOAT_INT_WORDS, mant, (mant == 0) ? 0 : exp);
+    } else {
+        q = (unsigned)-exp;
+        fmt_big_set(iw, FMT_FLOAT_INT_WORDS, (q < 64) ? (mant >> q) : 0, 0);
+        fmt_big_set(fw, (q / 32) + 2, (q < 64) ?
+            (mant & ((1ULL << q) - 1)) : mant, 0);
+    }
+
+    int prec = (spec->prec < 0) ? 6 : spec->prec;
+    int fprec = (prec > FMT_FLOAT_MAX_PREC) ? FMT_FLOAT_MAX_PREC : prec;
+    char fdigits[FMT_FLOAT_MAX_PREC];
+    for (int i = 0; i < fprec; i++) {
+        fdigits[i] = (q > 0) ? fmt_big_frac_digit(fw, (q / 32) + 2, q) : 0;
+    }
+
+    int cmp = fmt_big_frac_cmp_half(fw, q);
+    bool odd = (fprec > 0) ? (fdigits[fprec - 1] & 1) : (iw[0] & 1);
+    if (cmp > 0 || (cmp == 0 && odd)) {
+        int i = fprec - 1;
+        for (; i >= 0 && fdigits[i] == 9; i--) {
+            fdigits[i] = 0;
+        }
+        if (i >= 0) {
+            fdigits[i]++;
+        } else {
+            fmt_big_inc(iw, FMT_FLOAT_INT_WORDS);
+        }
+    }
+
+    uint32_t chunks[FMT_FLOAT_INT_CHUNKS];
+    size_t nchunks = fmt_big_chunks(iw, FMT_FLOAT_INT_WORDS, chunks);
+    char idigits[9];
+    int ntop = fmt_digits(idigits, chunks[nchunks - 1], 10, false);
+    if (ntop == 0) {
+        idigits[ntop++] = '0';
+    }
+    int nint = ntop + (9 * (int)(nchunks - 1));
+
+    int nprefix = (neg || (spec->flags & (FMT_PLUS | FMT_SPACE))) ? 1 : 0;
+    bool point = (prec > 0) || (spec->flags & FMT_ALT);
+    int pad = spec->width - (nprefix + nint + (point ? 1 : 0) + prec);
+
+    if (!(spec->flags & (FMT_LEFT | FMT_ZERO))) {
+        fmt_pad(out, ' ', pad);
+    }
+    if (nprefix) {
+        fmt_putc(out, neg ? '-' : (spec->flags & FMT_PLUS) ? '+' : ' ');
+    }
+    if (spec->flags & FMT_ZERO) {
+        fmt_pad(out, '0', pad);
+    }
+    while (ntop > 0) {
+        fmt_putc(out, idigits[--ntop]);
+    }
+    for (size_t c = nchunks - 1; c > 0; c--) {
+        int n = fmt_digits(idigits, chunks[c - 1], 10, false);
+        fmt_pad(out, '0', 9 - n);
+        while (n > 0) {
+            fmt_putc(out, idigits[--n]);
+        }
+    }
+    if (point) {
+        fmt_putc(out, '.');
+    }
+    for (int i = 0; i < fprec; i++) {
+        fmt_putc(out, '0' + fdigits[i]);
+    }
+    fmt_pad(out, '0', prec - fprec);
+    if (spec->flags & FMT_LEFT) {
+        fmt_pad(out, ' ', pad);
+    }
+}
+#endif
+
+static long long fmt_arg_signed(va_list* ap, char len)
+{
+    switch (len) {
+        case 'H':
+            return (signed char)va_arg(*ap, int);
+        case 'h':
+            return (short)va_arg(*ap, int);
+        case 'l':
+            return va_arg(*ap, long);
+        case 'L':
+        case 'j':
+            return va_arg(*ap, long long);
+        case 'z':
+        case 't':
+            return va_arg(*ap, ptrdiff_t);
+        default:
+            return va_arg(*ap, int);
+    }
+}
+
+static unsigned long long fmt_arg_unsigned(va_list* ap, char len)
+{
+    switch (len) {
+        case 'H':
+            return (unsigned char)va_arg(*ap, unsigned);
+        case 'h':
+            return (unsigned short)va_arg(*ap, unsigned);
+        case 'l':
+            return va_arg(*ap, unsigned long);
+        case 'L':
+        case 'j':
+            return va_arg(*ap, unsigned long long);
+        case 'z':
+        case 't':
+            return va_arg(*ap, size_t);
+        default:
+            return va_arg(*ap, unsigned);
+    }
+}
+
+static void fmt_format(struct fmt_out* out, const char* fmt, va_list ap)
+{
+    va_list args;
+    va_copy(args, ap);
+
+    for (; *fmt != '\0'; fmt++) {
+        if (*fmt != '%') {
+            fmt_putc(out, *fmt);
+            continue;
+        }
+
+        const char* start = fmt++;
+        struct fmt_spec spec = { .flags = 0, .width = 0, .prec = -1 };
+
+        for (bool flag = true; flag; ) {
+            switch (*fmt) {
+                case '-': spec.flags |= FMT_LEFT; break;
+                case '+': spec.flags |= FMT_PLUS; break;
+                case ' ': spec.flags |= FMT_SPACE; break;
+                case '#': spec.flags |= FMT_ALT; break;
+                case '0': spec.flags |= FMT_ZERO; break;
+                default: flag = false; continue;
+            }
+            fmt++;
+        }
+
+        if (*fmt == '*') {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0) {
+                spec.flags |= FMT_LEFT;
+                spec.width = -spec.width;
+            }
+            fmt++;
+        } else {
+            for (; *fmt >= '0' && *fmt <= '9'; fmt++) {
+                spec.width = (spec.width * 10) + (*fmt - '0');
+            }
+        }
+
+        if (*fmt == '.') {
+            fmt++;
+            spec.prec = 0;
+            if (*fmt == '*') {
+                spec.prec = va_arg(args, int);
+                if (spec.prec < 0) {
+                    spec.prec = -1;
+                }
+                fmt++;
+            } else {
+                for (; *fmt >= '0' && *fmt <= '9'; fmt++) {
+                    spec.prec = (spec.prec * 10) + (*fmt - '0');
+                }
+            }
+        }
+
+        /* hh and ll are encoded as H and L */
+        char len = 0;
+        switch (*fmt) {
+            case 'h':
+            case 'l':
+                len = *fmt++;
+                if (*fmt == len) {
+                    len = (len == 'h') ? 'H' : 'L';
+                    fmt++;
+                }
+                break;
+            case 'z':
+            case 't':
+            case 'j':
+                len = *fmt++;
+                break;
+        }
+
+        if (spec.flags & FMT_LEFT) {
+            spec.flags &= ~FMT_ZERO;
+        }
+        if (spec.flags & FMT_PLUS) {
+            spec.flags &= ~FMT_SPACE;
+        }
+
+        char c = *fmt;
+        switch (c) {
+            case 'd':
+            case 'i': {
+                long long val = fmt_arg_signed(&args, len);
+                if (spec.prec >= 0) {
+                    spec.flags &= ~FMT_ZERO;
+                }
+                fmt_integer(out, &spec, (val < 0) ?
+                    -(unsigned long long)val : (unsigned long long)val,
+                    val < 0, 10);
+                break;
+            }
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': {
+                unsigned long long val = fmt_arg_unsigned(&args, len);
+                spec.flags &= ~(FMT_PLUS | FMT_SPACE);
+                if (spec.prec >= 0) {
+                    spec.flags &= ~FMT_ZERO;
+                }
+                if (c == 'X') {
+                    spec.flags |= FMT_UPPER;
+                }
+                fmt_integer(out, &spec, val, false,
+                    (c == 'u') ? 10 : (c == 'o') ? 8 : 16);
+                break;
+            }
+            case 'p':
+                spec.flags &= ~(FMT_PLUS | FMT_SPACE);
+                spec.flags |= FMT_ALT | FMT_PTR;
+                fmt_integer(out, &spec,
+                    (uintptr_t)va_arg(args, void*), false, 16);
+                break;
+            case 'c': {
+                char ch = (char)va_arg(args, int);
+                fmt_string(out, &spec, &ch, 1);
+                break;
+            }
+            case 's': {
+                const char* s = va_arg(args, const char*);
+                size_t n = 0;
+                if (s == NULL) {
+                    s = "(null)";
+                }
+                while (s[n] != '\0' && (spec.prec < 0 || n < (size_t)spec.prec)) {
+                    n++;
+                }
+                fmt_string(out, &spec, s, n);
+                break;
+            }
+            case '%':
+                fmt_putc(out, '%');
+                break;
+#ifdef PRINTF_FLOAT
+            case 'F':
+                spec.flags |= FMT_UPPER;
+                /* fallthrough */
+            case 'f':
+                fmt_float(out, &spec, va_arg(args, double));
+                break;
+#endif
+            default:
+#if !defined(AARCH64) || defined(SIMD)
+                /* Skip the argument so the following ones stay in sync */
+                if (c == 'f' || c == 'F' || c == 'e' || c == 'E' ||
+                    c == 'g' || c == 'G') {
+                    (void)va_arg(args, double);
+                }
+#endif
+                /* Unsupported conversions are printed as is */
+                for (; start <= fmt && *start != '\0'; start++) {
+                    fmt_putc(out, *start);
+                }
+                if (*fmt == '\0') {
+                    fmt--;
+                }
+                break;
+        }
+    }
+
+    va_end(args);
+}
+
+static void fmt_console_flush(struct fmt_out* out)
+{
+    console_write(out->buf, out->pos);
+    out->pos = 0;
+}
+
+int fmt_vsnprintf(char* buf, size_t size, const char* fmt, va_list ap)
+{
+    struct fmt_out out = {
+        .buf = buf,
+        .size = (size > 0) ? (size - 1) : 0,
+    };
+
+    fmt_format(&out, fmt, ap);
+    if (size > 0) {
+        buf[out.pos] = '\0';
+    }
+
+    return (int)out.total;
+}
+
+int fmt_snprintf(char* buf, size_t size, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = fmt_vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+int fmt_vprintf(const char* fmt, va_list ap)
+{
+    char buf[FMT_CONSOLE_BUF_SIZE];
+    struct fmt_out out = {
+        .buf = buf,
+        .size = sizeof(buf),
+        .flush = fmt_console_flush,
+    };
+
+    fmt_format(&out, fmt, ap);
+    fmt_console_flush(&out);
+
+    return (int)out.total;
+}
+
+int fmt_printf(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = fmt_vprintf(fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+#ifdef CORE_PRINTF
+
+int printf(const char* fmt, ...) __attribute__((alias("fmt_printf")));
+int vprintf(const char* fmt, va_list ap) __attribute__((alias("fmt_vprintf")));
+int snprintf(char* buf, size_t size, const char* fmt, ...)
+    __attribute__((alias("fmt_snprintf")));
+int vsnprintf(char* buf, size_t size, const char* fmt, va_list ap)
+    __attribute__((alias("fmt_vsnprintf")));
+
+int vsprintf(char* buf, const char* fmt, va_list ap)
+{
+    return fmt_vsnprintf(buf, SIZE_MAX, fmt, ap);
+}
+
+int sprintf(char* buf, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = fmt_vsnprintf(buf, SIZE_MAX, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+/* The compiler turns simple printf calls into these */
+int puts(const char* s)
+{
+    size_t len = strlen(s);
+    console_write(s, len);
+    console_write("\n", 1);
+    return (int)len + 1;
+}
+
+int putchar(int c)
+{
+    char ch = (char)c;
+    console_write(&ch, 1);
+    return (unsigned char)c;
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include <hotplug.h>
+#include <cpu.h>
+#include <cpu_pm.h>
+#include <irq.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <timer.h>
+#include <wait.h>
+#ifdef JOBS
+#include <jobs.h>
+#endif
+
+enum hotplug_state {
+    HOTPLUG_ONLINE,
+    HOTPLUG_DYING,      /* requested, leaves at its next idle point */
+    HOTPLUG_DEAD,       /* taken by the cpu, turning itself off, or off */
+};
+
+struct hotplug_cpu {
+    volatile uint32_t state;
+    unsigned long target;   /* takes over the interrupts and the timer */
+    uint64_t deadline;
+};
+
+static struct hotplug_cpu hotplug_cpus[NR_CPUS];
+static spinlock_t hotplug_lock = SPINLOCK_INITVAL;
+
+static void hotplug_set_state(struct hotplug_cpu* hc, enum hotplug_state state)
+{
+    __atomic_store_n(&hc->state, state, __ATOMIC_RELEASE);
+    wait_notify();
+}
+
+/* Runs on the target, the handler then fires there, once */
+static void hotplug_adopt_timer(void* arg)
+{
+    struct hotplug_cpu* hc = arg;
+
+    if (hc->deadline < timer_get_deadline()) {
+        timer_set_abs(hc->deadline);
+    }
+}
+
+/* Called with interrupts masked, returns once back online */
+static int hotplug_die(unsigned long cpu, struct hotplug_cpu* hc)
+{
+    hc->deadline = timer_get_deadline();
+    timer_set_abs(TIMER_NO_DEADLINE);
+    irq_migrate(cpu, hc->target);
+    if (hc->deadline != TIMER_NO_DEADLINE) {
+        smp_call(hc->target, hotplug_adopt_timer, hc, false);
+    }
+#ifdef JOBS
+    cpumask_t online;
+    smp_online_cpus(&online);
+    jobs_wake(&online);
+#endif
+    smp_cpu_dying();
+
+    hotplug_set_state(hc, HOTPLUG_DEAD);
+    int ret = cpu_off();
+
+    /* Restarted by cpu_up, or refused by the firmware */
+    smp_set_online(cpu, true);
+    hotplug_set_state(hc, HOTPLUG_ONLINE);
+    smp_poll();
+
+    return ret > 0 ? 0 : -1;
+}
+
+void hotplug_check()
+{
+    unsigned long cpu = get_cpuid();
+    struct hotplug_cpu* hc = &hotplug_cpus[cpu];
+
+    uint32_t dying = HOTPLUG_DYING;
+
+    /* Taken from cpu_down, which may give up on it meanwhile */
+    if (__atomic_load_n(&hc->state, __ATOMIC_RELAXED) == HOTPLUG_DYING &&
+        __atomic_compare_exchange_n(&hc->state, &dying, HOTPLUG_DEAD, false,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        unsigned long flags = arch_irq_save();
+        hotplug_die(cpu, hc);
+        arch_irq_restore(flags);
+    }
+}
+
+int cpu_down(unsigned long cpu)
+{
+    unsigned long self = get_cpuid();
+    bool ok = false;
+
+    if (cpu >= NR_CPUS) {
+        return -1;
+    }
+
+    struct hotplug_cpu* hc = &hotplug_cpus[cpu];
+
+    spin_lock(&hotplug_lock);
+    cpumask_t others;
+    smp_online_cpus(&others);
+    cpumask_clear_cpu(&others, cpu);
+    if (smp_cpu_online(cpu) && !cpumask_empty(&others)) {
+        hc->target = (cpu != self) ? self : cpumask_first(&others);
+        smp_set_online(cpu, false);
+        hotplug_set_state(hc, HOTPLUG_DYING);
+        ok = true;
+    }
+    spin_unlock(&hotplug_lock);
+
+    if (!ok) {
+        return -1;
+    } else if (cpu == self) {
+        unsigned long flags = arch_irq_save();
+        int ret = hotplug_die(cpu, hc);
+        arch_irq_restore(flags);
+        return ret;
+    }
+
+    /**
+     * Out of wfi, to its idle loop. If it does not get there, e.g. its role
+     * never idles, the request is withdrawn unless it was taken meanwhile.
+     */
+    smp_send_ipi(cpu, SMP_IPI_CALL);
+    uint32_t dying = HOTPLUG_DYING;
+    if (!wait_while_eq(&hc->state, HOTPLUG_DYING,
+            TIME_US(HOTPLUG_TIMEOUT_US)) &&
+        __atomic_compare_exchange_n(&hc->state, &dying, HOTPLUG_ONLINE,
+            false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        smp_set_online(cpu, true);
+        return -1;
+    }
+    wait_until(hc->state != HOTPLUG_DEAD || cpu_is_off(cpu),
+        TIME_US(HOTPLUG_TIMEOUT_US));
+
+    return hc->state == HOTPLUG_DEAD ? 0 : -1;
+}
+
+int cpu_up(unsigned long cpu)
+{
+    int ret = -1;
+
+    if (cpu >= NR_CPUS) {
+        return -1;
+    }
+
+    struct hotplug_cpu* hc = &hotplug_cpus[cpu];
+
+    spin_lock(&hotplug_lock);
+    if (hc->state == HOTPLUG_DEAD &&
+        wait_until(cpu_is_off(cpu), TIME_US(HOTPLUG_TIMEOUT_US))) {
+        ret = cpu_on(cpu);
+    }
+    if (ret == 0 && !wait_until(hc->state == HOTPLUG_ONLINE,
+            TIME_US(HOTPLUG_TIMEOUT_US))) {
+        ret = -1;
+    }
+    spin_unlock(&hotplug_lock);
+
+    return ret;
+}
+
+bool cpu_online(unsigned long cpu)
+{
+    return smp_cpu_online(cpu);
+}
@@ -0,0 +1,93 @@
+#include <idle.h>
+#include <cpu.h>
+#include <irq.h>
+#include <timer.h>
+#include <wfi.h>
+
+/* Weight of the latest idle duration in the average, as a shift */
+#define IDLE_AVG_SHIFT  (3)
+
+struct idle_cpu {
+    bool limited;
+    uint32_t latency_limit_us;
+    uint64_t avg_idle;          /* ticks */
+    struct idle_stats stats[IDLE_MAX_STATES];
+};
+
+static struct idle_cpu idle_cpus[NR_CPUS];
+/* Refused by the firmware. Power states are the same for every cpu */
+static volatile bool idle_state_off[IDLE_MAX_STATES];
+
+/**
+ * The expected idle duration is the time to the next timer deadline, if
+ * any, bounded by the average of the past ones. This keeps cpus woken up by
+ * IPIs out of states they would leave before they pay off. The average
+ * starts at 0, so a cpu learns its idle pattern in wfi first.
+ */
+static size_t idle_select(struct idle_cpu* cpu, uint64_t now)
+{
+    uint64_t deadline = timer_get_deadline();
+    uint64_t expected = cpu->avg_idle;
+    size_t selected = 0;
+
+    if (deadline != TIMER_NO_DEADLINE && deadline > now &&
+        deadline - now < expected) {
+        expected = deadline - now;
+    }
+
+    for (size_t i = 1; i < idle_states_num && i < IDLE_MAX_STATES; i++) {
+        const struct idle_state* state = &idle_states[i];
+        if (idle_state_off[i] ||
+            (cpu->limited && state->exit_latency_us > cpu->latency_limit_us) ||
+            TIME_US(state->target_residency_us) > expected) {
+            continue;
+        }
+        selected = i;
+    }
+
+    return selected;
+}
+
+void idle_enter()
+{
+    struct idle_cpu* cpu = &idle_cpus[get_cpuid()];
+    unsigned long flags = arch_irq_save();
+    uint64_t start = timer_get();
+    size_t i = idle_select(cpu, start);
+    const struct idle_state* state = &idle_states[i];
+
+    if (!state->enter(state)) {
+        idle_state_off[i] = true;
+        wfi();
+    }
+
+    uint64_t residency = timer_get() - start;
+    struct idle_stats* stats = &cpu->stats[i];
+    stats->entries++;
+    stats->residency += residency;
+    if (residency < TIME_US(state->target_residency_us)) {
+        stats->early_wakeups++;
+    }
+    cpu->avg_idle = cpu->avg_idle - (cpu->avg_idle >> IDLE_AVG_SHIFT) +
+        (residency >> IDLE_AVG_SHIFT);
+
+    arch_irq_restore(flags);
+}
+
+void idle_set_latency_limit(uint32_t us)
+{
+    struct idle_cpu* cpu = &idle_cpus[get_cpuid()];
+
+    cpu->latency_limit_us = us;
+    cpu->limited = us != IDLE_NO_LATENCY_LIMIT;
+}
+
+const struct idle_stats* idle_get_stats(unsigned long cpu, size_t state)
+{
+    if (cpu >= NR_CPUS || state >= idle_states_num ||
+        state >= IDLE_MAX_STATES) {
+        return NULL;
+    }
+
+    return &idle_cpus[cpu].stats[state];
+}
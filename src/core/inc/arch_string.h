@@ -0,0 +1,15 @@
+#ifndef ARCH_STRING_H
+#define ARCH_STRING_H
+
+#include <core.h>
+
+/**
+ * Arch optimized string routines. With ARCH_STRING (the default) they also
+ * replace the libc functions of the same name.
+ */
+void* arch_memcpy(void* dst, const void* src, size_t n);
+void* arch_memset(void* dst, int c, size_t n);
+int arch_memcmp(const void* s1, const void* s2, size_t n);
+size_t arch_strlen(const char* s);
+
+#endif /* ARCH_STRING_H */
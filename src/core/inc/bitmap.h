@@ -0,0 +1,192 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <core.h>
+
+/**
+ * Bitmaps of any size, as arrays of unsigned long. Searches skip clear words
+ * whole and find the set bits in a word with ctz, so walking a sparse map
+ * costs a step per word plus one per set bit. Bits past the size are
+ * ignored, whatever their value, so maps can be filled a word at a time.
+ */
+
+#define BITS_PER_LONG       (sizeof(unsigned long) * 8)
+#define BITMAP_WORDS(BITS)  (((BITS) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define BITMAP_WORD(BIT)    ((BIT) / BITS_PER_LONG)
+#define BITMAP_BIT(BIT)     (1UL << ((BIT) % BITS_PER_LONG))
+
+/* The same for maps of 32-bit registers, which must be accessed as such */
+#define BITMAP32_WORD(BIT)  ((BIT) / 32)
+#define BITMAP32_BIT(BIT)   (1U << ((BIT) % 32))
+
+/* Valid bits of word i of a map of size bits */
+static inline unsigned long bitmap_word_mask(size_t bits, size_t i)
+{
+    size_t left = bits - i * BITS_PER_LONG;
+    return left >= BITS_PER_LONG ? ~0UL : BITMAP_BIT(left) - 1;
+}
+
+static inline void bitmap_set(unsigned long* map, size_t bit)
+{
+    map[BITMAP_WORD(bit)] |= BITMAP_BIT(bit);
+}
+
+static inline void bitmap_clear(unsigned long* map, size_t bit)
+{
+    map[BITMAP_WORD(bit)] &= ~BITMAP_BIT(bit);
+}
+
+static inline bool bitmap_test(const unsigned long* map, size_t bit)
+{
+    return (map[BITMAP_WORD(bit)] & BITMAP_BIT(bit)) != 0;
+}
+
+static inline void bitmap_set_atomic(unsigned long* map, size_t bit)
+{
+    __atomic_fetch_or(&map[BITMAP_WORD(bit)], BITMAP_BIT(bit),
+        __ATOMIC_SEQ_CST);
+}
+
+static inline void bitmap_clear_atomic(unsigned long* map, size_t bit)
+{
+    __atomic_fetch_and(&map[BITMAP_WORD(bit)], ~BITMAP_BIT(bit),
+        __ATOMIC_SEQ_CST);
+}
+
+/* Return whether the bit was set before */
+static inline bool bitmap_test_and_set_atomic(unsigned long* map, size_t bit)
+{
+    return (__atomic_fetch_or(&map[BITMAP_WORD(bit)], BITMAP_BIT(bit),
+        __ATOMIC_SEQ_CST) & BITMAP_BIT(bit)) != 0;
+}
+
+static inline bool bitmap_test_and_clear_atomic(unsigned long* map,
+    size_t bit)
+{
+    return (__atomic_fetch_and(&map[BITMAP_WORD(bit)], ~BITMAP_BIT(bit),
+        __ATOMIC_SEQ_CST) & BITMAP_BIT(bit)) != 0;
+}
+
+static inline void bitmap_zero(unsigned long* map, size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        map[i] = 0;
+    }
+}
+
+static inline void bitmap_fill(unsigned long* map, size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        map[i] = ~0UL;
+    }
+}
+
+static inline void bitmap_copy(unsigned long* dst, const unsigned long* src,
+    size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        dst[i] = src[i];
+    }
+}
+
+static inline void bitmap_and(unsigned long* dst, const unsigned long* a,
+    const unsigned long* b, size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        dst[i] = a[i] & b[i];
+    }
+}
+
+static inline void bitmap_or(unsigned long* dst, const unsigned long* a,
+    const unsigned long* b, size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        dst[i] = a[i] | b[i];
+    }
+}
+
+static inline void bitmap_andnot(unsigned long* dst, const unsigned long* a,
+    const unsigned long* b, size_t bits)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        dst[i] = a[i] & ~b[i];
+    }
+}
+
+/* First set bit at or after start, or bits if there is none */
+static inline size_t bitmap_find_next(const unsigned long* map, size_t bits,
+    size_t start)
+{
+    if (start >= bits) {
+        return bits;
+    }
+
+    size_t i = BITMAP_WORD(start);
+    unsigned long word = map[i] & ~(BITMAP_BIT(start) - 1);
+
+    while (true) {
+        word &= bitmap_word_mask(bits, i);
+        if (word != 0) {
+            return i * BITS_PER_LONG + __builtin_ctzl(word);
+        }
+        if (++i >= BITMAP_WORDS(bits)) {
+            return bits;
+        }
+        word = map[i];
+    }
+}
+
+/* Last set bit, or bits if there is none */
+static inline size_t bitmap_find_last(const unsigned long* map, size_t bits)
+{
+    for (size_t i = BITMAP_WORDS(bits); i-- > 0;) {
+        unsigned long word = map[i] & bitmap_word_mask(bits, i);
+        if (word != 0) {
+            return i * BITS_PER_LONG + BITS_PER_LONG - 1 - __builtin_clzl(word);
+        }
+    }
+
+    return bits;
+}
+
+static inline bool bitmap_empty(const unsigned long* map, size_t bits)
+{
+    return bitmap_find_next(map, bits, 0) >= bits;
+}
+
+static inline size_t bitmap_weight(const unsigned long* map, size_t bits)
+{
+    size_t weight = 0;
+
+    for (size_t i = 0; i < BITMAP_WORDS(bits); i++) {
+        weight += __builtin_popcountl(map[i] & bitmap_word_mask(bits, i));
+    }
+
+    return weight;
+}
+
+/* The bits in [start, start + BITS_PER_LONG), as a word */
+static inline unsigned long bitmap_get_window(const unsigned long* map,
+    size_t bits, size_t start)
+{
+    if (start >= bits) {
+        return 0;
+    }
+
+    size_t i = BITMAP_WORD(start);
+    size_t off = start % BITS_PER_LONG;
+    unsigned long word = (map[i] & bitmap_word_mask(bits, i)) >> off;
+
+    if (off != 0 && i + 1 < BITMAP_WORDS(bits)) {
+        word |= (map[i + 1] & bitmap_word_mask(bits, i + 1)) <<
+            (BITS_PER_LONG - off);
+    }
+
+    return word;
+}
+
+#define bitmap_for_each(BIT, MAP, BITS)                  \
+    for ((BIT) = bitmap_find_next((MAP), (BITS), 0); (BIT) < (BITS); \
+         (BIT) = bitmap_find_next((MAP), (BITS), (BIT) + 1))
+
+#endif /* BITMAP_H */
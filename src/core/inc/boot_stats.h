@@ -0,0 +1,39 @@
+#ifndef BOOT_STATS_H
+#define BOOT_STATS_H
+
+#include <core.h>
+
+/**
+ * Boot phases whose end is timestamped when building with BOOT_STATS. The
+ * first two are recorded by the primary cpu in start.S: the timer value at
+ * the entry point and right after bss is cleared.
+ */
+enum boot_phase {
+    BOOT_PHASE_ENTRY,
+    BOOT_PHASE_BSS,
+    BOOT_PHASE_CONSOLE,
+    BOOT_PHASE_ARCH,
+    BOOT_PHASE_NUM
+};
+
+#ifdef BOOT_STATS
+
+#include <timer.h>
+
+extern uint64_t boot_timestamps[BOOT_PHASE_NUM];
+
+static inline void boot_timestamp(enum boot_phase phase)
+{
+    boot_timestamps[phase] = timer_get();
+}
+
+void boot_stats_print();
+
+#else
+
+static inline void boot_timestamp(enum boot_phase phase) { }
+static inline void boot_stats_print() { }
+
+#endif
+
+#endif /* BOOT_STATS_H */
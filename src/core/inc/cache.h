@@ -0,0 +1,24 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <core.h>
+
+/**
+ * Data cache maintenance by virtual address range. Ranges need not be line
+ * aligned: clean and flush operate on every line touched by the range, while
+ * inval cleans the partial lines at the edges so that data sharing those lines
+ * with the range is not lost. All operations complete (i.e. are visible to
+ * other observers) before returning.
+ */
+size_t cache_line_size();
+void cache_clean_range(void* addr, size_t size);
+void cache_inval_range(void* addr, size_t size);
+void cache_flush_range(void* addr, size_t size);
+
+/**
+ * Zeroes the range, using whole cache line zeroing instructions for the
+ * line-aligned part when available, avoiding the line fills.
+ */
+void mem_zero_lines(void* addr, size_t size);
+
+#endif /* CACHE_H */
@@ -0,0 +1,15 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <core.h>
+
+/**
+ * Internet (RFC 1071) checksum: the ones' complement of the ones' complement
+ * sum of the buffer taken as little-endian 16-bit words, a trailing odd byte
+ * being padded with zero. checksum16 may be replaced by an arch optimized
+ * version which falls back to checksum16_generic for cases it does not handle.
+ */
+uint16_t checksum16(const void* buf, size_t size);
+uint16_t checksum16_generic(const void* buf, size_t size);
+
+#endif /* CHECKSUM_H */
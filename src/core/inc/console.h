@@ -0,0 +1,14 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <core.h>
+
+/**
+ * Writes len characters to the console: the shared memory ring when built
+ * with SHMEM_CONSOLE_BASE and once it is set up, otherwise the UART,
+ * translating "\n" into "\r\n". Used both by the libc _write hook and
+ * directly by the core printf.
+ */
+void console_write(const char* buf, size_t len);
+
+#endif /* CONSOLE_H */
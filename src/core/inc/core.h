@@ -34,4 +34,8 @@
 
 #endif
 
+#ifndef NR_CPUS
+#define NR_CPUS (8)
+#endif
+
 #endif /* CORE_H */
@@ -0,0 +1,43 @@
+#ifndef CPU_PM_H
+#define CPU_PM_H
+
+#include <core.h>
+#include <arch/cpu_pm.h>
+
+/**
+ * Powering cpus down and back up through the firmware, PSCI or SBI HSM, for
+ * the idle states and cpu hotplug. A cpu that loses its context comes back
+ * at _cpu_resume, which redoes its system register and MMU setup, but not
+ * the one-time init, and returns from cpu_ctx_save a second time. The
+ * interrupt controller and timer state of the cpu are then restored, so the
+ * calls below return to their caller as if the cpu never left. Call them
+ * with interrupts masked.
+ */
+
+/**
+ * Suspends the calling cpu in the firmware power state. Returns 1 if it lost
+ * its context, 0 if it woke up before, with nothing lost, or -1 if the
+ * firmware refused the state.
+ */
+int cpu_powerdown(unsigned long state);
+
+/**
+ * Turns the calling cpu off. Returns -1 if the firmware refused, or 1 once
+ * another cpu restarted it with cpu_on.
+ */
+int cpu_off();
+
+/* Restarts a cpu turned off by cpu_off. Returns 0 or -1 */
+int cpu_on(unsigned long cpu);
+bool cpu_is_off(unsigned long cpu);
+
+/**
+ * int cpu_ctx_save(unsigned long* ctx) saves the callee-saved registers to
+ * ctx, of ARCH_CPU_CTX_SIZE bytes, and returns 0. Once the cpu is powered
+ * down and resumed through _cpu_resume, with ctx as its argument, it returns
+ * from it again with 1.
+ */
+int cpu_ctx_save(unsigned long* ctx) __attribute__((returns_twice));
+void _cpu_resume();
+
+#endif /* CPU_PM_H */
@@ -0,0 +1,48 @@
+#ifndef CPU_ROLE_H
+#define CPU_ROLE_H
+
+#include <core.h>
+
+/**
+ * Core specialization. The application can give each cpu its own entry
+ * point, run instead of main, local interrupt masking and idle policy, e.g.
+ * cpu 0 running main and taking every interrupt while the others busy poll
+ * IPC channels with interrupts masked, free of interrupt and wfi wake up
+ * latencies.
+ *
+ * A cpu with interrupts masked still serves smp cross calls and IPI reasons,
+ * but only at its idle points, in cpu_idle. It can not run the scheduler.
+ */
+
+enum cpu_idle_policy {
+    CPU_IDLE_WFI,       /* sleep until the next interrupt, see idle.h */
+    CPU_IDLE_POLL,      /* return right away, polling for work */
+};
+
+struct cpu_role {
+    const char* name;
+    int (*entry)();                 /* NULL: main */
+    bool irqs_off;                  /* implies CPU_IDLE_POLL */
+    enum cpu_idle_policy idle;
+};
+
+/**
+ * Roles, indexed by cpu id, defined by the application. Cpus without a role,
+ * a zeroed entry, or every cpu if there is no table, run main with
+ * interrupts enabled and sleep in wfi when idle.
+ */
+extern const struct cpu_role cpu_roles[NR_CPUS] __attribute__((weak));
+
+const struct cpu_role* cpu_role();
+
+/* Applies the calling cpu's interrupt masking, before it enters its role */
+void cpu_role_init();
+
+/**
+ * Waits for work according to the calling cpu's idle policy. Callers check
+ * for work and call it in a loop, with interrupts masked around the check if
+ * the work is signaled by an interrupt: wfi still wakes up on it.
+ */
+void cpu_idle();
+
+#endif /* CPU_ROLE_H */
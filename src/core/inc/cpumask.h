@@ -0,0 +1,124 @@
+#ifndef CPUMASK_H
+#define CPUMASK_H
+
+#include <bitmap.h>
+
+/**
+ * Sets of cpus, by logical id, sized by NR_CPUS. Passed by pointer, they
+ * can be larger than a word. Walk them with for_each_cpu, which only visits
+ * the set cpus.
+ */
+
+typedef struct {
+    unsigned long bits[BITMAP_WORDS(NR_CPUS)];
+} cpumask_t;
+
+#define CPUMASK_NONE    ((cpumask_t){ { 0 } })
+#define CPUMASK_ALL     \
+    ((cpumask_t){ { [0 ... BITMAP_WORDS(NR_CPUS) - 1] = ~0UL } })
+
+#define for_each_cpu(CPU, MASK) bitmap_for_each(CPU, (MASK)->bits, NR_CPUS)
+
+static inline cpumask_t cpumask_of(unsigned long cpu)
+{
+    cpumask_t mask = CPUMASK_NONE;
+    if (cpu < NR_CPUS) {
+        bitmap_set(mask.bits, cpu);
+    }
+    return mask;
+}
+
+static inline void cpumask_set_cpu(cpumask_t* mask, unsigned long cpu)
+{
+    bitmap_set(mask->bits, cpu);
+}
+
+static inline void cpumask_clear_cpu(cpumask_t* mask, unsigned long cpu)
+{
+    bitmap_clear(mask->bits, cpu);
+}
+
+static inline bool cpumask_test_cpu(const cpumask_t* mask, unsigned long cpu)
+{
+    return cpu < NR_CPUS && bitmap_test(mask->bits, cpu);
+}
+
+static inline void cpumask_set_cpu_atomic(cpumask_t* mask, unsigned long cpu)
+{
+    bitmap_set_atomic(mask->bits, cpu);
+}
+
+static inline void cpumask_clear_cpu_atomic(cpumask_t* mask,
+    unsigned long cpu)
+{
+    bitmap_clear_atomic(mask->bits, cpu);
+}
+
+static inline bool cpumask_test_and_clear_cpu_atomic(cpumask_t* mask,
+    unsigned long cpu)
+{
+    return bitmap_test_and_clear_atomic(mask->bits, cpu);
+}
+
+static inline void cpumask_and(cpumask_t* dst, const cpumask_t* a,
+    const cpumask_t* b)
+{
+    bitmap_and(dst->bits, a->bits, b->bits, NR_CPUS);
+}
+
+static inline void cpumask_or(cpumask_t* dst, const cpumask_t* a,
+    const cpumask_t* b)
+{
+    bitmap_or(dst->bits, a->bits, b->bits, NR_CPUS);
+}
+
+static inline void cpumask_andnot(cpumask_t* dst, const cpumask_t* a,
+    const cpumask_t* b)
+{
+    bitmap_andnot(dst->bits, a->bits, b->bits, NR_CPUS);
+}
+
+static inline bool cpumask_empty(const cpumask_t* mask)
+{
+    return bitmap_empty(mask->bits, NR_CPUS);
+}
+
+static inline size_t cpumask_weight(const cpumask_t* mask)
+{
+    return bitmap_weight(mask->bits, NR_CPUS);
+}
+
+/* First cpu in mask at or after cpu, or NR_CPUS */
+static inline unsigned long cpumask_next(const cpumask_t* mask,
+    unsigned long cpu)
+{
+    return bitmap_find_next(mask->bits, NR_CPUS, cpu);
+}
+
+static inline unsigned long cpumask_first(const cpumask_t* mask)
+{
+    return cpumask_next(mask, 0);
+}
+
+static inline unsigned long cpumask_last(const cpumask_t* mask)
+{
+    return bitmap_find_last(mask->bits, NR_CPUS);
+}
+
+/**
+ * Splits mask in windows of a word, as taken by the SBI hart mask calls:
+ * returns the cpus in [*base, *base + BITS_PER_LONG) as bits of a word, with
+ * *base moved to the first cpu at or after start. Returns 0 once there are
+ * no cpus left, i.e.
+ *
+ *  for (base = 0; (word = cpumask_window(mask, base, &base)) != 0;
+ *       base += BITS_PER_LONG)
+ */
+static inline unsigned long cpumask_window(const cpumask_t* mask,
+    unsigned long start, unsigned long* base)
+{
+    *base = cpumask_next(mask, start);
+    return bitmap_get_window(mask->bits, NR_CPUS, *base);
+}
+
+#endif /* CPUMASK_H */
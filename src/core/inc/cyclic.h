@@ -0,0 +1,82 @@
+#ifndef CYCLIC_H
+#define CYCLIC_H
+
+#include <core.h>
+
+/**
+ * Time-triggered cyclic executive, built with CYCLIC=y. Each cpu repeats a
+ * static table of jobs released at fixed offsets within its major frame.
+ * Release times are absolute, counted from an epoch shared by all cpus, so
+ * the frames of every cpu stay phase-locked to the common system timer and
+ * do not drift. Jobs run to completion in cyclic_run's context with
+ * interrupts enabled. The executive owns the timer interrupt.
+ *
+ * A job overruns if it is still running at its deadline: its release plus
+ * its budget or, without a budget, the next release. Overruns are counted
+ * and reported through cyclic_overrun. Jobs released late run right away,
+ * whole frames that were missed are skipped.
+ */
+
+/* Jobs per table */
+#ifndef CYCLIC_MAX_JOBS
+#define CYCLIC_MAX_JOBS     (32)
+#endif
+
+/* Delay from the first cpu starting to the first frame, to let others join */
+#ifndef CYCLIC_START_DELAY_US
+#define CYCLIC_START_DELAY_US   (1000)
+#endif
+
+/**
+ * Time before a release at which the cpu stops waiting for the interrupt and
+ * polls the timer instead, trading that time for wake up jitter.
+ */
+#ifndef CYCLIC_SPIN_US
+#define CYCLIC_SPIN_US      (0)
+#endif
+
+struct cyclic_job {
+    uint32_t offset_us;     /* release, from the start of the frame */
+    uint32_t budget_us;     /* 0: up to the next release */
+    void (*fn)(void* arg);
+    void* arg;
+    const char* name;
+};
+
+struct cyclic_table {
+    uint32_t frame_us;
+    size_t num_jobs;
+    const struct cyclic_job* jobs;  /* by increasing offset */
+};
+
+#define CYCLIC_TABLE(FRAME_US, JOBS) \
+    { (FRAME_US), sizeof(JOBS) / sizeof((JOBS)[0]), (JOBS) }
+
+/**
+ * Schedule, indexed by cpu id, defined by the application. A cpu without
+ * jobs, or any cpu if there are no tables, just waits for interrupts in
+ * cyclic_run.
+ */
+extern const struct cyclic_table cyclic_tables[NR_CPUS]
+    __attribute__((weak));
+
+struct cyclic_stats {
+    uint64_t frames;
+    uint64_t overruns;
+    uint64_t skipped_frames;
+    uint64_t max_release_jitter;    /* ticks from release to job start */
+};
+
+/* Runs this cpu's table forever */
+void cyclic_run() __attribute__((noreturn));
+
+const struct cyclic_stats* cyclic_get_stats(unsigned long cpu);
+
+/**
+ * Called after a job overran its deadline by late ticks. The default prints
+ * it. Runs in the executive's context, so it delays the next release.
+ */
+void cyclic_overrun(unsigned long cpu, const struct cyclic_job* job,
+    uint64_t late);
+
+#endif /* CYCLIC_H */
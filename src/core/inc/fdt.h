@@ -0,0 +1,69 @@
+#ifndef FDT_H
+#define FDT_H
+
+#include <core.h>
+
+#define FDT_MAGIC       (0xd00dfeed)
+
+#define FDT_BEGIN_NODE  (0x1)
+#define FDT_END_NODE    (0x2)
+#define FDT_PROP        (0x3)
+#define FDT_NOP         (0x4)
+#define FDT_END         (0x9)
+
+/**
+ * Address of the flattened device tree handed over by the previous boot stage
+ * (x0 on aarch64, r2 on aarch32, a1 on riscv), saved by the primary cpu in
+ * start.S. The blob is only used if its header is valid.
+ */
+extern const void* fdt_blob;
+
+/**
+ * Minimal read-only device tree access. Nodes are identified by their offset
+ * in the structure block, the root node being at offset 0. Functions return
+ * a negative value (or NULL) if the node or property is not found or if there
+ * is no valid device tree.
+ */
+bool fdt_valid();
+int fdt_next_node(int node, int* depth);
+int fdt_first_subnode(int node);
+int fdt_next_subnode(int node);
+int fdt_parent(int node);
+int fdt_path_offset(const char* path);
+int fdt_node_offset_by_compatible(int start, const char* compat);
+const char* fdt_get_name(int node);
+const void* fdt_getprop(int node, const char* name, int* len);
+/* A one-cell property, dflt if it is missing or of another size */
+uint32_t fdt_getprop_u32(int node, const char* name, uint32_t dflt);
+/* Whether a string list property holds str */
+bool fdt_prop_has_string(int node, const char* name, const char* str);
+bool fdt_node_is_compatible(int node, const char* compat);
+bool fdt_node_is_available(int node);
+int fdt_get_reg(int node, size_t idx, uint64_t* addr, uint64_t* size);
+
+#define fdt_for_each_subnode(node, parent) \
+    for (node = fdt_first_subnode(parent); node >= 0; \
+        node = fdt_next_subnode(node))
+
+/**
+ * Platform description. Defaults come from plat.h and are overridden by
+ * fdt_discover with what is found in the device tree: the cpus to bring up,
+ * the end of the memory region holding the image (which bounds the heap) and
+ * the console UART (uart_addr), if the platform names its compatible string in
+ * PLAT_UART_COMPATIBLE.
+ */
+extern size_t fdt_cpu_num;
+extern unsigned long fdt_cpu_ids[NR_CPUS];
+extern uint64_t mem_limit;
+
+void fdt_discover();
+
+/**
+ * Arch hooks called by fdt_discover. arch_fdt_discover looks up the interrupt
+ * controller. arch_mem_map makes [start, end) usable as normal memory and
+ * returns the end of what could actually be mapped.
+ */
+void arch_fdt_discover();
+uint64_t arch_mem_map(uint64_t start, uint64_t end);
+
+#endif /* FDT_H */
@@ -0,0 +1,23 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <core.h>
+#include <stdarg.h>
+
+/**
+ * Allocation-free printf engine. Supports the flags "-+ #0", width and
+ * precision (also as "*"), the hh, h, l, ll, z, t and j length modifiers and
+ * the d, i, u, o, x, X, c, s, p and % conversions. %f is supported when
+ * building with PRINTF_FLOAT. Output is formatted straight into the
+ * destination buffer or, for the console functions, into a small stack
+ * buffer flushed to console_write.
+ *
+ * With CORE_PRINTF (the default) these also replace printf, vprintf,
+ * snprintf, vsnprintf, sprintf, vsprintf, puts and putchar from libc.
+ */
+int fmt_vsnprintf(char* buf, size_t size, const char* fmt, va_list ap);
+int fmt_snprintf(char* buf, size_t size, const char* fmt, ...);
+int fmt_vprintf(const char* fmt, va_list ap);
+int fmt_printf(const char* fmt, ...);
+
+#endif /* FMT_H */
@@ -0,0 +1,47 @@
+#ifndef HOTPLUG_H
+#define HOTPLUG_H
+
+#include <core.h>
+
+/**
+ * Cpu hotplug, built with HOTPLUG=y, to park cpus under light load and bring
+ * them back within a few hundred microseconds. A cpu taken down leaves at its
+ * next idle point, in cpu_idle:
+ *
+ * - its shared interrupts move to the cpu that called cpu_down, or to
+ *   another online cpu if it called it on itself;
+ * - that cpu also adopts its timer deadline, if earlier than its own, so
+ *   the timer handler runs there instead;
+ * - its queued smp calls run, further ones are refused, and idle job system
+ *   workers are woken to steal the jobs left in its deque;
+ * - it turns itself off through PSCI CPU_OFF or SBI HSM hart_stop.
+ *
+ * cpu_up restarts it at _cpu_resume, skipping the bss clear and one-time
+ * init, and it carries on from cpu_idle. Moved interrupts are not moved back.
+ * Offline cpus are skipped by smp calls and the job system. Not available
+ * with SCHED or CYCLIC, whose threads and tables are bound to their cpu.
+ */
+
+/* Wait for a cpu to reach its idle point, to be reported off, or back */
+#ifndef HOTPLUG_TIMEOUT_US
+#define HOTPLUG_TIMEOUT_US  (10000)
+#endif
+
+/**
+ * Takes cpu offline. Returns once it is off, or once it is back online if
+ * it is the calling cpu. Returns -1 if cpu is not online, i.e. never came
+ * up or is already down, if it is the last one online, if it did not reach
+ * an idle point within HOTPLUG_TIMEOUT_US, in which case it stays online,
+ * or if the firmware refused to turn it off.
+ */
+int cpu_down(unsigned long cpu);
+
+/* Brings cpu back online. Returns -1 if it was online or did not come back */
+int cpu_up(unsigned long cpu);
+
+bool cpu_online(unsigned long cpu);
+
+/* Called by cpu_idle, takes the calling cpu down if it was requested */
+void hotplug_check();
+
+#endif /* HOTPLUG_H */
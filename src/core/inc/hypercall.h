@@ -0,0 +1,16 @@
+#ifndef HYPERCALL_H
+#define HYPERCALL_H
+
+#include <core.h>
+#include <arch/hypercall.h>
+
+#define HC_IPC  (1)
+
+/* Raises event on the shared memory channel ipc_id, interrupting the peer */
+static inline long hypercall_ipc_notify(unsigned long ipc_id,
+    unsigned long event)
+{
+    return arch_hypercall(HC_IPC, ipc_id, event, 0);
+}
+
+#endif /* HYPERCALL_H */
@@ -0,0 +1,69 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <core.h>
+#include <arch/idle.h>
+
+/**
+ * Idle states and governor, built with IDLE=y. With it, cpus with the
+ * CPU_IDLE_WFI policy idle in the deepest state of the arch's idle_states
+ * table that pays off: one whose target residency fits before the next timer
+ * deadline and the recent idle durations of the cpu, and whose exit latency
+ * is within the cpu's latency limit. States deeper than wfi are entered
+ * through the firmware, PSCI CPU_SUSPEND or SBI HSM hart_suspend, see
+ * cpu_pm.h for the states that lose the cpu context.
+ */
+
+/* Idle states per arch table */
+#define IDLE_MAX_STATES     (4)
+
+/* Platform defaults, in us, for the states deeper than wfi */
+#ifndef PLAT_IDLE_RETENTION_LATENCY_US
+#define PLAT_IDLE_RETENTION_LATENCY_US      (10)
+#endif
+#ifndef PLAT_IDLE_RETENTION_RESIDENCY_US
+#define PLAT_IDLE_RETENTION_RESIDENCY_US    (50)
+#endif
+#ifndef PLAT_IDLE_POWERDOWN_LATENCY_US
+#define PLAT_IDLE_POWERDOWN_LATENCY_US      (500)
+#endif
+#ifndef PLAT_IDLE_POWERDOWN_RESIDENCY_US
+#define PLAT_IDLE_POWERDOWN_RESIDENCY_US    (2000)
+#endif
+
+#define IDLE_NO_LATENCY_LIMIT   (~0U)
+
+struct idle_state {
+    const char* name;
+    uint32_t exit_latency_us;
+    uint32_t target_residency_us;   /* below it the state costs more than wfi */
+    /**
+     * Enters the state with interrupts masked, returns once woken up. Returns
+     * false if the firmware refused it, which disables the state.
+     */
+    bool (*enter)(const struct idle_state* state);
+    unsigned long param;            /* firmware power state */
+};
+
+/* Shallowest first, starting with wfi, defined by the arch */
+extern const struct idle_state idle_states[];
+extern const size_t idle_states_num;
+
+struct idle_stats {
+    uint64_t entries;
+    uint64_t residency;         /* ticks */
+    uint64_t early_wakeups;     /* woke before the target residency */
+};
+
+/* Idles the calling cpu once, in the state picked by the governor */
+void idle_enter();
+
+/**
+ * Bounds the exit latency of the states the calling cpu idles in, e.g. 0 to
+ * keep it in wfi. IDLE_NO_LATENCY_LIMIT, the default, lifts it.
+ */
+void idle_set_latency_limit(uint32_t us);
+
+const struct idle_stats* idle_get_stats(unsigned long cpu, size_t state);
+
+#endif /* IDLE_H */
@@ -0,0 +1,105 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <core.h>
+#include <spinlock.h>
+
+#define IPC_MAGIC       (0x43504942) /* "BIPC" */
+#define IPC_CACHE_LINE  (64)
+
+/**
+ * Message channel over a shared memory region, e.g. one of Bao's IPC
+ * objects. The region holds a header, with the producer and consumer
+ * indices on separate cache lines, followed by a power of two number of
+ * fixed size slots. Producers and the consumer only read each other's index
+ * when their cached copy says the ring is full or empty.
+ *
+ * There is a single consumer. Channels created with mpsc set accept several
+ * producers, serialized by a lock in the shared region, so they may be
+ * spread over cpus and even partitions. The region must be mapped as normal
+ * cacheable memory on both sides (see arch_mem_map).
+ *
+ * Sending does not notify the consumer. ipc_notify covers everything sent
+ * before it and only rings the doorbell if the consumer armed it with
+ * ipc_arm before waiting, so a busy consumer costs no traps.
+ * With batch set, ipc_send notifies by itself every batch messages.
+ */
+struct ipc_shm {
+    struct {
+        uint32_t magic;
+        uint32_t slot_size;
+        uint32_t slot_num;
+    } __attribute__((aligned(IPC_CACHE_LINE))) cfg;
+    struct {
+        volatile uint32_t tail;
+        spinlock_t lock;
+    } __attribute__((aligned(IPC_CACHE_LINE))) prod;
+    struct {
+        volatile uint32_t head;
+        volatile uint32_t armed;
+    } __attribute__((aligned(IPC_CACHE_LINE))) cons;
+    uint8_t slots[] __attribute__((aligned(IPC_CACHE_LINE)));
+};
+
+/**
+ * IPC_DOORBELL_IPI raises SMP_IPI_IPC on the consumer's cpu, which besides
+ * waking it runs the handler it registered for it with smp_ipi_register.
+ */
+enum ipc_doorbell_type {
+    IPC_DOORBELL_NONE,
+    IPC_DOORBELL_HYPERCALL,  /* Bao IPC notification, id is the ipc id */
+    IPC_DOORBELL_IPI,        /* loopback inside the guest, id is the cpu */
+};
+
+struct ipc_doorbell {
+    enum ipc_doorbell_type type;
+    unsigned long id;
+};
+
+struct ipc_config {
+    void* shm;
+    size_t shm_size;
+    size_t msg_size;
+    bool create;    /* initialize the region, done by one side only */
+    bool mpsc;
+    unsigned batch;
+    struct ipc_doorbell doorbell;
+};
+
+struct ipc_channel {
+    struct ipc_shm* shm;
+    uint32_t mask;
+    uint32_t slot_size;
+    size_t msg_size;
+    bool mpsc;
+    unsigned batch;
+    struct ipc_doorbell doorbell;
+    uint32_t head_cache;
+    uint32_t tail_cache;
+    unsigned pending;
+};
+
+/**
+ * Returns 0 on success, or -1 if the region is too small, or if attaching
+ * (create not set) to a region the other side did not yet initialize with
+ * the same message size, in which case it may be retried.
+ */
+int ipc_channel_init(struct ipc_channel* ch, const struct ipc_config* cfg);
+
+/* Returns 0, or -1 if the message is too large or the channel is full */
+int ipc_send(struct ipc_channel* ch, const void* msg, size_t len);
+void ipc_notify(struct ipc_channel* ch);
+
+/**
+ * Copies up to size bytes of the next message to buf and returns the
+ * message length, or -1 if the channel is empty.
+ */
+int ipc_recv(struct ipc_channel* ch, void* buf, size_t size);
+
+/**
+ * Asks for the doorbell on the next notification. Returns false if messages
+ * are already pending, in which case the consumer should not wait.
+ */
+bool ipc_arm(struct ipc_channel* ch);
+
+#endif /* IPC_H */
@@ -2,6 +2,7 @@
 #define IRQ_H
 
 #include <core.h>
+#include <cpumask.h>
 #include <arch/irq.h>
 
 typedef void (*irq_handler_t)(unsigned id);
@@ -10,6 +11,24 @@ void irq_handle(unsigned id);
 void irq_set_handler(unsigned id, irq_handler_t handler);
 void irq_enable(unsigned id);
 void irq_set_prio(unsigned id, unsigned prio);
-void irq_send_ipi(unsigned long target_cpu_mask);
+/* Moves the shared interrupts handled by cpu from to cpu to */
+void irq_migrate(unsigned long from, unsigned long to);
+void irq_send_ipi(const cpumask_t* cpus);
+
+/**
+ * Message-signaled interrupts, where supported (GIC_ITS=y on armv8). A
+ * device, by its bus id, gets num consecutive interrupt ids from *first_id,
+ * used as any other once enabled. The device signals one by writing data to
+ * addr, as returned by irq_msi_msg. Return 0 or -1 if unsupported or out of
+ * ids.
+ */
+struct irq_msi_msg {
+    uint64_t addr;
+    uint32_t data;
+};
+
+int irq_msi_alloc(uint32_t dev_id, size_t num, unsigned* first_id);
+void irq_msi_free(uint32_t dev_id);
+int irq_msi_msg(unsigned id, struct irq_msi_msg* msg);
 
 #endif // IRQ_H
@@ -0,0 +1,104 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <core.h>
+#include <cpumask.h>
+
+/**
+ * Work-stealing job system, built with JOBS=y. Each cpu has a lock-free
+ * Chase-Lev deque: it pushes and pops its own jobs at the bottom, LIFO, while
+ * idle cpus steal the oldest ones from the top. Cpus serving jobs idle, see
+ * cpu_idle, when there is nothing to steal, and spawning a job wakes one of
+ * them with an SMP_IPI_JOBS IPI. Waiting for jobs (job_wait, parallel_*)
+ * runs jobs meanwhile instead of idling, so any cpu can spawn and wait, even
+ * from within a job. Jobs cannot be submitted from interrupt handlers, the
+ * deque operations of a cpu must not interrupt each other.
+ *
+ * Jobs can be chained into graphs: a job runs once every job it depends on
+ * finished. Dependencies must be added before the jobs are submitted.
+ */
+
+/* Jobs per cpu deque, power of two. Jobs spawned on a full deque run inline */
+#ifndef JOBS_DEQUE_SIZE
+#define JOBS_DEQUE_SIZE     (256)
+#endif
+
+/* Jobs that can depend on a single job */
+#ifndef JOB_MAX_SUCC
+#define JOB_MAX_SUCC        (4)
+#endif
+
+/* Largest parallel_reduce result */
+#ifndef PARALLEL_REDUCE_MAX_SIZE
+#define PARALLEL_REDUCE_MAX_SIZE    (64)
+#endif
+
+typedef void (*job_fn_t)(void* arg);
+
+/* Counts the unfinished jobs submitted with it */
+struct job_group {
+    volatile unsigned long pending;
+};
+
+#define JOB_GROUP_INITVAL   ((struct job_group){ 0 })
+
+/* Must stay valid until the job finished, i.e. until job_wait on its group */
+struct job {
+    job_fn_t fn;
+    void* arg;
+    struct job_group* group;
+    volatile unsigned long deps;    /* unfinished dependencies, plus submit */
+    size_t num_succ;
+    struct job* succ[JOB_MAX_SUCC];
+};
+
+/**
+ * Serves jobs until *until is set, or forever if until is NULL. This is the
+ * idle loop of cpus given to the job system. jobs_wake makes sleeping cpus
+ * check until again.
+ */
+void jobs_serve(const volatile bool* until);
+void jobs_wake(const cpumask_t* cpus);
+
+/**
+ * Restricts serving to the cpus in cpus, by default every cpu that called
+ * jobs_serve. Any cpu still runs jobs while it waits on its own.
+ */
+void jobs_set_cpus(const cpumask_t* cpus);
+void jobs_get_cpus(cpumask_t* cpus);
+
+void job_init(struct job* job, job_fn_t fn, void* arg);
+
+/* Makes job run after pred finished. Returns -1 if pred has no room left */
+int job_depend(struct job* job, struct job* pred);
+
+/* Queues job on the calling cpu, to run once its dependencies finished */
+void job_submit(struct job* job, struct job_group* group);
+
+/* Runs jobs until every job submitted with group finished */
+void job_wait(struct job_group* group);
+
+/**
+ * Runs fn over [begin, end) split in chunks of at most grain elements,
+ * picked from the number of serving cpus if grain is 0. Chunks are spawned
+ * by recursive halving, so they are stolen in large pieces first.
+ */
+typedef void (*parallel_for_fn_t)(size_t begin, size_t end, void* arg);
+void parallel_for(size_t begin, size_t end, size_t grain,
+    parallel_for_fn_t fn, void* arg);
+
+/**
+ * Like parallel_for, fn writes the result of each chunk into a result of size
+ * bytes, which are then merged by combine(result, other) into the result
+ * for the whole range. Returns -1, leaving result untouched, if the range is
+ * empty or size is larger than PARALLEL_REDUCE_MAX_SIZE.
+ */
+typedef void (*parallel_reduce_fn_t)(size_t begin, size_t end, void* result,
+    void* arg);
+typedef void (*parallel_combine_fn_t)(void* result, const void* other,
+    void* arg);
+int parallel_reduce(size_t begin, size_t end, size_t grain, void* result,
+    size_t size, parallel_reduce_fn_t fn, parallel_combine_fn_t combine,
+    void* arg);
+
+#endif /* JOBS_H */
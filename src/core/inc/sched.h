@@ -0,0 +1,145 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <core.h>
+
+/**
+ * Fixed-priority preemptive scheduler, built with SCHED=y. Each cpu has its
+ * own run queue, one FIFO per priority plus a bitmap of the non-empty ones,
+ * so picking the next thread is a single count-leading-zeros. Threads are
+ * bound to the cpu they are created on. Equal priorities are round-robin
+ * scheduled every SCHED_SLICE_US if it is not zero.
+ *
+ * The scheduler owns the timer interrupt (for sleeps and time slices) and the
+ * SMP_IPI_SCHED reason (to preempt remote cpus). Interrupt handlers run on a
+ * separate per-cpu stack, a preemption they cause takes place on the way out
+ * of the interrupt. The context the cpu booted in becomes the main thread,
+ * running main() at SCHED_MAIN_PRIO. Each cpu also has an idle thread below
+ * every other priority.
+ *
+ * Mutexes implement priority inheritance: the owner runs at least at the
+ * priority of its highest waiter, transitively across chains of mutexes.
+ * They are handed over to the highest priority waiter on unlock.
+ */
+
+#define SCHED_PRIO_NUM      (32)
+#define SCHED_PRIO_IDLE     (0)
+#define SCHED_PRIO_MIN      (1)
+#define SCHED_PRIO_MAX      (SCHED_PRIO_NUM - 1)
+
+#ifndef SCHED_MAIN_PRIO
+#define SCHED_MAIN_PRIO     (SCHED_PRIO_MIN)
+#endif
+
+#ifndef SCHED_SLICE_US
+#define SCHED_SLICE_US      (10000)
+#endif
+
+#ifndef SCHED_IRQ_STACK_SIZE
+#define SCHED_IRQ_STACK_SIZE    (0x2000)
+#endif
+
+#ifndef SCHED_IDLE_STACK_SIZE
+#define SCHED_IDLE_STACK_SIZE   (0x1000)
+#endif
+
+/* Layout of sched_pcpu, shared with the interrupt entry code */
+#define SCHED_PCPU_SHIFT    (6)
+#define SCHED_PCPU_RESCHED  (0)
+
+#ifndef __ASSEMBLER__
+
+#include <arch/sched.h>
+
+enum thread_state {
+    THREAD_READY,
+    THREAD_RUNNING,
+    THREAD_BLOCKED,
+    THREAD_SLEEPING,
+    THREAD_SUSPENDED,
+    THREAD_DONE,
+};
+
+typedef void (*thread_fn_t)(void* arg);
+
+struct mutex;
+
+struct thread {
+    /* Saved stack pointer, must be the first member */
+    unsigned long sp;
+    /* Run queue, sleep list or mutex wait list links */
+    struct thread* next;
+    struct thread* prev;
+    unsigned prio;          /* effective, possibly inherited, priority */
+    unsigned base_prio;
+    unsigned long cpu;
+    volatile enum thread_state state;
+    bool resume;            /* thread_resume before thread_suspend */
+    uint64_t wake;
+    struct mutex* blocked_on;
+    struct mutex* held;
+    thread_fn_t fn;
+    void* arg;
+    const char* name;
+};
+
+struct mutex {
+    struct thread* owner;
+    struct thread* waiters; /* highest priority first */
+    struct mutex* next_held;
+};
+
+#define MUTEX_INITVAL   ((struct mutex){ NULL, NULL, NULL })
+
+/**
+ * Set by a cpu when it has to reschedule, checked by the interrupt exit path
+ * which calls sched_preempt if it is set.
+ */
+struct sched_pcpu {
+    volatile unsigned long resched;
+} __attribute__((aligned(1 << SCHED_PCPU_SHIFT)));
+
+extern struct sched_pcpu sched_pcpu[NR_CPUS];
+extern uint8_t sched_irq_stack[NR_CPUS][SCHED_IRQ_STACK_SIZE];
+
+/* Called by every cpu before main */
+void sched_init();
+void sched_preempt();
+bool sched_in_irq();
+
+/**
+ * Creates a thread running fn(arg) on cpu at priority prio, on the given
+ * stack. The thread struct and stack must stay valid for as long as the
+ * thread runs. Returns 0 or -1 if an argument is invalid.
+ */
+int thread_create(struct thread* thread, const char* name, thread_fn_t fn,
+    void* arg, unsigned prio, unsigned long cpu, void* stack,
+    size_t stack_size);
+struct thread* thread_self();
+void thread_yield();
+void thread_exit() __attribute__((noreturn));
+void thread_set_prio(struct thread* thread, unsigned prio);
+
+/* Sleeps are in timer ticks, see TIME_US and friends in timer.h */
+void thread_sleep(uint64_t ticks);
+void thread_sleep_until(uint64_t deadline);
+
+/**
+ * thread_suspend blocks the calling thread until thread_resume. Resuming can
+ * be done from interrupt handlers, and may happen before the thread actually
+ * suspends, in which case thread_suspend returns immediately.
+ */
+void thread_suspend();
+void thread_resume(struct thread* thread);
+
+void mutex_init(struct mutex* mutex);
+void mutex_lock(struct mutex* mutex);
+bool mutex_trylock(struct mutex* mutex);
+void mutex_unlock(struct mutex* mutex);
+
+/* Implemented by the arch, switches stacks saving the callee-saved state */
+void sched_ctx_switch(unsigned long* from_sp, unsigned long to_sp);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* SCHED_H */
@@ -0,0 +1,54 @@
+#ifndef SHMEM_CONSOLE_H
+#define SHMEM_CONSOLE_H
+
+#include <core.h>
+
+#define SHMEM_CONSOLE_MAGIC     (0x474c4d42) /* "BMLG" */
+#define SHMEM_CONSOLE_HDR_SIZE  (64)
+
+#ifndef SHMEM_CONSOLE_SIZE
+#define SHMEM_CONSOLE_SIZE      (0x200000)
+#endif
+
+/**
+ * Log ring at SHMEM_CONSOLE_BASE, read by another partition or from the host
+ * (tools/shmlog.py). The guest is the only producer and never waits for the
+ * reader: head counts all bytes ever written (modulo 2^32) and byte n lives
+ * at data[n % size]. A reader keeps its own position, and knows it lost
+ * data when head moved more than size bytes past it. Data is written before
+ * head is updated, so everything below head is valid as long as head did not
+ * move more than size past it by the time the reader is done copying.
+ *
+ * The region is mapped as normal memory, so SHMEM_CONSOLE_BASE and
+ * SHMEM_CONSOLE_SIZE must be aligned to the mapping granularity (2MB blocks
+ * on aarch64, 1MB sections on aarch32, pages on riscv). Until the ring is
+ * set up, or if it can not be mapped, the console falls back to the UART.
+ *
+ * If the reader sets notify, every write is followed by a Bao IPC
+ * notification on SHMEM_CONSOLE_IPC, when defined.
+ */
+struct shmem_console {
+    uint32_t magic;
+    uint32_t size;
+    volatile uint32_t head;
+    volatile uint32_t notify;
+    uint8_t pad[SHMEM_CONSOLE_HDR_SIZE - (4 * sizeof(uint32_t))];
+    char data[];
+};
+
+#ifdef SHMEM_CONSOLE_BASE
+
+void shmem_console_init();
+bool shmem_console_write(const char* buf, size_t len);
+
+#else
+
+static inline void shmem_console_init() { }
+static inline bool shmem_console_write(const char* buf, size_t len)
+{
+    return false;
+}
+
+#endif
+
+#endif /* SHMEM_CONSOLE_H */
@@ -0,0 +1,78 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <core.h>
+#include <cpumask.h>
+
+/**
+ * Cross-cpu calls and IPI multiplexing. All IPIs go through IPI_IRQ_ID,
+ * owned by smp. Each cpu has a word of pending reasons and a lock-free
+ * queue of call requests. Senders set the reason bit and only raise the
+ * interrupt if the target had nothing pending, so everything queued before
+ * the target handles it is served by a single IPI.
+ *
+ * Calls run in the target's IPI handler, i.e. in interrupt context. Calls
+ * targeting the calling cpu run immediately. Waiting for a call with
+ * interrupts disabled (e.g. from a handler) may deadlock with a cpu doing
+ * the same in the other direction. Calls to offline cpus, see hotplug.h,
+ * are skipped.
+ */
+
+#define SMP_IPI_CALL    (0)     /* smp_call requests queued */
+#define SMP_IPI_SCHED   (1)     /* reschedule, see sched.h */
+#define SMP_IPI_JOBS    (2)     /* wake a job system worker, see jobs.h */
+#define SMP_IPI_IPC     (3)     /* IPC_DOORBELL_IPI doorbells, see ipc.h */
+#define SMP_IPI_APP     (4)     /* first reason free for the application */
+#define SMP_IPI_NUM     (32)
+
+/* Requests in flight per calling cpu, waited for calls reuse them in turn */
+#ifndef SMP_CALL_POOL_SIZE
+#define SMP_CALL_POOL_SIZE  (16)
+#endif
+
+typedef void (*smp_call_fn_t)(void* arg);
+typedef void (*smp_ipi_handler_t)(unsigned reason);
+
+/* Called by every cpu before main, once ready for IPIs: puts it online */
+void smp_init();
+
+/**
+ * Serves pending IPI reasons and calls without the interrupt, for cpus
+ * running with interrupts masked. Call with interrupts masked.
+ */
+void smp_poll();
+
+/* Cpus taking calls and IPIs: those past smp_init, unless taken down */
+void smp_set_online(unsigned long cpu, bool online);
+
+/**
+ * Called by a cpu leaving, once it is no longer online, as the last thing
+ * before it turns off: runs the calls queued so far and closes its queue,
+ * so that calls from cpus that still saw it online are refused rather than
+ * left waiting. smp_set_online reopens it, on the cpu itself, coming back.
+ */
+void smp_cpu_dying();
+bool smp_cpu_online(unsigned long cpu);
+void smp_online_cpus(cpumask_t* cpus);
+
+void smp_ipi_register(unsigned reason, smp_ipi_handler_t handler);
+void smp_send_ipi(unsigned long cpu, unsigned reason);
+void smp_send_ipi_many(const cpumask_t* cpus, unsigned reason);
+
+/**
+ * Runs fn(arg) on cpu, or on every cpu in cpus, returning after it ran
+ * if wait is set. Returns 0, or -1 if there are not enough free asynchronous
+ * request slots left for all targets, in which case none of them is queued.
+ */
+int smp_call(unsigned long cpu, smp_call_fn_t fn, void* arg, bool wait);
+int smp_call_many(const cpumask_t* cpus, smp_call_fn_t fn, void* arg,
+    bool wait);
+
+/**
+ * Batching: queues asynchronous calls without interrupting the targets,
+ * which are then interrupted at once, and only if needed, by smp_kick.
+ */
+int smp_call_queue(unsigned long cpu, smp_call_fn_t fn, void* arg);
+void smp_kick(const cpumask_t* cpus);
+
+#endif /* SMP_H */
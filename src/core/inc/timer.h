@@ -3,17 +3,28 @@
 
 #include <core.h>
 #include <arch/timer.h>
+#include <arch/wait.h>
 
 #define TIME_US(us) (((TIMER_FREQ)*(us))/(1000000ull))
 #define TIME_MS(ms) (TIME_US((ms)*1000ull))
 #define TIME_S(s)   (TIME_MS((s)*1000ull))
 
 uint64_t timer_get();
+/* Fires the timer interrupt n ticks from now, or once timer_get() >= time */
 void timer_set(uint64_t n);
+void timer_set_abs(uint64_t time);
 
+#define TIMER_NO_DEADLINE   (~0ULL)
+
+/* Last time programmed on the calling cpu, TIMER_NO_DEADLINE if none yet */
+uint64_t timer_get_deadline();
+
+/* Sleeps in the arch wait instruction, may overshoot by a wait period */
 static inline void timer_wait(uint64_t n) {
     uint64_t start = timer_get();
-    while(timer_get() < (start+n));
+    while(timer_get() < (start+n)) {
+        arch_wait_event();
+    }
 }
 
 #endif
@@ -17,6 +17,11 @@
 #ifndef __UART_H__
 #define __UART_H__
 
+#include <core.h>
+
+/* Console UART base, UART_ADDR unless found in the device tree */
+extern uintptr_t uart_addr;
+
 void uart_init(void);
 void uart_putc(char c);
 char uart_getchar(void);
@@ -0,0 +1,85 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include <core.h>
+#include <timer.h>
+#include <arch/wait.h>
+
+/**
+ * Cross-cpu waiting without hammering the interconnect. Waiters sleep in the
+ * arch's wait instruction until the word they watch is written, until
+ * wait_notify is called, or for a bounded time, and re-check:
+ *
+ * - armv8: wfe, woken through the exclusive monitor or sev, and at least
+ *   every WAIT_EVENT_PERIOD_US by the generic timer event stream.
+ * - riscv: Zawrs wrs.nto/wrs.sto if the platform defines CPU_EXT_ZAWRS or
+ *   the device tree lists it, pause hints otherwise.
+ *
+ * Timeouts are in timer ticks, see TIME_US and friends in timer.h.
+ */
+
+#define WAIT_FOREVER        (~0ULL)
+
+/* Upper bound of a single wait on armv8 */
+#ifndef WAIT_EVENT_PERIOD_US
+#define WAIT_EVENT_PERIOD_US    (10)
+#endif
+
+static inline uint64_t wait_deadline(uint64_t timeout)
+{
+    uint64_t now = timer_get();
+    return (timeout > WAIT_FOREVER - now) ? WAIT_FOREVER : now + timeout;
+}
+
+/* Wakes cpus waiting on a condition rather than on a word */
+static inline void wait_notify()
+{
+    arch_wait_notify();
+}
+
+/**
+ * Waits until COND holds or TIMEOUT ticks elapsed, evaluating to whether COND
+ * held. Whoever makes COND true must call wait_notify.
+ */
+#define wait_until(COND, TIMEOUT) ({                                \
+    uint64_t _deadline = wait_deadline(TIMEOUT);                    \
+    bool _cond;                                                     \
+    while (!(_cond = (COND)) && timer_get() < _deadline) {          \
+        arch_wait_event();                                          \
+    }                                                               \
+    _cond;                                                          \
+})
+
+/* Waits while *addr equals val, returns false on timeout */
+bool wait_while_eq(const volatile uint32_t* addr, uint32_t val,
+    uint64_t timeout);
+
+/* Waits for num cpus to reach it, reusable right away */
+struct barrier {
+    volatile uint32_t count;
+    volatile uint32_t gen;
+    uint32_t num;
+};
+
+#define BARRIER_INITVAL(NUM)    ((struct barrier){ 0, 0, (NUM) })
+
+void barrier_init(struct barrier* barrier, uint32_t num);
+void barrier_wait(struct barrier* barrier);
+
+/**
+ * One-shot event: once completed, every wait on it returns right away, until
+ * it is initialized again.
+ */
+struct completion {
+    volatile uint32_t done;
+};
+
+#define COMPLETION_INITVAL  ((struct completion){ 0 })
+
+void completion_init(struct completion* completion);
+void complete(struct completion* completion);
+bool completion_done(struct completion* completion);
+/* Returns false on timeout */
+bool completion_wait(struct completion* completion, uint64_t timeout);
+
+#endif /* WAIT_H */
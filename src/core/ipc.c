@@ -0,0 +1,180 @@
+#include <ipc.h>
+#include <smp.h>
+#include <hypercall.h>
+#include <fences.h>
+#include <string.h>
+
+struct ipc_slot {
+    uint32_t len;
+    uint8_t data[];
+};
+
+static inline struct ipc_slot* ipc_slot(struct ipc_channel* ch, uint32_t idx)
+{
+    return (struct ipc_slot*)&ch->shm->slots[(idx & ch->mask) * ch->slot_size];
+}
+
+int ipc_channel_init(struct ipc_channel* ch, const struct ipc_config* cfg)
+{
+    struct ipc_shm* shm = cfg->shm;
+    uint32_t slot_size = (sizeof(struct ipc_slot) + cfg->msg_size + 7) & ~7U;
+    uint32_t slot_num = 1;
+
+    if (cfg->shm_size < sizeof(struct ipc_shm) + (2 * slot_size)) {
+        return -1;
+    }
+    while ((sizeof(struct ipc_shm) + (2 * slot_num * slot_size)) <=
+        cfg->shm_size) {
+        slot_num *= 2;
+    }
+
+    if (cfg->create) {
+        shm->cfg.magic = 0;
+        fence_ord_write();
+        shm->cfg.slot_size = slot_size;
+        shm->cfg.slot_num = slot_num;
+        shm->prod.tail = 0;
+        shm->prod.lock = SPINLOCK_INITVAL;
+        shm->cons.head = 0;
+        shm->cons.armed = 0;
+        fence_ord_write();
+        shm->cfg.magic = IPC_MAGIC;
+    } else {
+        if (((volatile struct ipc_shm*)shm)->cfg.magic != IPC_MAGIC) {
+            return -1;
+        }
+        fence_ord_read();
+        if (shm->cfg.slot_size != slot_size ||
+            shm->cfg.slot_num > slot_num) {
+            return -1;
+        }
+        slot_num = shm->cfg.slot_num;
+    }
+
+    *ch = (struct ipc_channel) {
+        .shm = shm,
+        .mask = slot_num - 1,
+        .slot_size = slot_size,
+        .msg_size = cfg->msg_size,
+        .mpsc = cfg->mpsc,
+        .batch = cfg->batch,
+        .doorbell = cfg->doorbell,
+        .head_cache = shm->cons.head,
+        .tail_cache = shm->prod.tail,
+    };
+
+    return 0;
+}
+
+static void ipc_doorbell_ring(struct ipc_doorbell* doorbell)
+{
+    switch (doorbell->type) {
+        case IPC_DOORBELL_HYPERCALL:
+            hypercall_ipc_notify(doorbell->id, 0);
+            break;
+        case IPC_DOORBELL_IPI:
+            smp_send_ipi(doorbell->id, SMP_IPI_IPC);
+            break;
+        default:
+            break;
+    }
+}
+
+int ipc_send(struct ipc_channel* ch, const void* msg, size_t len)
+{
+    struct ipc_shm* shm = ch->shm;
+    int ret = 0;
+
+    if (len > ch->msg_size) {
+        return -1;
+    }
+
+    if (ch->mpsc) {
+        spin_lock(&shm->prod.lock);
+    }
+
+    uint32_t tail = shm->prod.tail;
+    if ((tail - ch->head_cache) > ch->mask) {
+        ch->head_cache = shm->cons.head;
+        /* The consumer is done with the slot before it is overwritten */
+        fence_ord();
+        if ((tail - ch->head_cache) > ch->mask) {
+            ret = -1;
+        }
+    }
+
+    if (ret == 0) {
+        struct ipc_slot* slot = ipc_slot(ch, tail);
+        slot->len = len;
+        memcpy(slot->data, msg, len);
+        fence_ord_write();
+        shm->prod.tail = tail + 1;
+        ch->pending++;
+    }
+
+    if (ch->mpsc) {
+        spin_unlock(&shm->prod.lock);
+    }
+
+    if (ch->batch != 0 && ch->pending >= ch->batch) {
+        ipc_notify(ch);
+    }
+
+    return ret;
+}
+
+void ipc_notify(struct ipc_channel* ch)
+{
+    struct ipc_shm* shm = ch->shm;
+
+    ch->pending = 0;
+
+    /* Pairs with ipc_arm: either it sees the new tail or we see armed */
+    fence_ord();
+    if (shm->cons.armed) {
+        shm->cons.armed = 0;
+        ipc_doorbell_ring(&ch->doorbell);
+    }
+}
+
+int ipc_recv(struct ipc_channel* ch, void* buf, size_t size)
+{
+    struct ipc_shm* shm = ch->shm;
+    uint32_t head = shm->cons.head;
+
+    if (head == ch->tail_cache) {
+        ch->tail_cache = shm->prod.tail;
+        fence_ord_read();
+        if (head == ch->tail_cache) {
+            return -1;
+        }
+    }
+
+    struct ipc_slot* slot = ipc_slot(ch, head);
+    size_t len = slot->len;
+    if (len > ch->msg_size) {
+        len = ch->msg_size;
+    }
+    memcpy(buf, slot->data, (len < size) ? len : size);
+
+    /* Done reading the slot before handing it back to the producers */
+    fence_ord();
+    shm->cons.head = head + 1;
+
+    return (int)len;
+}
+
+bool ipc_arm(struct ipc_channel* ch)
+{
+    struct ipc_shm* shm = ch->shm;
+
+    shm->cons.armed = 1;
+    fence_ord();
+    ch->tail_cache = shm->prod.tail;
+    if (ch->tail_cache != shm->cons.head) {
+        shm->cons.armed = 0;
+        return false;
+    }
+
+    return true;
+}
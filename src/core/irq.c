@@ -1,14 +1,21 @@
 #include <core.h>
 #include <irq.h>
 
+/* Where the arch's interrupt ids are sparse, e.g. GICv3 LPIs */
+#ifndef ARCH_IRQ_SLOT
+#define ARCH_IRQ_SLOT(ID) (ID)
+#endif
+
 irq_handler_t irq_handlers[IRQ_NUM]; 
 
 void irq_set_handler(unsigned id, irq_handler_t handler){
-    if(id < IRQ_NUM)
-        irq_handlers[id] = handler;
+    unsigned long slot = ARCH_IRQ_SLOT(id);
+    if(slot < IRQ_NUM)
+        irq_handlers[slot] = handler;
 }
 
 void irq_handle(unsigned id){
-    if(id < IRQ_NUM && irq_handlers[id] != NULL)
-        irq_handlers[id](id);
+    unsigned long slot = ARCH_IRQ_SLOT(id);
+    if(slot < IRQ_NUM && irq_handlers[slot] != NULL)
+        irq_handlers[slot](id);
 }
@@ -0,0 +1,389 @@
+#include <jobs.h>
+#include <cpu.h>
+#include <irq.h>
+#include <smp.h>
+#include <cpu_role.h>
+
+/**
+ * Chase-Lev deque, with the C11 orderings of Le et al., "Correct and
+ * Efficient Work-Stealing for Weak Memory Models". Indices only grow, their
+ * difference is the number of jobs. top is written by thieves, bottom only
+ * by the owner, so they live in separate cache lines.
+ */
+struct jobs_deque {
+    volatile unsigned long top __attribute__((aligned(64)));
+    volatile unsigned long bottom __attribute__((aligned(64)));
+    struct job* jobs[JOBS_DEQUE_SIZE];
+} __attribute__((aligned(64)));
+
+static struct jobs_deque jobs_deques[NR_CPUS];
+static cpumask_t jobs_cpus = CPUMASK_ALL;
+static cpumask_t jobs_serving;
+static cpumask_t jobs_sleeping;
+
+static bool jobs_push(struct jobs_deque* dq, struct job* job)
+{
+    unsigned long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+    unsigned long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= JOBS_DEQUE_SIZE) {
+        return false;
+    }
+
+    __atomic_store_n(&dq->jobs[b % JOBS_DEQUE_SIZE], job, __ATOMIC_RELAXED);
+    __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static struct job* jobs_take(struct jobs_deque* dq)
+{
+    unsigned long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    struct job* job;
+
+    __atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    unsigned long t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+
+    if ((long)(b - t) < 0) {
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    job = __atomic_load_n(&dq->jobs[b % JOBS_DEQUE_SIZE], __ATOMIC_RELAXED);
+    if (b == t) {
+        /* Last job, race the thieves for it */
+        if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, false,
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            job = NULL;
+        }
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return job;
+}
+
+/* Returns NULL if empty or if another thief won the race */
+static struct job* jobs_steal(struct jobs_deque* dq)
+{
+    unsigned long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    unsigned long b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+
+    if ((long)(b - t) <= 0) {
+        return NULL;
+    }
+
+    struct job* job =
+        __atomic_load_n(&dq->jobs[t % JOBS_DEQUE_SIZE], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, false,
+            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    return job;
+}
+
+static bool jobs_available()
+{
+    for (unsigned long cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct jobs_deque* dq = &jobs_deques[cpu];
+        if ((long)(__atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) -
+                __atomic_load_n(&dq->top, __ATOMIC_RELAXED)) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Own jobs first, newest first, then the oldest of the next cpus in turn */
+static struct job* jobs_find(unsigned long cpuid)
+{
+    struct job* job = jobs_take(&jobs_deques[cpuid]);
+
+    for (unsigned long i = 1; job == NULL && i < NR_CPUS; i++) {
+        job = jobs_steal(&jobs_deques[(cpuid + i) % NR_CPUS]);
+    }
+
+    return job;
+}
+
+/**
+ * Pairs with the sleeping bit set before the last check in jobs_sleep: with
+ * a full fence on both sides, between the store and the load, either the
+ * sleeper sees the new job or this sees the sleeper.
+ */
+static void jobs_wake_one()
+{
+    cpumask_t sleeping;
+    unsigned long cpu;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    smp_online_cpus(&sleeping);
+    cpumask_and(&sleeping, &sleeping, &jobs_sleeping);
+    cpumask_and(&sleeping, &sleeping, &jobs_cpus);
+
+    for_each_cpu(cpu, &sleeping) {
+        if (cpumask_test_and_clear_cpu_atomic(&jobs_sleeping, cpu)) {
+            smp_send_ipi(cpu, SMP_IPI_JOBS);
+            return;
+        }
+    }
+}
+
+static void jobs_sleep(unsigned long cpuid, const volatile bool* until)
+{
+    /**
+     * Interrupts are masked from the check to the wfi, a wake up IPI sent in
+     * between then leaves it pending and the wfi returns right away.
+     */
+    unsigned long flags = arch_irq_save();
+    cpumask_set_cpu_atomic(&jobs_sleeping, cpuid);
+    /* The RMW alone does not order the relaxed loads after it, see above */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((until == NULL || !*until) &&
+        (!cpumask_test_cpu(&jobs_cpus, cpuid) || !jobs_available())) {
+        cpu_idle();
+    }
+    cpumask_clear_cpu_atomic(&jobs_sleeping, cpuid);
+    arch_irq_restore(flags);
+}
+
+static void job_run(struct job* job);
+
+static void job_spawn(struct job* job)
+{
+    if (jobs_push(&jobs_deques[get_cpuid()], job)) {
+        jobs_wake_one();
+    } else {
+        job_run(job);
+    }
+}
+
+static void job_release(struct job* job)
+{
+    if (__atomic_fetch_sub(&job->deps, 1, __ATOMIC_ACQ_REL) == 1) {
+        job_spawn(job);
+    }
+}
+
+/* Nothing of the job can be touched once its group is decremented */
+static void job_run(struct job* job)
+{
+    struct job_group* group = job->group;
+
+    job->fn(job->arg);
+
+    for (size_t i = 0; i < job->num_succ; i++) {
+        job_release(job->succ[i]);
+    }
+
+    __atomic_fetch_sub(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+void jobs_serve(const volatile bool* until)
+{
+    unsigned long cpuid = get_cpuid();
+
+    cpumask_set_cpu_atomic(&jobs_serving, cpuid);
+
+    while (until == NULL || !*until) {
+        struct job* job = NULL;
+        if (cpumask_test_cpu(&jobs_cpus, cpuid)) {
+            job = jobs_find(cpuid);
+        }
+        if (job != NULL) {
+            job_run(job);
+        } else {
+            jobs_sleep(cpuid, until);
+        }
+    }
+
+    cpumask_clear_cpu_atomic(&jobs_serving, cpuid);
+}
+
+void jobs_wake(const cpumask_t* cpus)
+{
+    smp_send_ipi_many(cpus, SMP_IPI_JOBS);
+}
+
+void jobs_set_cpus(const cpumask_t* cpus)
+{
+    cpumask_t joined;
+
+    jobs_cpus = *cpus;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    /* Let the cpus that joined find the pending jobs */
+    cpumask_and(&joined, cpus, &jobs_sleeping);
+    jobs_wake(&joined);
+}
+
+void jobs_get_cpus(cpumask_t* cpus)
+{
+    smp_online_cpus(cpus);
+    cpumask_and(cpus, cpus, &jobs_cpus);
+    cpumask_and(cpus, cpus, &jobs_serving);
+}
+
+void job_init(struct job* job, job_fn_t fn, void* arg)
+{
+    job->fn = fn;
+    job->arg = arg;
+    job->group = NULL;
+    job->deps = 1;
+    job->num_succ = 0;
+}
+
+int job_depend(struct job* job, struct job* pred)
+{
+    if (pred->num_succ >= JOB_MAX_SUCC) {
+        return -1;
+    }
+
+    pred->succ[pred->num_succ++] = job;
+    __atomic_fetch_add(&job->deps, 1, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+void job_submit(struct job* job, struct job_group* group)
+{
+    job->group = group;
+    __atomic_fetch_add(&group->pending, 1, __ATOMIC_RELAXED);
+    job_release(job);
+}
+
+void job_wait(struct job_group* group)
+{
+    unsigned long cpuid = get_cpuid();
+
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) != 0) {
+        struct job* job = jobs_find(cpuid);
+        if (job != NULL) {
+            job_run(job);
+        }
+    }
+}
+
+static size_t parallel_grain(size_t begin, size_t end, size_t grain)
+{
+    if (grain == 0) {
+        /* A few chunks per cpu, to even out imbalances by stealing */
+        cpumask_t cpus;
+        jobs_get_cpus(&cpus);
+        cpumask_set_cpu(&cpus, get_cpuid());
+        grain = (end - begin) / (cpumask_weight(&cpus) * 8);
+    }
+
+    return grain > 0 ? grain : 1;
+}
+
+struct parallel_for_args {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    parallel_for_fn_t fn;
+    void* arg;
+};
+
+/* Spawns the upper half and recurses into the lower one */
+static void parallel_for_job(void* arg)
+{
+    struct parallel_for_args* args = arg;
+
+    if (args->end - args->begin <= args->grain) {
+        args->fn(args->begin, args->end, args->arg);
+        return;
+    }
+
+    size_t mid = args->begin + (args->end - args->begin) / 2;
+    struct parallel_for_args upper = *args;
+    struct parallel_for_args lower = *args;
+    struct job_group group = JOB_GROUP_INITVAL;
+    struct job job;
+
+    upper.begin = mid;
+    lower.end = mid;
+    job_init(&job, parallel_for_job, &upper);
+    job_submit(&job, &group);
+    parallel_for_job(&lower);
+    job_wait(&group);
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain,
+    parallel_for_fn_t fn, void* arg)
+{
+    if (begin >= end) {
+        return;
+    }
+
+    struct parallel_for_args args = {
+        .begin = begin,
+        .end = end,
+        .grain = parallel_grain(begin, end, grain),
+        .fn = fn,
+        .arg = arg,
+    };
+
+    parallel_for_job(&args);
+}
+
+struct parallel_reduce_args {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    void* result;
+    parallel_reduce_fn_t fn;
+    parallel_combine_fn_t combine;
+    void* arg;
+};
+
+static void parallel_reduce_job(void* arg)
+{
+    struct parallel_reduce_args* args = arg;
+
+    if (args->end - args->begin <= args->grain) {
+        args->fn(args->begin, args->end, args->result, args->arg);
+        return;
+    }
+
+    size_t mid = args->begin + (args->end - args->begin) / 2;
+    uint8_t upper_result[PARALLEL_REDUCE_MAX_SIZE] __attribute__((aligned(16)));
+    struct parallel_reduce_args upper = *args;
+    struct parallel_reduce_args lower = *args;
+    struct job_group group = JOB_GROUP_INITVAL;
+    struct job job;
+
+    upper.begin = mid;
+    upper.result = upper_result;
+    lower.end = mid;
+    job_init(&job, parallel_reduce_job, &upper);
+    job_submit(&job, &group);
+    parallel_reduce_job(&lower);
+    job_wait(&group);
+    args->combine(args->result, upper_result, args->arg);
+}
+
+int parallel_reduce(size_t begin, size_t end, size_t grain, void* result,
+    size_t size, parallel_reduce_fn_t fn, parallel_combine_fn_t combine,
+    void* arg)
+{
+    if (begin >= end || size > PARALLEL_REDUCE_MAX_SIZE) {
+        return -1;
+    }
+
+    struct parallel_reduce_args args = {
+        .begin = begin,
+        .end = end,
+        .grain = parallel_grain(begin, end, grain),
+        .result = result,
+        .fn = fn,
+        .combine = combine,
+        .arg = arg,
+    };
+
+    parallel_reduce_job(&args);
+
+    return 0;
+}
@@ -9,9 +9,24 @@
 
 #include <spinlock.h>
 #include <uart.h>
+#include <console.h>
+#include <shmem_console.h>
 #include <cpu.h>
 #include <fences.h>
 #include <wfi.h>
+#include <boot_stats.h>
+#include <fdt.h>
+#include <smp.h>
+#include <cpu_role.h>
+#ifdef SCHED
+#include <sched.h>
+#endif
+#ifdef BENCH
+#include <bench.h>
+#endif
+#ifdef JOBS
+#include <jobs.h>
+#endif
 
 int _read(int file, char *ptr, int len)
 {
@@ -24,18 +39,25 @@ int _read(int file, char *ptr, int len)
     return len;
 }
 
-int _write(int file, char *ptr, int len)
+void console_write(const char* buf, size_t len)
 {
-    int i;
-    for (i = 0; i < len; ++i)
+    if (shmem_console_write(buf, len)) {
+        return;
+    }
+
+    for (size_t i = 0; i < len; ++i)
     {
-        if (ptr[i] == '\n')
+        if (buf[i] == '\n')
         {
             uart_putc('\r');
         }
-        uart_putc(ptr[i]);
+        uart_putc(buf[i]);
     }
+}
 
+int _write(int file, char *ptr, int len)
+{
+    console_write(ptr, len);
     return len;
 }
 
@@ -67,6 +89,10 @@ void* _sbrk(int increment)
     extern char _heap_base;
     static char* heap_end = &_heap_base;
     char* current_heap_end = heap_end;
+    if ((uint64_t)(uintptr_t)heap_end + increment > mem_limit) {
+        errno = ENOMEM;
+        return (void*)-1;
+    }
     heap_end += increment;
     return current_heap_end;
 }
@@ -95,6 +121,9 @@ extern int main();
 
 static bool init_done = false;
 static spinlock_t init_lock = SPINLOCK_INITVAL;
+#if defined(BENCH) && defined(JOBS)
+static volatile bool bench_done = false;
+#endif
 
 __attribute__((weak))
 void _init(){
@@ -102,13 +131,41 @@ void _init(){
     spin_lock(&init_lock);
     if(!init_done) {
         init_done = true;
+        fdt_discover();
         uart_init();
+        shmem_console_init();
+        boot_timestamp(BOOT_PHASE_CONSOLE);
     }
     spin_unlock(&init_lock);
     
     arch_init();
+    smp_init();
+#ifdef SCHED
+    sched_init();
+#endif
+
+    if (cpu_is_master()) {
+        boot_timestamp(BOOT_PHASE_ARCH);
+        boot_stats_print();
+#ifdef BENCH
+        bench_run();
+#ifdef JOBS
+        bench_done = true;
+        cpumask_t all = CPUMASK_ALL;
+        jobs_wake(&all);
+#endif
+#endif
+    }
+#if defined(BENCH) && defined(JOBS)
+    else {
+        /* Lend the other cpus to the job system benchmark */
+        jobs_serve(&bench_done);
+    }
+#endif
 
-    int ret = main();
+    cpu_role_init();
+    const struct cpu_role* role = cpu_role();
+    int ret = (role->entry != NULL) ? role->entry() : main();
     _exit(ret);
 }
 
@@ -0,0 +1,650 @@
+#include <sched.h>
+#include <cpu.h>
+#include <irq.h>
+#include <smp.h>
+#include <timer.h>
+#include <spinlock.h>
+#include <cpu_role.h>
+#include <string.h>
+
+#define SCHED_NEVER     (~0ULL)
+
+/**
+ * A cpu's run queue. The running thread is not queued. Queues are circular
+ * doubly-linked lists and bit n of ready is set if queue n is not empty.
+ * Sleeping threads are kept by wake up time. The queue is locked, with
+ * interrupts disabled, by its cpu and by those waking threads on it.
+ */
+struct sched_cpu {
+    spinlock_t lock;
+    uint32_t ready;
+    struct thread* queue[SCHED_PRIO_NUM];
+    struct thread* curr;
+    struct thread* sleeping;
+    /* The thread giving up the cpu goes to the tail of its queue */
+    bool rotate;
+    uint64_t slice_end;
+    uint64_t timer_deadline;
+    struct thread idle;
+    struct thread main;
+};
+
+struct sched_pcpu sched_pcpu[NR_CPUS];
+uint8_t sched_irq_stack[NR_CPUS][SCHED_IRQ_STACK_SIZE]
+    __attribute__((aligned(16)));
+static uint8_t sched_idle_stack[NR_CPUS][SCHED_IDLE_STACK_SIZE]
+    __attribute__((aligned(16)));
+static struct sched_cpu sched_cpus[NR_CPUS];
+static uint64_t sched_slice;
+
+/* Protects mutexes and priority inheritance. Taken before run queue locks. */
+static spinlock_t sched_pi_lock = SPINLOCK_INITVAL;
+
+static void rq_insert(struct sched_cpu* rq, struct thread* thread, bool head)
+{
+    struct thread** queue = &rq->queue[thread->prio];
+
+    if (*queue == NULL) {
+        thread->next = thread;
+        thread->prev = thread;
+        *queue = thread;
+        rq->ready |= 1U << thread->prio;
+    } else {
+        thread->next = *queue;
+        thread->prev = (*queue)->prev;
+        thread->prev->next = thread;
+        (*queue)->prev = thread;
+        if (head) {
+            *queue = thread;
+        }
+    }
+}
+
+static void rq_remove(struct sched_cpu* rq, struct thread* thread)
+{
+    struct thread** queue = &rq->queue[thread->prio];
+
+    if (thread->next == thread) {
+        *queue = NULL;
+        rq->ready &= ~(1U << thread->prio);
+    } else {
+        thread->prev->next = thread->next;
+        thread->next->prev = thread->prev;
+        if (*queue == thread) {
+            *queue = thread->next;
+        }
+    }
+}
+
+static inline unsigned rq_top(struct sched_cpu* rq)
+{
+    if (rq->ready == 0) {
+        return SCHED_PRIO_IDLE;
+    }
+    return (sizeof(rq->ready) * 8 - 1) - __builtin_clz(rq->ready);
+}
+
+/**
+ * Programs the timer for the next wake up or, if others of the running
+ * thread's priority are waiting, the end of its slice. The timer is only
+ * touched if that changes, unless force is set (the timer fired).
+ */
+static void sched_timer_update(struct sched_cpu* rq, bool force)
+{
+    uint64_t deadline = SCHED_NEVER;
+
+    if (rq->sleeping != NULL) {
+        deadline = rq->sleeping->wake;
+    }
+
+    if (sched_slice != 0 && rq->queue[rq->curr->prio] != NULL &&
+        rq->slice_end < deadline) {
+        deadline = rq->slice_end;
+    }
+
+    if (force || deadline != rq->timer_deadline) {
+        rq->timer_deadline = deadline;
+        if (deadline == SCHED_NEVER) {
+            timer_set(SCHED_NEVER >> 1);
+        } else {
+            uint64_t now = timer_get();
+            timer_set(deadline > now ? deadline - now : 0);
+        }
+    }
+}
+
+/**
+ * Switches to the highest priority ready thread. Called with interrupts
+ * disabled and rq locked, which is unlocked before switching. Threads are
+ * bound to their cpu so none of them can run elsewhere meanwhile.
+ */
+static void sched_switch(struct sched_cpu* rq)
+{
+    struct thread* prev = rq->curr;
+    struct thread* next;
+
+    sched_pcpu[prev->cpu].resched = 0;
+
+    if (prev->state == THREAD_RUNNING && prev != &rq->idle) {
+        prev->state = THREAD_READY;
+        rq_insert(rq, prev, !rq->rotate);
+    }
+    rq->rotate = false;
+
+    if (rq->ready != 0) {
+        next = rq->queue[rq_top(rq)];
+        rq_remove(rq, next);
+    } else {
+        next = &rq->idle;
+    }
+
+    if (next != prev && sched_slice != 0) {
+        rq->slice_end = timer_get() + sched_slice;
+    }
+    next->state = THREAD_RUNNING;
+    rq->curr = next;
+    sched_timer_update(rq, false);
+
+    spin_unlock(&rq->lock);
+
+    if (next != prev) {
+        sched_ctx_switch(&prev->sp, next->sp);
+    }
+}
+
+void sched_preempt()
+{
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+
+    spin_lock(&rq->lock);
+    sched_switch(rq);
+}
+
+bool sched_in_irq()
+{
+    uintptr_t sp = (uintptr_t)__builtin_frame_address(0);
+    uintptr_t base = (uintptr_t)sched_irq_stack[get_cpuid()];
+
+    return (sp - base) < SCHED_IRQ_STACK_SIZE;
+}
+
+static void sched_resched(unsigned long cpu)
+{
+    if (cpu == get_cpuid()) {
+        sched_pcpu[cpu].resched = 1;
+    } else {
+        smp_send_ipi(cpu, SMP_IPI_SCHED);
+    }
+}
+
+/**
+ * Reschedules now if needed, with interrupts disabled. In an interrupt
+ * handler it is left for the interrupt exit.
+ */
+static void sched_check()
+{
+    if (sched_pcpu[get_cpuid()].resched && !sched_in_irq()) {
+        sched_preempt();
+    }
+}
+
+/**
+ * Makes thread ready, with its run queue locked. Returns if its cpu has to
+ * reschedule: it preempts, or it shares the running thread's priority and the
+ * remote cpu's timer has to be set for the slice.
+ */
+static bool rq_wake(struct sched_cpu* rq, struct thread* thread)
+{
+    thread->state = THREAD_READY;
+    rq_insert(rq, thread, false);
+
+    if (thread->prio == rq->curr->prio) {
+        if (thread->cpu != get_cpuid()) {
+            return true;
+        }
+        sched_timer_update(rq, false);
+    }
+
+    return thread->prio > rq->curr->prio;
+}
+
+static void sched_wake(struct thread* thread)
+{
+    struct sched_cpu* rq = &sched_cpus[thread->cpu];
+
+    spin_lock(&rq->lock);
+    bool preempt = rq_wake(rq, thread);
+    spin_unlock(&rq->lock);
+
+    if (preempt) {
+        sched_resched(thread->cpu);
+    }
+}
+
+static void sched_timer_handler(unsigned id)
+{
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+    uint64_t now = timer_get();
+
+    spin_lock(&rq->lock);
+
+    while (rq->sleeping != NULL && rq->sleeping->wake <= now) {
+        struct thread* thread = rq->sleeping;
+        rq->sleeping = thread->next;
+        thread->state = THREAD_READY;
+        rq_insert(rq, thread, false);
+    }
+
+    unsigned top = rq_top(rq);
+    if (top > rq->curr->prio) {
+        sched_pcpu[get_cpuid()].resched = 1;
+    } else if (sched_slice != 0 && top == rq->curr->prio &&
+        now >= rq->slice_end) {
+        rq->rotate = true;
+        sched_pcpu[get_cpuid()].resched = 1;
+    }
+
+    sched_timer_update(rq, true);
+
+    spin_unlock(&rq->lock);
+}
+
+static void sched_ipi_handler(unsigned reason)
+{
+    sched_pcpu[get_cpuid()].resched = 1;
+}
+
+static void sched_thread_start()
+{
+    struct thread* self = thread_self();
+
+    arch_irq_enable();
+    self->fn(self->arg);
+    thread_exit();
+}
+
+static void sched_thread_init(struct thread* thread, const char* name,
+    thread_fn_t fn, void* arg, unsigned prio, unsigned long cpu, void* stack,
+    size_t stack_size)
+{
+    uintptr_t sp = ((uintptr_t)stack + stack_size) & ~0xfUL;
+
+    sp -= ARCH_CTX_SIZE;
+    memset((void*)sp, 0, ARCH_CTX_SIZE);
+    ((unsigned long*)sp)[ARCH_CTX_LR] = (unsigned long)sched_thread_start;
+
+    *thread = (struct thread) {
+        .sp = sp,
+        .prio = prio,
+        .base_prio = prio,
+        .cpu = cpu,
+        .state = THREAD_READY,
+        .fn = fn,
+        .arg = arg,
+        .name = name,
+    };
+}
+
+static void sched_idle(void* arg)
+{
+    while (1) {
+        cpu_idle();
+    }
+}
+
+void sched_init()
+{
+    unsigned long cpu = get_cpuid();
+    struct sched_cpu* rq = &sched_cpus[cpu];
+    unsigned long flags = arch_irq_save();
+
+    sched_slice = TIME_US(SCHED_SLICE_US);
+
+    rq->main = (struct thread) {
+        .prio = SCHED_MAIN_PRIO,
+        .base_prio = SCHED_MAIN_PRIO,
+        .cpu = cpu,
+        .state = THREAD_RUNNING,
+        .name = "main",
+    };
+    rq->curr = &rq->main;
+    sched_thread_init(&rq->idle, "idle", sched_idle, NULL, SCHED_PRIO_IDLE,
+        cpu, sched_idle_stack[cpu], SCHED_IDLE_STACK_SIZE);
+
+    smp_ipi_register(SMP_IPI_SCHED, sched_ipi_handler);
+    irq_set_handler(TIMER_IRQ_ID, sched_timer_handler);
+    irq_enable(TIMER_IRQ_ID);
+    irq_set_prio(TIMER_IRQ_ID, IRQ_MAX_PRIO);
+
+    spin_lock(&rq->lock);
+    sched_timer_update(rq, true);
+    spin_unlock(&rq->lock);
+
+    arch_irq_restore(flags);
+}
+
+int thread_create(struct thread* thread, const char* name, thread_fn_t fn,
+    void* arg, unsigned prio, unsigned long cpu, void* stack,
+    size_t stack_size)
+{
+    if (prio < SCHED_PRIO_MIN || prio > SCHED_PRIO_MAX || cpu >= NR_CPUS ||
+        stack == NULL || stack_size < 2 * ARCH_CTX_SIZE) {
+        return -1;
+    }
+
+    sched_thread_init(thread, name, fn, arg, prio, cpu, stack, stack_size);
+
+    unsigned long flags = arch_irq_save();
+    sched_wake(thread);
+    sched_check();
+    arch_irq_restore(flags);
+
+    return 0;
+}
+
+struct thread* thread_self()
+{
+    return sched_cpus[get_cpuid()].curr;
+}
+
+void thread_yield()
+{
+    unsigned long flags = arch_irq_save();
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+
+    spin_lock(&rq->lock);
+    rq->rotate = true;
+    sched_switch(rq);
+    arch_irq_restore(flags);
+}
+
+void thread_exit()
+{
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+
+    arch_irq_save();
+    spin_lock(&rq->lock);
+    rq->curr->state = THREAD_DONE;
+    sched_switch(rq);
+
+    while (1);
+}
+
+void thread_sleep_until(uint64_t deadline)
+{
+    unsigned long flags = arch_irq_save();
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+    struct thread* self = rq->curr;
+
+    spin_lock(&rq->lock);
+
+    if (deadline <= timer_get()) {
+        spin_unlock(&rq->lock);
+        arch_irq_restore(flags);
+        return;
+    }
+
+    struct thread** pos = &rq->sleeping;
+    while (*pos != NULL && (*pos)->wake <= deadline) {
+        pos = &(*pos)->next;
+    }
+    self->wake = deadline;
+    self->next = *pos;
+    *pos = self;
+    self->state = THREAD_SLEEPING;
+
+    sched_switch(rq);
+    arch_irq_restore(flags);
+}
+
+void thread_sleep(uint64_t ticks)
+{
+    thread_sleep_until(timer_get() + ticks);
+}
+
+void thread_suspend()
+{
+    unsigned long flags = arch_irq_save();
+    struct sched_cpu* rq = &sched_cpus[get_cpuid()];
+    struct thread* self = rq->curr;
+
+    spin_lock(&rq->lock);
+
+    if (self->resume) {
+        self->resume = false;
+        spin_unlock(&rq->lock);
+    } else {
+        self->state = THREAD_SUSPENDED;
+        sched_switch(rq);
+    }
+
+    arch_irq_restore(flags);
+}
+
+void thread_resume(struct thread* thread)
+{
+    unsigned long flags = arch_irq_save();
+    struct sched_cpu* rq = &sched_cpus[thread->cpu];
+    bool preempt = false;
+
+    spin_lock(&rq->lock);
+    if (thread->state == THREAD_SUSPENDED) {
+        preempt = rq_wake(rq, thread);
+    } else {
+        thread->resume = true;
+    }
+    spin_unlock(&rq->lock);
+
+    if (preempt) {
+        sched_resched(thread->cpu);
+    }
+    sched_check();
+    arch_irq_restore(flags);
+}
+
+/**
+ * Changes the priority thread runs at, moving it to the matching queue if it
+ * is ready. Called with sched_pi_lock held.
+ */
+static void sched_set_eff_prio(struct thread* thread, unsigned prio)
+{
+    struct sched_cpu* rq = &sched_cpus[thread->cpu];
+    bool resched = false;
+
+    spin_lock(&rq->lock);
+    if (thread->state == THREAD_READY) {
+        rq_remove(rq, thread);
+        thread->prio = prio;
+        rq_insert(rq, thread, false);
+        resched = prio > rq->curr->prio;
+    } else {
+        bool lowered = thread->state == THREAD_RUNNING && prio < thread->prio;
+        thread->prio = prio;
+        resched = lowered && rq_top(rq) > prio;
+    }
+    spin_unlock(&rq->lock);
+
+    if (resched) {
+        sched_resched(thread->cpu);
+    }
+}
+
+static void mutex_wait_insert(struct mutex* mutex, struct thread* thread)
+{
+    struct thread** pos = &mutex->waiters;
+
+    while (*pos != NULL && (*pos)->prio >= thread->prio) {
+        pos = &(*pos)->next;
+    }
+    thread->next = *pos;
+    *pos = thread;
+}
+
+static void mutex_wait_remove(struct mutex* mutex, struct thread* thread)
+{
+    struct thread** pos = &mutex->waiters;
+
+    while (*pos != NULL && *pos != thread) {
+        pos = &(*pos)->next;
+    }
+    if (*pos != NULL) {
+        *pos = thread->next;
+    }
+}
+
+static void mutex_acquire(struct mutex* mutex, struct thread* thread)
+{
+    mutex->owner = thread;
+    mutex->next_held = thread->held;
+    thread->held = mutex;
+}
+
+static void mutex_release(struct mutex* mutex, struct thread* thread)
+{
+    struct mutex** pos = &thread->held;
+
+    while (*pos != NULL && *pos != mutex) {
+        pos = &(*pos)->next_held;
+    }
+    if (*pos != NULL) {
+        *pos = mutex->next_held;
+    }
+    mutex->owner = NULL;
+}
+
+/* The base priority or that of the highest waiter on a held mutex */
+static unsigned mutex_inherited_prio(struct thread* thread)
+{
+    unsigned prio = thread->base_prio;
+
+    for (struct mutex* m = thread->held; m != NULL; m = m->next_held) {
+        if (m->waiters != NULL && m->waiters->prio > prio) {
+            prio = m->waiters->prio;
+        }
+    }
+
+    return prio;
+}
+
+/**
+ * Updates thread's priority after its base priority or the waiters on its
+ * mutexes changed and, if it is itself waiting, does the same for the owner
+ * it waits on, and so on down the chain.
+ */
+static void mutex_pi_propagate(struct thread* thread)
+{
+    while (thread != NULL) {
+        unsigned prio = mutex_inherited_prio(thread);
+        if (prio == thread->prio) {
+            break;
+        }
+        sched_set_eff_prio(thread, prio);
+
+        struct mutex* mutex = thread->blocked_on;
+        if (mutex == NULL) {
+            break;
+        }
+        mutex_wait_remove(mutex, thread);
+        mutex_wait_insert(mutex, thread);
+        thread = mutex->owner;
+    }
+}
+
+void thread_set_prio(struct thread* thread, unsigned prio)
+{
+    if (prio < SCHED_PRIO_MIN || prio > SCHED_PRIO_MAX) {
+        return;
+    }
+
+    unsigned long flags = arch_irq_save();
+    spin_lock(&sched_pi_lock);
+    thread->base_prio = prio;
+    mutex_pi_propagate(thread);
+    spin_unlock(&sched_pi_lock);
+    sched_check();
+    arch_irq_restore(flags);
+}
+
+void mutex_init(struct mutex* mutex)
+{
+    *mutex = MUTEX_INITVAL;
+}
+
+bool mutex_trylock(struct mutex* mutex)
+{
+    unsigned long flags = arch_irq_save();
+    bool locked = false;
+
+    spin_lock(&sched_pi_lock);
+    if (mutex->owner == NULL) {
+        mutex_acquire(mutex, thread_self());
+        locked = true;
+    }
+    spin_unlock(&sched_pi_lock);
+    arch_irq_restore(flags);
+
+    return locked;
+}
+
+void mutex_lock(struct mutex* mutex)
+{
+    unsigned long flags = arch_irq_save();
+    struct thread* self = thread_self();
+
+    spin_lock(&sched_pi_lock);
+
+    if (mutex->owner == NULL) {
+        mutex_acquire(mutex, self);
+        spin_unlock(&sched_pi_lock);
+        arch_irq_restore(flags);
+        return;
+    }
+
+    self->blocked_on = mutex;
+    mutex_wait_insert(mutex, self);
+    mutex_pi_propagate(mutex->owner);
+
+    /* The owner can hand the mutex over only once we are off the cpu */
+    struct sched_cpu* rq = &sched_cpus[self->cpu];
+    spin_lock(&rq->lock);
+    self->state = THREAD_BLOCKED;
+    spin_unlock(&sched_pi_lock);
+    sched_switch(rq);
+
+    arch_irq_restore(flags);
+}
+
+void mutex_unlock(struct mutex* mutex)
+{
+    unsigned long flags = arch_irq_save();
+    struct thread* self = thread_self();
+
+    spin_lock(&sched_pi_lock);
+
+    if (mutex->owner != self) {
+        spin_unlock(&sched_pi_lock);
+        arch_irq_restore(flags);
+        return;
+    }
+
+    mutex_release(mutex, self);
+
+    struct thread* next = mutex->waiters;
+    if (next != NULL) {
+        mutex->waiters = next->next;
+        next->blocked_on = NULL;
+        mutex_acquire(mutex, next);
+        next->prio = mutex_inherited_prio(next);
+        sched_wake(next);
+    }
+
+    /* Drop what was inherited through this mutex */
+    unsigned prio = mutex_inherited_prio(self);
+    if (prio != self->prio) {
+        sched_set_eff_prio(self, prio);
+    }
+
+    spin_unlock(&sched_pi_lock);
+    sched_check();
+    arch_irq_restore(flags);
+}
@@ -0,0 +1,103 @@
+#include <shmem_console.h>
+#include <fdt.h>
+#include <spinlock.h>
+#include <fences.h>
+#include <string.h>
+#include <irq.h>
+#include <page_tables.h>
+#ifdef SHMEM_CONSOLE_IPC
+#include <hypercall.h>
+#endif
+
+/* The granularity arch_mem_map works with */
+#if defined(AARCH64)
+#define SHMEM_CONSOLE_ALIGN L2_BLOCK_SIZE
+#elif defined(AARCH32)
+#define SHMEM_CONSOLE_ALIGN L1_BLOCK_SIZE
+#else
+#define SHMEM_CONSOLE_ALIGN PAGE_SIZE
+#endif
+
+#if (SHMEM_CONSOLE_BASE | SHMEM_CONSOLE_SIZE) & (SHMEM_CONSOLE_ALIGN - 1)
+#error "SHMEM_CONSOLE_BASE and SHMEM_CONSOLE_SIZE must be aligned to the arch mapping granularity"
+#endif
+
+static struct shmem_console* shmem_console;
+static spinlock_t shmem_console_lock = SPINLOCK_INITVAL;
+
+/**
+ * Maps the region as normal memory, which requires it to be aligned to the
+ * arch mapping granularity, and sets up the header unless a ring of the same
+ * size is already there, in which case logging continues after it.
+ */
+void shmem_console_init()
+{
+    uint64_t start = SHMEM_CONSOLE_BASE;
+    uint64_t end = start + SHMEM_CONSOLE_SIZE;
+
+    if (arch_mem_map(start, end) < end) {
+        return;
+    }
+
+    struct shmem_console* ring = (struct shmem_console*)(uintptr_t)start;
+    uint32_t size = 1;
+    while ((size * 2) <= (SHMEM_CONSOLE_SIZE - SHMEM_CONSOLE_HDR_SIZE)) {
+        size *= 2;
+    }
+
+    if (ring->magic != SHMEM_CONSOLE_MAGIC || ring->size != size) {
+        ring->size = size;
+        ring->head = 0;
+        ring->notify = 0;
+        fence_ord_write();
+        ring->magic = SHMEM_CONSOLE_MAGIC;
+    }
+
+    shmem_console = ring;
+}
+
+bool shmem_console_write(const char* buf, size_t len)
+{
+    struct shmem_console* ring = shmem_console;
+
+    if (ring == NULL) {
+        return false;
+    }
+
+    /* Interrupt handlers print too, and would spin on the lock held here */
+    unsigned long flags = arch_irq_save();
+    spin_lock(&shmem_console_lock);
+
+    uint32_t size = ring->size;
+    uint32_t head = ring->head;
+    uint32_t new_head = head + (uint32_t)len;
+
+    /* Only the last size bytes would survive anyway */
+    if (len > size) {
+        buf += len - size;
+        head = new_head - size;
+        len = size;
+    }
+
+    uint32_t off = head & (size - 1);
+    size_t first = size - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring->data[off], buf, first);
+    memcpy(&ring->data[0], buf + first, len - first);
+
+    fence_ord_write();
+    ring->head = new_head;
+
+    spin_unlock(&shmem_console_lock);
+    arch_irq_restore(flags);
+
+#ifdef SHMEM_CONSOLE_IPC
+    if (ring->notify) {
+        hypercall_ipc_notify(SHMEM_CONSOLE_IPC, 0);
+    }
+#endif
+
+    return true;
+}
@@ -0,0 +1,351 @@
+#include <smp.h>
+#include <irq.h>
+#include <cpu.h>
+#include <fences.h>
+#include <wait.h>
+
+struct smp_call_req {
+    struct smp_call_req* next;
+    smp_call_fn_t fn;
+    void* arg;
+    /* Calls waited for: decremented by the target once it ran */
+    volatile uint32_t* done;
+    /* Set by the caller when queued, cleared by the target once it ran */
+    volatile uint32_t busy;
+};
+
+struct smp_cpu {
+    struct smp_call_req* volatile queue;
+    volatile uint32_t pending;
+} __attribute__((aligned(64)));
+
+static struct smp_cpu smp_cpus[NR_CPUS];
+static struct smp_call_req smp_call_pool[NR_CPUS][SMP_CALL_POOL_SIZE];
+static smp_ipi_handler_t smp_ipi_handlers[SMP_IPI_NUM];
+/* Set by each cpu in smp_init, then by hotplug */
+static cpumask_t smp_online = CPUMASK_NONE;
+
+/* Queue of a cpu gone offline, see smp_cpu_dying */
+#define SMP_QUEUE_CLOSED    ((struct smp_call_req*)1)
+
+static void smp_call_run_list(struct smp_call_req* list)
+{
+    struct smp_call_req* fifo = NULL;
+
+    /* The queue is a stack, reverse it to run requests in order */
+    while (list != NULL) {
+        struct smp_call_req* next = list->next;
+        list->next = fifo;
+        fifo = list;
+        list = next;
+    }
+
+    while (fifo != NULL) {
+        struct smp_call_req* next = fifo->next;
+        volatile uint32_t* done = fifo->done;
+        fifo->fn(fifo->arg);
+        __atomic_store_n(&fifo->busy, 0, __ATOMIC_RELEASE);
+        if (done != NULL) {
+            __atomic_fetch_sub(done, 1, __ATOMIC_RELEASE);
+        }
+        fifo = next;
+    }
+}
+
+static void smp_call_run(struct smp_cpu* cpu)
+{
+    /* Only the cpu itself closes and reopens its queue */
+    if (cpu->queue != SMP_QUEUE_CLOSED) {
+        smp_call_run_list(
+            __atomic_exchange_n(&cpu->queue, NULL, __ATOMIC_ACQUIRE));
+    }
+}
+
+void smp_poll()
+{
+    struct smp_cpu* cpu = &smp_cpus[get_cpuid()];
+    uint32_t pending = __atomic_exchange_n(&cpu->pending, 0, __ATOMIC_ACQUIRE);
+
+    if (pending & (1U << SMP_IPI_CALL)) {
+        smp_call_run(cpu);
+    }
+
+    for (unsigned reason = SMP_IPI_CALL + 1; reason < SMP_IPI_NUM; reason++) {
+        if ((pending & (1U << reason)) && smp_ipi_handlers[reason] != NULL) {
+            smp_ipi_handlers[reason](reason);
+        }
+    }
+}
+
+static void smp_ipi_handle(unsigned id)
+{
+    smp_poll();
+}
+
+void smp_init()
+{
+    irq_set_handler(IPI_IRQ_ID, smp_ipi_handle);
+    irq_enable(IPI_IRQ_ID);
+    irq_set_prio(IPI_IRQ_ID, IRQ_MAX_PRIO);
+
+    /* Cpus the platform lacks or that never came up are never online */
+    smp_set_online(get_cpuid(), true);
+}
+
+void smp_set_online(unsigned long cpu, bool online)
+{
+    if (online) {
+        struct smp_call_req* closed = SMP_QUEUE_CLOSED;
+        __atomic_compare_exchange_n(&smp_cpus[cpu].queue, &closed, NULL,
+            false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        cpumask_set_cpu_atomic(&smp_online, cpu);
+    } else {
+        cpumask_clear_cpu_atomic(&smp_online, cpu);
+    }
+}
+
+void smp_cpu_dying()
+{
+    struct smp_cpu* cpu = &smp_cpus[get_cpuid()];
+
+    smp_poll();
+    smp_call_run_list(
+        __atomic_exchange_n(&cpu->queue, SMP_QUEUE_CLOSED, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * Words are read atomically, each bit being consistent with what its cpu
+ * published before going online, not the mask as a whole.
+ */
+bool smp_cpu_online(unsigned long cpu)
+{
+    return cpu < NR_CPUS && (__atomic_load_n(
+        &smp_online.bits[BITMAP_WORD(cpu)], __ATOMIC_ACQUIRE) &
+        BITMAP_BIT(cpu)) != 0;
+}
+
+void smp_online_cpus(cpumask_t* cpus)
+{
+    for (size_t i = 0; i < BITMAP_WORDS(NR_CPUS); i++) {
+        cpus->bits[i] = __atomic_load_n(&smp_online.bits[i], __ATOMIC_ACQUIRE);
+    }
+}
+
+void smp_ipi_register(unsigned reason, smp_ipi_handler_t handler)
+{
+    if (reason > SMP_IPI_CALL && reason < SMP_IPI_NUM) {
+        smp_ipi_handlers[reason] = handler;
+    }
+}
+
+/**
+ * An interrupt is only needed for targets that had nothing pending, the
+ * others have one on its way that was not yet taken.
+ */
+static void smp_raise(const cpumask_t* cpus, unsigned reason)
+{
+    cpumask_t ipis = CPUMASK_NONE;
+    unsigned long cpu;
+
+    for_each_cpu(cpu, cpus) {
+        uint32_t old = __atomic_fetch_or(&smp_cpus[cpu].pending,
+            1U << reason, __ATOMIC_SEQ_CST);
+        if (old == 0) {
+            cpumask_set_cpu(&ipis, cpu);
+        }
+    }
+
+    if (!cpumask_empty(&ipis)) {
+        fence_sync_write();
+        irq_send_ipi(&ipis);
+    }
+}
+
+void smp_send_ipi(unsigned long cpu, unsigned reason)
+{
+    cpumask_t cpus = cpumask_of(cpu);
+    smp_send_ipi_many(&cpus, reason);
+}
+
+void smp_send_ipi_many(const cpumask_t* cpus, unsigned reason)
+{
+    if (reason < SMP_IPI_NUM) {
+        smp_raise(cpus, reason);
+    }
+}
+
+/* Returns false if cpu went offline, closing its queue */
+static bool smp_call_push(unsigned long cpu, struct smp_call_req* req)
+{
+    struct smp_cpu* target = &smp_cpus[cpu];
+    struct smp_call_req* head = target->queue;
+
+    do {
+        if (head == SMP_QUEUE_CLOSED) {
+            return false;
+        }
+        req->next = head;
+    } while (!__atomic_compare_exchange_n(&target->queue, &head, req, true,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    return true;
+}
+
+static struct smp_call_req* smp_call_alloc()
+{
+    struct smp_call_req* pool = smp_call_pool[get_cpuid()];
+
+    for (size_t i = 0; i < SMP_CALL_POOL_SIZE; i++) {
+        if (__atomic_exchange_n(&pool[i].busy, 1, __ATOMIC_ACQUIRE) == 0) {
+            return &pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Queues asynchronous calls on every online cpu in cpus but the caller's,
+ * or on none of them. The requests are all taken first, kept in a list
+ * through their next field until pushed.
+ */
+static int smp_call_queue_many(const cpumask_t* cpus, smp_call_fn_t fn,
+    void* arg)
+{
+    cpumask_t targets;
+    unsigned long cpu;
+    struct smp_call_req* reqs = NULL;
+
+    smp_online_cpus(&targets);
+    cpumask_and(&targets, &targets, cpus);
+    cpumask_clear_cpu(&targets, get_cpuid());
+
+    for_each_cpu(cpu, &targets) {
+        struct smp_call_req* req = smp_call_alloc();
+        if (req == NULL) {
+            while (reqs != NULL) {
+                struct smp_call_req* next = reqs->next;
+                __atomic_store_n(&reqs->busy, 0, __ATOMIC_RELEASE);
+                reqs = next;
+            }
+            return -1;
+        }
+        req->next = reqs;
+        reqs = req;
+    }
+
+    for_each_cpu(cpu, &targets) {
+        struct smp_call_req* req = reqs;
+        reqs = req->next;
+        req->fn = fn;
+        req->arg = arg;
+        req->done = NULL;
+        if (!smp_call_push(cpu, req)) {
+            __atomic_store_n(&req->busy, 0, __ATOMIC_RELEASE);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Waited for calls take requests from the same pool as asynchronous ones,
+ * so the stack use does not grow with NR_CPUS. When it runs out, the calls
+ * queued so far are sent off and their requests reused as they complete.
+ */
+static void smp_call_wait_many(const cpumask_t* cpus, smp_call_fn_t fn,
+    void* arg, bool call_self)
+{
+    volatile uint32_t pending = 0;
+    cpumask_t batch = CPUMASK_NONE;
+    unsigned long cpu;
+    uint32_t n;
+
+    for_each_cpu(cpu, cpus) {
+        struct smp_call_req* req;
+        while ((req = smp_call_alloc()) == NULL) {
+            smp_raise(&batch, SMP_IPI_CALL);
+            batch = CPUMASK_NONE;
+            if ((n = pending) != 0) {
+                wait_while_eq(&pending, n, WAIT_FOREVER);
+            }
+        }
+        req->fn = fn;
+        req->arg = arg;
+        req->done = &pending;
+        __atomic_fetch_add(&pending, 1, __ATOMIC_RELAXED);
+        if (smp_call_push(cpu, req)) {
+            cpumask_set_cpu(&batch, cpu);
+        } else {
+            __atomic_fetch_sub(&pending, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&req->busy, 0, __ATOMIC_RELEASE);
+        }
+    }
+    smp_raise(&batch, SMP_IPI_CALL);
+
+    if (call_self) {
+        fn(arg);
+    }
+
+    while ((n = __atomic_load_n(&pending, __ATOMIC_ACQUIRE)) != 0) {
+        wait_while_eq(&pending, n, WAIT_FOREVER);
+    }
+}
+
+int smp_call_many(const cpumask_t* cpus, smp_call_fn_t fn, void* arg,
+    bool wait)
+{
+    unsigned long self = get_cpuid();
+    bool call_self = cpumask_test_cpu(cpus, self);
+    cpumask_t others;
+
+    smp_online_cpus(&others);
+    cpumask_and(&others, &others, cpus);
+    cpumask_clear_cpu(&others, self);
+
+    if (!wait) {
+        if (smp_call_queue_many(&others, fn, arg) != 0) {
+            return -1;
+        }
+        smp_raise(&others, SMP_IPI_CALL);
+        if (call_self) {
+            fn(arg);
+        }
+    } else {
+        smp_call_wait_many(&others, fn, arg, call_self);
+    }
+
+    return 0;
+}
+
+int smp_call(unsigned long cpu, smp_call_fn_t fn, void* arg, bool wait)
+{
+    cpumask_t cpus = cpumask_of(cpu);
+    return smp_call_many(&cpus, fn, arg, wait);
+}
+
+int smp_call_queue(unsigned long cpu, smp_call_fn_t fn, void* arg)
+{
+    if (cpu == get_cpuid()) {
+        fn(arg);
+        return 0;
+    }
+
+    cpumask_t cpus = cpumask_of(cpu);
+    return smp_call_queue_many(&cpus, fn, arg);
+}
+
+void smp_kick(const cpumask_t* cpus)
+{
+    cpumask_t kick = CPUMASK_NONE;
+    unsigned long cpu;
+
+    for_each_cpu(cpu, cpus) {
+        struct smp_call_req* queue = smp_cpus[cpu].queue;
+        if (queue != NULL && queue != SMP_QUEUE_CLOSED) {
+            cpumask_set_cpu(&kick, cpu);
+        }
+    }
+
+    smp_raise(&kick, SMP_IPI_CALL);
+}
@@ -1 +1,22 @@
-core_c_srcs:=irq.c retarget.c
+core_c_srcs:=irq.c retarget.c fdt.c checksum.c fmt.c ipc.c smp.c cpu_role.c wait.c
+ifneq ($(BOOT_STATS),)
+core_c_srcs+=boot_stats.c
+endif
+ifneq ($(SHMEM_CONSOLE_BASE),)
+core_c_srcs+=shmem_console.c
+endif
+ifneq ($(SCHED),)
+core_c_srcs+=sched.c
+endif
+ifneq ($(CYCLIC),)
+core_c_srcs+=cyclic.c
+endif
+ifneq ($(JOBS),)
+core_c_srcs+=jobs.c
+endif
+ifneq ($(IDLE),)
+core_c_srcs+=idle.c
+endif
+ifneq ($(HOTPLUG),)
+core_c_srcs+=hotplug.c
+endif
@@ -0,0 +1,65 @@
+#include <wait.h>
+
+bool wait_while_eq(const volatile uint32_t* addr, uint32_t val,
+    uint64_t timeout)
+{
+    uint64_t deadline = wait_deadline(timeout);
+
+    while (__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val) {
+        if (timer_get() >= deadline) {
+            return false;
+        }
+        if (ARCH_WAIT_BOUNDED || timeout == WAIT_FOREVER) {
+            arch_wait_word(addr, val);
+        } else {
+            /* Only wait for a bounded time so the deadline is checked */
+            arch_wait_event();
+        }
+    }
+
+    return true;
+}
+
+void barrier_init(struct barrier* barrier, uint32_t num)
+{
+    *barrier = BARRIER_INITVAL(num);
+}
+
+/**
+ * The last cpu to arrive resets the count and opens the barrier by bumping
+ * its generation, which the others watch.
+ */
+void barrier_wait(struct barrier* barrier)
+{
+    uint32_t gen = __atomic_load_n(&barrier->gen, __ATOMIC_ACQUIRE);
+
+    if (__atomic_add_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) ==
+        barrier->num) {
+        __atomic_store_n(&barrier->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->gen, gen + 1, __ATOMIC_RELEASE);
+        wait_notify();
+    } else {
+        wait_while_eq(&barrier->gen, gen, WAIT_FOREVER);
+    }
+}
+
+void completion_init(struct completion* completion)
+{
+    completion->done = 0;
+}
+
+void complete(struct completion* completion)
+{
+    __atomic_store_n(&completion->done, 1, __ATOMIC_RELEASE);
+    wait_notify();
+}
+
+bool completion_done(struct completion* completion)
+{
+    return __atomic_load_n(&completion->done, __ATOMIC_ACQUIRE) != 0;
+}
+
+bool completion_wait(struct completion* completion, uint64_t timeout)
+{
+    return wait_while_eq(&completion->done, 0, timeout);
+}
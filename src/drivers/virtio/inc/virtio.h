@@ -0,0 +1,126 @@
+#ifndef VIRTIO_H
+#define VIRTIO_H
+
+#include <core.h>
+#include <plat.h>
+
+/**
+ * virtio-mmio transport, version 2 (non-legacy) devices only. On QEMU this
+ * takes -global virtio-mmio.force-legacy=false. Devices are found in the
+ * device tree ("virtio,mmio" nodes) or else in the platform's fixed slots,
+ * PLAT_VIRTIO_MMIO_BASE and friends. Buffers and rings are handed to the
+ * device by address, so they must be identity mapped and, as on QEMU,
+ * coherent with the device.
+ *
+ * Bring up: virtio_find, virtio_init to negotiate features, virtq_init for
+ * each queue (see virtq.h), then virtio_ready.
+ */
+
+#define VIRTIO_MMIO_MAGIC       (0x74726976) /* "virt" */
+#define VIRTIO_MMIO_VERSION     (2)
+
+#define VIRTIO_ID_NET           (1)
+#define VIRTIO_ID_BLOCK         (2)
+#define VIRTIO_ID_CONSOLE       (3)
+#define VIRTIO_ID_RNG           (4)
+
+#define VIRTIO_STATUS_ACKNOWLEDGE   (1U << 0)
+#define VIRTIO_STATUS_DRIVER        (1U << 1)
+#define VIRTIO_STATUS_DRIVER_OK     (1U << 2)
+#define VIRTIO_STATUS_FEATURES_OK   (1U << 3)
+#define VIRTIO_STATUS_NEEDS_RESET   (1U << 6)
+#define VIRTIO_STATUS_FAILED        (1U << 7)
+
+#define VIRTIO_INT_USED_BUFFER  (1U << 0)
+#define VIRTIO_INT_CONFIG       (1U << 1)
+
+/* Transport feature bits, device ones are below 24 */
+#define VIRTIO_F_EVENT_IDX      (29)
+#define VIRTIO_F_VERSION_1      (32)
+#define VIRTIO_F_RING_PACKED    (34)
+
+#define VIRTIO_FEATURE(BIT)     (1ULL << (BIT))
+#define VIRTIO_DEV_FEATURES_MSK (VIRTIO_FEATURE(24) - 1)
+/* The transport features this driver implements */
+#define VIRTIO_TRANSPORT_FEATURES   (VIRTIO_FEATURE(VIRTIO_F_EVENT_IDX) | \
+    VIRTIO_FEATURE(VIRTIO_F_VERSION_1) | VIRTIO_FEATURE(VIRTIO_F_RING_PACKED))
+
+struct virtio_mmio {
+    uint32_t MagicValue;
+    uint32_t Version;
+    uint32_t DeviceID;
+    uint32_t VendorID;
+    uint32_t DeviceFeatures;
+    uint32_t DeviceFeaturesSel;
+    uint8_t res0[0x020 - 0x018];
+    uint32_t DriverFeatures;
+    uint32_t DriverFeaturesSel;
+    uint8_t res1[0x030 - 0x028];
+    uint32_t QueueSel;
+    uint32_t QueueNumMax;
+    uint32_t QueueNum;
+    uint8_t res2[0x044 - 0x03c];
+    uint32_t QueueReady;
+    uint8_t res3[0x050 - 0x048];
+    uint32_t QueueNotify;
+    uint8_t res4[0x060 - 0x054];
+    uint32_t InterruptStatus;
+    uint32_t InterruptACK;
+    uint8_t res5[0x070 - 0x068];
+    uint32_t Status;
+    uint8_t res6[0x080 - 0x074];
+    uint32_t QueueDescLow;
+    uint32_t QueueDescHigh;
+    uint8_t res7[0x090 - 0x088];
+    uint32_t QueueDriverLow;
+    uint32_t QueueDriverHigh;
+    uint8_t res8[0x0a0 - 0x098];
+    uint32_t QueueDeviceLow;
+    uint32_t QueueDeviceHigh;
+    uint8_t res9[0x0fc - 0x0a8];
+    uint32_t ConfigGeneration;
+    uint8_t Config[];
+};
+
+struct virtio_dev {
+    volatile struct virtio_mmio* regs;
+    uint32_t device_id;
+    unsigned irq_id;
+    uint64_t features;  /* negotiated */
+};
+
+/* The nth (from 0) device of type device_id. Returns 0, or -1 if none */
+int virtio_find(uint32_t device_id, size_t nth, struct virtio_dev* dev);
+
+/**
+ * Resets the device and negotiates the features the driver asks for, device
+ * specific or transport ones (e.g. VIRTIO_F_RING_PACKED to get packed
+ * rings), out of those the device offers. VIRTIO_F_VERSION_1 is always
+ * asked for. Returns 0, or -1 if the device refuses them, after which it
+ * is marked failed.
+ */
+int virtio_init(struct virtio_dev* dev, uint64_t features);
+
+/* Lets the device run, once its queues are set up */
+void virtio_ready(struct virtio_dev* dev);
+void virtio_fail(struct virtio_dev* dev);
+
+static inline bool virtio_has_feature(struct virtio_dev* dev, unsigned bit)
+{
+    return (dev->features & VIRTIO_FEATURE(bit)) != 0;
+}
+
+/**
+ * Reads a field of size bytes of the device configuration at offset off,
+ * retrying until the device did not change it meanwhile. Fields of 2, 4 and
+ * 8 bytes are read with aligned loads of their width, 8 bytes as two 4-byte
+ * halves, as the transport requires; any other size is a byte array. Returns
+ * 0, or -1 if off is not aligned to the field.
+ */
+int virtio_config_read(struct virtio_dev* dev, size_t off, void* buf,
+    size_t size);
+
+/* For the interrupt handler: returns the VIRTIO_INT_* bits, acknowledged */
+uint32_t virtio_irq_ack(struct virtio_dev* dev);
+
+#endif /* VIRTIO_H */
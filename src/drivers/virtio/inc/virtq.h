@@ -0,0 +1,159 @@
+#ifndef VIRTQ_H
+#define VIRTQ_H
+
+#include <virtio.h>
+
+/**
+ * Virtqueues, split or packed, the latter if VIRTIO_F_RING_PACKED was
+ * negotiated. The rings live in the virtq itself, which is statically
+ * allocated by the driver, with the descriptors and each area the device
+ * writes on cache lines of their own.
+ *
+ * Adding buffers does not make them visible to the device. virtq_kick
+ * publishes all added since the last kick with a single barrier, and only
+ * writes QueueNotify if the device asked for it: with VIRTIO_F_EVENT_IDX,
+ * if it had not yet seen the batch's position, else unless it disabled
+ * notifications. Completions are polled with virtq_get_used. Interrupts for
+ * them are off until virtq_arm, which with VIRTIO_F_EVENT_IDX asks for one
+ * at the next completion only.
+ *
+ * A virtq is used by one cpu at a time, callers serialize.
+ */
+
+#ifndef VIRTQ_MAX_SIZE
+#define VIRTQ_MAX_SIZE  (128)
+#endif
+
+#define VIRTQ_ALIGN     (64)
+
+#if VIRTQ_MAX_SIZE & (VIRTQ_MAX_SIZE - 1)
+#error "VIRTQ_MAX_SIZE must be a power of two"
+#endif
+
+#define VIRTQ_DESC_F_NEXT       (1U << 0)
+#define VIRTQ_DESC_F_WRITE      (1U << 1)
+#define VIRTQ_DESC_F_AVAIL      (1U << 7)
+#define VIRTQ_DESC_F_USED       (1U << 15)
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT  (1U << 0)
+#define VIRTQ_USED_F_NO_NOTIFY      (1U << 0)
+
+#define VIRTQ_EVENT_F_ENABLE    (0)
+#define VIRTQ_EVENT_F_DISABLE   (1)
+#define VIRTQ_EVENT_F_DESC      (2)
+#define VIRTQ_EVENT_WRAP_OFF    (15)
+
+struct virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+
+/* The extra entry of each ring is where used_event/avail_event go */
+struct virtq_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[VIRTQ_MAX_SIZE + 1];
+};
+
+struct virtq_used_elem {
+    uint32_t id;
+    uint32_t len;
+};
+
+struct virtq_used {
+    uint16_t flags;
+    uint16_t idx;
+    struct virtq_used_elem ring[VIRTQ_MAX_SIZE + 1];
+};
+
+struct virtq_packed_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t id;
+    uint16_t flags;
+};
+
+struct virtq_event {
+    uint16_t off_wrap;
+    uint16_t flags;
+};
+
+/* A buffer of a chain, the device writes it if write is set */
+struct virtq_buf {
+    void* addr;
+    uint32_t len;
+    bool write;
+};
+
+struct virtq {
+    struct virtio_dev* dev;
+    uint16_t index;
+    uint16_t num;
+    bool packed;
+    bool event_idx;
+    bool broken;            /* the device handed back a bad buffer id */
+    uint16_t num_free;
+    uint16_t free_head;     /* split: descriptor, packed: buffer id */
+    uint16_t num_added;     /* split: chains, packed: descriptors */
+    uint16_t last_used;
+    uint16_t avail_idx;     /* split: published on kick */
+    uint16_t next_avail;    /* packed */
+    bool avail_wrap;
+    bool used_wrap;
+    uint16_t batch_head;    /* packed: the slot whose flags publish a batch */
+    uint16_t batch_flags;
+    uint16_t free_next[VIRTQ_MAX_SIZE];
+    uint16_t chain_len[VIRTQ_MAX_SIZE];
+    void* tokens[VIRTQ_MAX_SIZE];
+    volatile union {
+        struct {
+            struct virtq_desc desc[VIRTQ_MAX_SIZE]
+                __attribute__((aligned(VIRTQ_ALIGN)));
+            struct virtq_avail avail __attribute__((aligned(VIRTQ_ALIGN)));
+            struct virtq_used used __attribute__((aligned(VIRTQ_ALIGN)));
+        } split;
+        struct {
+            struct virtq_packed_desc desc[VIRTQ_MAX_SIZE]
+                __attribute__((aligned(VIRTQ_ALIGN)));
+            struct virtq_event driver __attribute__((aligned(VIRTQ_ALIGN)));
+            struct virtq_event device __attribute__((aligned(VIRTQ_ALIGN)));
+        } packed;
+    } ring __attribute__((aligned(VIRTQ_ALIGN)));
+};
+
+/**
+ * Sets up queue index with as many entries as both the device and
+ * VIRTQ_MAX_SIZE allow. Called between virtio_init and virtio_ready.
+ * Returns 0, or -1 if the queue does not exist or is already in use.
+ */
+int virtq_init(struct virtq* vq, struct virtio_dev* dev, uint16_t index);
+
+/**
+ * Adds a chain of num buffers, those the device reads first. token is
+ * handed back by virtq_get_used once the device is done with the chain.
+ * Returns 0, or -1 if there are not enough free descriptors or the queue
+ * is broken.
+ */
+int virtq_add(struct virtq* vq, const struct virtq_buf* bufs, size_t num,
+    void* token);
+
+void virtq_kick(struct virtq* vq);
+
+/**
+ * Returns the token of the next chain the device is done with, and the
+ * bytes it wrote in *len, or NULL if there is none. A completion with an
+ * id the driver never handed out breaks the queue: the device is marked
+ * failed and NULL is returned from then on.
+ */
+void* virtq_get_used(struct virtq* vq, uint32_t* len);
+
+/**
+ * Asks for an interrupt on the next completion. Returns false if there
+ * already are completions to get, in which case there may be none.
+ */
+bool virtq_arm(struct virtq* vq);
+void virtq_disarm(struct virtq* vq);
+
+#endif /* VIRTQ_H */
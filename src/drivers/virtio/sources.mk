@@ -0,0 +1,2 @@
+driver_c_srcs+=virtio/virtio_mmio.c virtio/virtq.c
+driver_s_srcs+=
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <virtio.h>
+#include <fdt.h>
+#include <fences.h>
+#include <string.h>
+
+#ifndef PLAT_VIRTIO_MMIO_NUM
+#define PLAT_VIRTIO_MMIO_NUM    (0)
+#endif
+
+/* GIC specifiers take three cells, type (SPI 0, PPI 1), number and flags */
+#define VIRTIO_FDT_GIC_PPI      (1)
+#define VIRTIO_FDT_GIC_SPI_BASE (32)
+#define VIRTIO_FDT_GIC_PPI_BASE (16)
+
+static inline uint32_t virtio_fdt32(const uint32_t* cell)
+{
+    const uint8_t* b = (const uint8_t*)cell;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+        ((uint32_t)b[2] << 8) | b[3];
+}
+
+static unsigned virtio_fdt_irq(int node)
+{
+    int len;
+    const uint32_t* irq = fdt_getprop(node, "interrupts", &len);
+
+    if (irq == NULL) {
+        return 0;
+    } else if (len >= 12) {
+        unsigned base = virtio_fdt32(&irq[0]) == VIRTIO_FDT_GIC_PPI ?
+            VIRTIO_FDT_GIC_PPI_BASE : VIRTIO_FDT_GIC_SPI_BASE;
+        return base + virtio_fdt32(&irq[1]);
+    } else if (len >= 4) {
+        return virtio_fdt32(&irq[0]);
+    }
+
+    return 0;
+}
+
+/* Slots with no device behind them read as device id 0 */
+static bool virtio_probe(volatile struct virtio_mmio* regs, uint32_t device_id)
+{
+    return regs->MagicValue == VIRTIO_MMIO_MAGIC &&
+        regs->Version == VIRTIO_MMIO_VERSION && regs->DeviceID == device_id;
+}
+
+int virtio_find(uint32_t device_id, size_t nth, struct virtio_dev* dev)
+{
+    size_t found = 0;
+
+    if (fdt_valid()) {
+        int node = -1;
+        uint64_t addr;
+        while ((node = fdt_node_offset_by_compatible(node, "virtio,mmio")) >= 0) {
+            if (!fdt_node_is_available(node) ||
+                fdt_get_reg(node, 0, &addr, NULL) != 0) {
+                continue;
+            }
+            volatile struct virtio_mmio* regs = (void*)(uintptr_t)addr;
+            if (virtio_probe(regs, device_id) && found++ == nth) {
+                dev->regs = regs;
+                dev->irq_id = virtio_fdt_irq(node);
+                break;
+            }
+        }
+        if (node < 0) {
+            return -1;
+        }
+    } else {
+#if PLAT_VIRTIO_MMIO_NUM > 0
+        size_t i;
+        for (i = 0; i < PLAT_VIRTIO_MMIO_NUM; i++) {
+            volatile struct virtio_mmio* regs = (void*)(uintptr_t)
+                (PLAT_VIRTIO_MMIO_BASE + i * PLAT_VIRTIO_MMIO_STRIDE);
+            if (virtio_probe(regs, device_id) && found++ == nth) {
+                dev->regs = regs;
+                dev->irq_id = PLAT_VIRTIO_MMIO_IRQ + i;
+                break;
+            }
+        }
+        if (i == PLAT_VIRTIO_MMIO_NUM) {
+            return -1;
+        }
+#else
+        return -1;
+#endif
+    }
+
+    dev->device_id = device_id;
+    dev->features = 0;
+
+    return 0;
+}
+
+static uint64_t virtio_device_features(volatile struct virtio_mmio* regs)
+{
+    regs->DeviceFeaturesSel = 1;
+    uint64_t features = (uint64_t)regs->DeviceFeatures << 32;
+    regs->DeviceFeaturesSel = 0;
+    return features | regs->DeviceFeatures;
+}
+
+int virtio_init(struct virtio_dev* dev, uint64_t features)
+{
+    volatile struct virtio_mmio* regs = dev->regs;
+
+    regs->Status = 0;
+    while (regs->Status != 0);
+    regs->Status = VIRTIO_STATUS_ACKNOWLEDGE;
+    regs->Status |= VIRTIO_STATUS_DRIVER;
+
+    features |= VIRTIO_FEATURE(VIRTIO_F_VERSION_1);
+    features &= VIRTIO_DEV_FEATURES_MSK | VIRTIO_TRANSPORT_FEATURES;
+    features &= virtio_device_features(regs);
+    if (!(features & VIRTIO_FEATURE(VIRTIO_F_VERSION_1))) {
+        virtio_fail(dev);
+        return -1;
+    }
+
+    regs->DriverFeaturesSel = 1;
+    regs->DriverFeatures = features >> 32;
+    regs->DriverFeaturesSel = 0;
+    regs->DriverFeatures = (uint32_t)features;
+
+    regs->Status |= VIRTIO_STATUS_FEATURES_OK;
+    if (!(regs->Status & VIRTIO_STATUS_FEATURES_OK)) {
+        virtio_fail(dev);
+        return -1;
+    }
+
+    dev->features = features;
+
+    return 0;
+}
+
+void virtio_ready(struct virtio_dev* dev)
+{
+    /* The queues must be in memory before the device may look at them */
+    fence_sync_write();
+    dev->regs->Status |= VIRTIO_STATUS_DRIVER_OK;
+}
+
+void virtio_fail(struct virtio_dev* dev)
+{
+    dev->regs->Status |= VIRTIO_STATUS_FAILED;
+}
+
+int virtio_config_read(struct virtio_dev* dev, size_t off, void* buf,
+    size_t size)
+{
+    volatile uint8_t* cfg = &dev->regs->Config[off];
+    uint64_t val;
+    uint32_t gen;
+
+    if ((size == 2 || size == 4 || size == 8) && (off & (size - 1)) != 0) {
+        return -1;
+    }
+
+    do {
+        gen = dev->regs->ConfigGeneration;
+        if (size == 2) {
+            val = *(volatile uint16_t*)cfg;
+        } else if (size == 4) {
+            val = *(volatile uint32_t*)cfg;
+        } else if (size == 8) {
+            val = ((volatile uint32_t*)cfg)[0] |
+                ((uint64_t)((volatile uint32_t*)cfg)[1] << 32);
+        } else {
+            for (size_t i = 0; i < size; i++) {
+                ((uint8_t*)buf)[i] = cfg[i];
+            }
+        }
+    } while (dev->regs->ConfigGeneration != gen);
+
+    /* Both the fields and the cpus are little-endian */
+    if (size == 2 || size == 4 || size == 8) {
+        memcpy(buf, &val, size);
+    }
+
+    return 0;
+}
+
+uint32_t virtio_irq_ack(struct virtio_dev* dev)
+{
+    uint32_t status = dev->regs->InterruptStatus;
+    dev->regs->InterruptACK = status;
+    return status;
+}
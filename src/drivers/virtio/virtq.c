@@ -0,0 +1,376 @@
+#include <virtq.h>
+#include <fences.h>
+#include <stdio.h>
+
+/* Whether the device asked to be notified once past event, see the spec */
+static inline bool virtq_need_event(uint16_t event, uint16_t new_idx,
+    uint16_t old_idx)
+{
+    return (uint16_t)(new_idx - event - 1) < (uint16_t)(new_idx - old_idx);
+}
+
+static inline void virtq_notify(struct virtq* vq)
+{
+    /* Orders the ring writes before the MMIO one */
+    fence_sync();
+    vq->dev->regs->QueueNotify = vq->index;
+}
+
+/**
+ * The device completed a buffer id it was never given. Its state can not
+ * be trusted, nor can the queue be moved past the bad entry, so both are
+ * given up on rather than polled forever.
+ */
+static void virtq_break(struct virtq* vq, uint32_t id)
+{
+    vq->broken = true;
+    virtio_fail(vq->dev);
+    printf("virtio: queue %u used bad id %lu\n", vq->index,
+        (unsigned long)id);
+}
+
+static void virtq_init_split(struct virtq* vq)
+{
+    for (uint16_t i = 0; i < vq->num; i++) {
+        vq->ring.split.desc[i].next = i + 1;
+    }
+    vq->ring.split.avail.flags = 0;
+    vq->ring.split.avail.idx = 0;
+    vq->ring.split.used.flags = 0;
+    vq->ring.split.used.idx = 0;
+    vq->avail_idx = 0;
+}
+
+static void virtq_init_packed(struct virtq* vq)
+{
+    for (uint16_t i = 0; i < vq->num; i++) {
+        vq->ring.packed.desc[i].flags = 0;
+        vq->free_next[i] = i + 1;
+    }
+    vq->next_avail = 0;
+    vq->avail_wrap = true;
+    vq->used_wrap = true;
+}
+
+int virtq_init(struct virtq* vq, struct virtio_dev* dev, uint16_t index)
+{
+    volatile struct virtio_mmio* regs = dev->regs;
+
+    regs->QueueSel = index;
+    uint32_t max = regs->QueueNumMax;
+    if (regs->QueueReady != 0 || max == 0) {
+        return -1;
+    }
+
+    vq->dev = dev;
+    vq->index = index;
+    vq->packed = virtio_has_feature(dev, VIRTIO_F_RING_PACKED);
+    vq->event_idx = virtio_has_feature(dev, VIRTIO_F_EVENT_IDX);
+    vq->broken = false;
+    /* Split rings must be a power of two */
+    vq->num = VIRTQ_MAX_SIZE;
+    while (vq->num > max) {
+        vq->num /= 2;
+    }
+    vq->num_free = vq->num;
+    vq->free_head = 0;
+    vq->num_added = 0;
+    vq->last_used = 0;
+
+    uintptr_t desc, driver, device;
+    if (vq->packed) {
+        virtq_init_packed(vq);
+        desc = (uintptr_t)vq->ring.packed.desc;
+        driver = (uintptr_t)&vq->ring.packed.driver;
+        device = (uintptr_t)&vq->ring.packed.device;
+    } else {
+        virtq_init_split(vq);
+        desc = (uintptr_t)vq->ring.split.desc;
+        driver = (uintptr_t)&vq->ring.split.avail;
+        device = (uintptr_t)&vq->ring.split.used;
+    }
+    virtq_disarm(vq);
+
+    fence_sync();
+    regs->QueueNum = vq->num;
+    regs->QueueDescLow = (uint64_t)desc;
+    regs->QueueDescHigh = (uint64_t)desc >> 32;
+    regs->QueueDriverLow = (uint64_t)driver;
+    regs->QueueDriverHigh = (uint64_t)driver >> 32;
+    regs->QueueDeviceLow = (uint64_t)device;
+    regs->QueueDeviceHigh = (uint64_t)device >> 32;
+    regs->QueueReady = 1;
+
+    return 0;
+}
+
+/**
+ * Takes the chain off the free list, which is linked through the next
+ * fields, so the chain's links are already in place.
+ */
+static void virtq_add_split(struct virtq* vq, const struct virtq_buf* bufs,
+    size_t num, void* token)
+{
+    uint16_t head = vq->free_head;
+    uint16_t i = head;
+
+    for (size_t k = 0; k < num; k++) {
+        volatile struct virtq_desc* desc = &vq->ring.split.desc[i];
+        desc->addr = (uintptr_t)bufs[k].addr;
+        desc->len = bufs[k].len;
+        desc->flags = (bufs[k].write ? VIRTQ_DESC_F_WRITE : 0) |
+            (k + 1 < num ? VIRTQ_DESC_F_NEXT : 0);
+        i = desc->next;
+    }
+
+    vq->free_head = i;
+    vq->tokens[head] = token;
+    vq->ring.split.avail.ring[vq->avail_idx & (vq->num - 1)] = head;
+    vq->avail_idx++;
+    vq->num_added++;
+}
+
+/**
+ * A packed chain is available once its head's flags are written. The head
+ * of a batch's first chain is left for virtq_kick, the device cannot get
+ * past it to those after, so theirs are written right away.
+ */
+static void virtq_add_packed(struct virtq* vq, const struct virtq_buf* bufs,
+    size_t num, void* token)
+{
+    uint16_t id = vq->free_head;
+    uint16_t head = vq->next_avail;
+    uint16_t head_flags = 0;
+    uint16_t slot = head;
+    bool wrap = vq->avail_wrap;
+
+    for (size_t k = 0; k < num; k++) {
+        volatile struct virtq_packed_desc* desc = &vq->ring.packed.desc[slot];
+        uint16_t flags = (bufs[k].write ? VIRTQ_DESC_F_WRITE : 0) |
+            (k + 1 < num ? VIRTQ_DESC_F_NEXT : 0) |
+            (wrap ? VIRTQ_DESC_F_AVAIL : VIRTQ_DESC_F_USED);
+        desc->addr = (uintptr_t)bufs[k].addr;
+        desc->len = bufs[k].len;
+        desc->id = id;
+        if (k == 0) {
+            head_flags = flags;
+        } else {
+            desc->flags = flags;
+        }
+        if (++slot == vq->num) {
+            slot = 0;
+            wrap = !wrap;
+        }
+    }
+
+    if (vq->num_added == 0) {
+        vq->batch_head = head;
+        vq->batch_flags = head_flags;
+    } else {
+        vq->ring.packed.desc[head].flags = head_flags;
+    }
+
+    vq->free_head = vq->free_next[id];
+    vq->chain_len[id] = num;
+    vq->tokens[id] = token;
+    vq->next_avail = slot;
+    vq->avail_wrap = wrap;
+    vq->num_added += num;
+}
+
+int virtq_add(struct virtq* vq, const struct virtq_buf* bufs, size_t num,
+    void* token)
+{
+    if (num == 0 || num > vq->num_free || vq->broken) {
+        return -1;
+    }
+
+    if (vq->packed) {
+        virtq_add_packed(vq, bufs, num, token);
+    } else {
+        virtq_add_split(vq, bufs, num, token);
+    }
+    vq->num_free -= num;
+
+    return 0;
+}
+
+static bool virtq_kick_split(struct virtq* vq)
+{
+    uint16_t new_idx = vq->avail_idx;
+    uint16_t old_idx = new_idx - vq->num_added;
+
+    fence_ord_write();
+    vq->ring.split.avail.idx = new_idx;
+    /* Pairs with the device: either it sees the new index or we its event */
+    fence_ord();
+
+    if (vq->event_idx) {
+        uint16_t event = *(volatile uint16_t*)&vq->ring.split.used.ring[vq->num];
+        return virtq_need_event(event, new_idx, old_idx);
+    }
+
+    return !(vq->ring.split.used.flags & VIRTQ_USED_F_NO_NOTIFY);
+}
+
+static bool virtq_kick_packed(struct virtq* vq)
+{
+    uint16_t new_idx = vq->next_avail;
+    uint16_t old_idx = new_idx - vq->num_added;
+
+    fence_ord_write();
+    vq->ring.packed.desc[vq->batch_head].flags = vq->batch_flags;
+    fence_ord();
+
+    uint16_t flags = vq->ring.packed.device.flags;
+    if (flags == VIRTQ_EVENT_F_DESC) {
+        uint16_t off_wrap = vq->ring.packed.device.off_wrap;
+        uint16_t event = off_wrap & ~(1U << VIRTQ_EVENT_WRAP_OFF);
+        /* An event in the previous lap is behind, by the ring's size */
+        if ((off_wrap >> VIRTQ_EVENT_WRAP_OFF) != vq->avail_wrap) {
+            event -= vq->num;
+        }
+        return virtq_need_event(event, new_idx, old_idx);
+    }
+
+    return flags != VIRTQ_EVENT_F_DISABLE;
+}
+
+void virtq_kick(struct virtq* vq)
+{
+    if (vq->num_added == 0) {
+        return;
+    }
+
+    bool notify = vq->packed ? virtq_kick_packed(vq) : virtq_kick_split(vq);
+    vq->num_added = 0;
+
+    if (notify) {
+        virtq_notify(vq);
+    }
+}
+
+static void* virtq_get_used_split(struct virtq* vq, uint32_t* len)
+{
+    if (vq->ring.split.used.idx == vq->last_used) {
+        return NULL;
+    }
+    fence_ord_read();
+
+    volatile struct virtq_used_elem* elem =
+        &vq->ring.split.used.ring[vq->last_used & (vq->num - 1)];
+    uint32_t id = elem->id;
+    if (id >= vq->num) {
+        virtq_break(vq, id);
+        return NULL;
+    }
+    *len = elem->len;
+    vq->last_used++;
+
+    /* Back to the free list, the chain's tail now links to the old head */
+    uint16_t tail = id;
+    uint16_t count = 1;
+    while (vq->ring.split.desc[tail].flags & VIRTQ_DESC_F_NEXT) {
+        tail = vq->ring.split.desc[tail].next;
+        count++;
+    }
+    vq->ring.split.desc[tail].next = vq->free_head;
+    vq->free_head = id;
+    vq->num_free += count;
+
+    return vq->tokens[id];
+}
+
+static bool virtq_has_used_packed(struct virtq* vq)
+{
+    uint16_t flags = vq->ring.packed.desc[vq->last_used].flags;
+    bool avail = (flags & VIRTQ_DESC_F_AVAIL) != 0;
+    bool used = (flags & VIRTQ_DESC_F_USED) != 0;
+
+    return avail == used && used == vq->used_wrap;
+}
+
+static void* virtq_get_used_packed(struct virtq* vq, uint32_t* len)
+{
+    if (!virtq_has_used_packed(vq)) {
+        return NULL;
+    }
+    fence_ord_read();
+
+    volatile struct virtq_packed_desc* desc =
+        &vq->ring.packed.desc[vq->last_used];
+    uint16_t id = desc->id;
+    if (id >= vq->num) {
+        virtq_break(vq, id);
+        return NULL;
+    }
+    *len = desc->len;
+
+    vq->last_used += vq->chain_len[id];
+    if (vq->last_used >= vq->num) {
+        vq->last_used -= vq->num;
+        vq->used_wrap = !vq->used_wrap;
+    }
+    vq->free_next[id] = vq->free_head;
+    vq->free_head = id;
+    vq->num_free += vq->chain_len[id];
+
+    return vq->tokens[id];
+}
+
+void* virtq_get_used(struct virtq* vq, uint32_t* len)
+{
+    uint32_t tmp;
+
+    if (vq->broken) {
+        return NULL;
+    } else if (len == NULL) {
+        len = &tmp;
+    }
+
+    return vq->packed ? virtq_get_used_packed(vq, len) :
+        virtq_get_used_split(vq, len);
+}
+
+bool virtq_arm(struct virtq* vq)
+{
+    if (vq->packed) {
+        if (vq->event_idx) {
+            vq->ring.packed.driver.off_wrap = vq->last_used |
+                ((uint16_t)vq->used_wrap << VIRTQ_EVENT_WRAP_OFF);
+            fence_ord_write();
+            vq->ring.packed.driver.flags = VIRTQ_EVENT_F_DESC;
+        } else {
+            vq->ring.packed.driver.flags = VIRTQ_EVENT_F_ENABLE;
+        }
+    } else {
+        if (vq->event_idx) {
+            vq->ring.split.avail.ring[vq->num] = vq->last_used;
+        } else {
+            vq->ring.split.avail.flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+        }
+    }
+
+    /* Pairs with the device: either we see its completion or it our event */
+    fence_ord();
+
+    /* Nothing is handed back from a broken queue, there is none to get */
+    if (vq->broken) {
+        return true;
+    }
+
+    return vq->packed ? !virtq_has_used_packed(vq) :
+        vq->ring.split.used.idx == vq->last_used;
+}
+
+/* With event indices, an event just behind the last completion never fires */
+void virtq_disarm(struct virtq* vq)
+{
+    if (vq->packed) {
+        vq->ring.packed.driver.flags = VIRTQ_EVENT_F_DISABLE;
+    } else if (vq->event_idx) {
+        vq->ring.split.avail.ring[vq->num] = vq->last_used - 1;
+    } else {
+        vq->ring.split.avail.flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
+}
@@ -18,14 +18,26 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <cpu.h>
-#include <wfi.h>
 #include <spinlock.h>
 #include <plat.h>
 #include <irq.h>
 #include <uart.h>
 #include <timer.h>
-
-#define TIMER_INTERVAL (TIME_S(1))
+#include <smp.h>
+#include <cpu_role.h>
+#include <wait.h>
+#ifdef SCHED
+#include <sched.h>
+#endif
+#ifdef CYCLIC
+#include <cyclic.h>
+#endif
+#ifdef JOBS
+#include <jobs.h>
+#endif
+
+#define TIMER_INTERVAL_US (1000000)
+#define TIMER_INTERVAL (TIME_US(TIMER_INTERVAL_US))
 
 spinlock_t print_lock = SPINLOCK_INITVAL;
 
@@ -34,20 +46,50 @@ void uart_rx_handler(){
     uart_clear_rxirq();
 }
 
-void ipi_handler(){
+void ipi_handler(unsigned reason){
     printf("cpu%d: %s\n", get_cpuid(), __func__);
-    irq_send_ipi(1ull << (get_cpuid() + 1));
+    smp_send_ipi(get_cpuid() + 1, SMP_IPI_APP);
 }
 
+#ifdef SCHED
+/* The scheduler owns the timer, periodic work is done by a thread */
+static struct thread tick_thread;
+static uint8_t tick_stack[0x1000] __attribute__((aligned(16)));
+
+void tick_thread_fn(void* arg){
+    uint64_t next = timer_get();
+    while(1) {
+        next += TIMER_INTERVAL;
+        thread_sleep_until(next);
+        printf("cpu%d: %s\n", get_cpuid(), __func__);
+        smp_send_ipi(get_cpuid() + 1, SMP_IPI_APP);
+    }
+}
+#elif defined(CYCLIC)
+/* The executive owns the timer, periodic work is a job in cpu 0's table */
+void tick_job(void* arg){
+    printf("cpu%d: %s\n", get_cpuid(), __func__);
+    smp_send_ipi(get_cpuid() + 1, SMP_IPI_APP);
+}
+
+static const struct cyclic_job tick_jobs[] = {
+    { .offset_us = 0, .fn = tick_job, .name = "tick" },
+};
+
+const struct cyclic_table cyclic_tables[NR_CPUS] = {
+    [0] = CYCLIC_TABLE(TIMER_INTERVAL_US, tick_jobs),
+};
+#else
 void timer_handler(){
     printf("cpu%d: %s\n", get_cpuid(), __func__);
     timer_set(TIMER_INTERVAL);
-    irq_send_ipi(1ull << (get_cpuid() + 1));
+    smp_send_ipi(get_cpuid() + 1, SMP_IPI_APP);
 }
+#endif
 
 void main(void){
 
-    static volatile bool master_done = false;
+    static struct completion master_done = COMPLETION_INITVAL;
 
     if(cpu_is_master()){
         spin_lock(&print_lock);
@@ -55,27 +97,37 @@ void main(void){
         spin_unlock(&print_lock);
 
         irq_set_handler(UART_IRQ_ID, uart_rx_handler);
-        irq_set_handler(TIMER_IRQ_ID, timer_handler);
-        irq_set_handler(IPI_IRQ_ID, ipi_handler);
+        smp_ipi_register(SMP_IPI_APP, ipi_handler);
 
         uart_enable_rxirq();
 
+#ifdef SCHED
+        thread_create(&tick_thread, "tick", tick_thread_fn, NULL,
+            SCHED_PRIO_MAX, get_cpuid(), tick_stack, sizeof(tick_stack));
+#elif !defined(CYCLIC)
+        irq_set_handler(TIMER_IRQ_ID, timer_handler);
         timer_set(TIMER_INTERVAL);
         irq_enable(TIMER_IRQ_ID);
         irq_set_prio(TIMER_IRQ_ID, IRQ_MAX_PRIO);
+#endif
 
-        master_done = true;
+        complete(&master_done);
     }
 
     irq_enable(UART_IRQ_ID);
     irq_set_prio(UART_IRQ_ID, IRQ_MAX_PRIO);
-    irq_enable(IPI_IRQ_ID);
-    irq_set_prio(IPI_IRQ_ID, IRQ_MAX_PRIO);
 
-    while(!master_done);
+    completion_wait(&master_done, WAIT_FOREVER);
     spin_lock(&print_lock);
     printf("cpu %d up\n", get_cpuid());
     spin_unlock(&print_lock);
 
-    while(1) wfi();
+#ifdef CYCLIC
+    cyclic_run();
+#elif defined(JOBS)
+    /* Idle cpus serve the job system */
+    jobs_serve(NULL);
+#else
+    while(1) cpu_idle();
+#endif
 }
@@ -8,6 +8,7 @@
 #define PLAT_GICR_BASE_ADDR (0x2F100000)
 
 #define PLAT_UART_ADDR 0x1c090000
+#define PLAT_UART_COMPATIBLE "arm,pl011"
 #define UART_IRQ_ID 37
 
 #endif
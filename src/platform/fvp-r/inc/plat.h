@@ -10,6 +10,7 @@
 #define PLAT_GICR_BASE_ADDR (0xAF100000)
 
 #define PLAT_UART_ADDR  0x9C0A0000
+#define PLAT_UART_COMPATIBLE "arm,pl011"
 #define UART_IRQ_ID 38
 
 #endif
@@ -7,8 +7,16 @@
 #define PLAT_GICD_BASE_ADDR (0x08000000)
 #define PLAT_GICC_BASE_ADDR (0x08010000)
 #define PLAT_GICR_BASE_ADDR (0x080A0000)
+#define PLAT_GITS_BASE_ADDR (0x08080000)
 
 #define PLAT_UART_ADDR 0x09000000
+#define PLAT_UART_COMPATIBLE "arm,pl011"
 #define UART_IRQ_ID 33
 
+/* virtio-mmio slots, the devices are added last to first */
+#define PLAT_VIRTIO_MMIO_BASE (0x0a000000)
+#define PLAT_VIRTIO_MMIO_NUM (32)
+#define PLAT_VIRTIO_MMIO_STRIDE (0x200)
+#define PLAT_VIRTIO_MMIO_IRQ (48)
+
 #endif
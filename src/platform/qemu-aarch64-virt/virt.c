@@ -1,10 +1,12 @@
 #include <plat.h>
+#include <uart.h>
 #include <pl011_uart.h>
 
 Pl011_Uart *uart  = (void*) UART_ADDR;
 
 void uart_init(void)
 {
+    uart = (void*) uart_addr;
     pl011_uart_init(uart);
     pl011_uart_enable(uart);
 
@@ -7,8 +7,21 @@
 #define PLAT_TIMER_FREQ (10000000ull) //10 MHz
 
 #define PLAT_UART_ADDR (0x10000000)
+#define PLAT_UART_COMPATIBLE "ns16550a"
 #define UART_IRQ_ID (10)
 
-#define CPU_EXT_SSTC 1
+/* ISA extensions, Sstc included, are found in the device tree */
+
+/* Supervisor APLIC and IMSIC files with -machine virt,aia=aplic-imsic */
+#define PLAT_APLIC_BASE (0x0d000000)
+#define PLAT_APLIC_NUM_SOURCES (96)
+#define PLAT_IMSIC_BASE (0x28000000)
+#define PLAT_IMSIC_NUM_IDS (255)
+
+/* virtio-mmio slots, the devices are added last to first */
+#define PLAT_VIRTIO_MMIO_BASE (0x10001000)
+#define PLAT_VIRTIO_MMIO_NUM (8)
+#define PLAT_VIRTIO_MMIO_STRIDE (0x1000)
+#define PLAT_VIRTIO_MMIO_IRQ (1)
 
 #endif
@@ -1,2 +1,4 @@
 ARCH:=riscv
-drivers:=8250_uart
\ No newline at end of file
+drivers:=8250_uart
+# IRQC=AIA with -machine virt,aia=aplic-imsic
+IRQC?=PLIC
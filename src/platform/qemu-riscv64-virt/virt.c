@@ -1,10 +1,11 @@
 #include <plat.h>
+#include <uart.h>
 #include <8250_uart.h>
 
 
 #define VIRT_UART16550_INTERRUPT	10
 
-#define VIRT_UART16550_ADDR		UART_ADDR
+#define VIRT_UART16550_ADDR		uart_addr
 
 #define VIRT_UART_BAUDRATE		115200
 #define VIRT_UART_SHIFTREG_ADDR		1843200
@@ -5,6 +5,7 @@
 #define PLAT_MEM_SIZE 0x8000000
 
 #define PLAT_UART_ADDR 0xFF000000
+#define PLAT_UART_COMPATIBLE "xlnx,xuartps"
 #define UART_IRQ_ID 53
 
 #endif
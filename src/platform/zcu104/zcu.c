@@ -1,10 +1,12 @@
 #include <plat.h>
+#include <uart.h>
 #include <zynq_uart.h>
 
 Xil_Uart *uart  = (void*) UART_ADDR;
 
 void uart_init(void)
 {
+    uart = (void*) uart_addr;
     xil_uart_init(uart);
     xil_uart_enable(uart);
 
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Reader for the shared memory console ring (SHMEM_CONSOLE_BASE builds).
+
+Follows the ring of a running QEMU guest through QMP, e.g. with QEMU started
+with "-qmp tcp:localhost:4444,server,nowait":
+
+    tools/shmlog.py --qmp localhost:4444 0x90000000
+
+or prints what is left in the ring of a memory dump (e.g. taken with the
+QEMU monitor "pmemsave 0x90000000 0x200000 dump.bin"):
+
+    tools/shmlog.py --dump dump.bin
+
+The ring layout is described in src/core/inc/shmem_console.h.
+"""
+
+import argparse
+import json
+import os
+import socket
+import struct
+import sys
+import tempfile
+import time
+
+MAGIC = 0x474C4D42
+HDR_SIZE = 64
+HDR_FMT = "<IIII"
+
+
+def parse_hdr(raw):
+    magic, size, head, notify = struct.unpack_from(HDR_FMT, raw)
+    if magic != MAGIC or size == 0 or size & (size - 1):
+        return None
+    return size, head
+
+
+def ring_bytes(read, size, start, end):
+    """Returns ring bytes in [start, end), positions taken modulo 2^32."""
+    out = b""
+    while start != end:
+        off = start % size
+        n = min(size - off, (end - start) % 2**32)
+        out += read(HDR_SIZE + off, n)
+        start = (start + n) % 2**32
+    return out
+
+
+class Qmp:
+    def __init__(self, addr, base):
+        if ":" in addr:
+            host, port = addr.rsplit(":", 1)
+            self.sock = socket.create_connection((host, int(port)))
+        else:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.connect(addr)
+        self.file = self.sock.makefile("rw")
+        self.base = base
+        fd, self.tmp = tempfile.mkstemp(prefix="shmlog")
+        os.close(fd)
+        self.file.readline()
+        self.cmd("qmp_capabilities")
+
+    def cmd(self, name, **args):
+        self.file.write(json.dumps({"execute": name, "arguments": args}) + "\n")
+        self.file.flush()
+        while True:
+            resp = json.loads(self.file.readline())
+            if "error" in resp:
+                raise RuntimeError(resp["error"].get("desc", resp))
+            if "return" in resp:
+                return resp["return"]
+
+    def read(self, off, size):
+        self.cmd("pmemsave", val=self.base + off, size=size, filename=self.tmp)
+        with open(self.tmp, "rb") as f:
+            return f.read()
+
+
+def follow(mem, interval):
+    pos = None
+    while True:
+        hdr = parse_hdr(mem.read(0, HDR_SIZE))
+        if hdr is None:
+            time.sleep(interval)
+            continue
+        size, head = hdr
+        if pos is None or (head - pos) % 2**32 > 2**31:
+            # First look at the ring or the guest restarted it
+            pos = (head - min(head, size)) % 2**32
+        avail = (head - pos) % 2**32
+        if avail > size:
+            sys.stderr.write("[shmlog: lost %d bytes]\n" % (avail - size))
+            pos = (head - size) % 2**32
+        data = ring_bytes(mem.read, size, pos, head)
+        # Drop whatever the guest may have overwritten while copying
+        _, head_after = parse_hdr(mem.read(0, HDR_SIZE)) or (size, head)
+        overrun = (head_after - pos) % 2**32 - size
+        if 0 < overrun:
+            sys.stderr.write("[shmlog: lost %d bytes]\n" % overrun)
+            data = data[overrun:]
+        sys.stdout.buffer.write(data)
+        sys.stdout.flush()
+        pos = head
+        time.sleep(interval)
+
+
+def dump(path, offset):
+    with open(path, "rb") as f:
+        f.seek(offset)
+        raw = f.read()
+    hdr = parse_hdr(raw)
+    if hdr is None:
+        sys.exit("no console ring found at offset %#x" % offset)
+    size, head = hdr
+    read = lambda off, n: raw[off:off + n]
+    sys.stdout.buffer.write(ring_bytes(read, size, (head - min(head, size)) % 2**32, head))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base", nargs="?", type=lambda x: int(x, 0), default=None,
+                        help="guest physical address of the ring (--qmp)")
+    parser.add_argument("--qmp", help="QMP socket, host:port or unix socket path")
+    parser.add_argument("--dump", help="memory dump file")
+    parser.add_argument("--offset", type=lambda x: int(x, 0), default=0,
+                        help="offset of the ring in the dump file")
+    parser.add_argument("--interval", type=float, default=0.1,
+                        help="polling interval in seconds")
+    args = parser.parse_args()
+
+    if args.dump:
+        dump(args.dump, args.offset)
+    elif args.qmp and args.base is not None:
+        mem = Qmp(args.qmp, args.base)
+        try:
+            follow(mem, args.interval)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            os.unlink(mem.tmp)
+    else:
+        parser.error("either --dump or --qmp with the ring address is needed")
+
+
+if __name__ == "__main__":
+    main()